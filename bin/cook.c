@@ -0,0 +1,414 @@
+#include "../src/audio.h"
+#include "../src/math.h"
+#include "../src/texture.h"
+#include "../src/utils.h"
+#include "raylib.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SFX_EXTENSIONS ".mp3;.wav;.ogg;.flac"
+
+// Music is streamed, so it's transcoded to QOA instead of going to the bank
+static const char *MUSIC_FILE_PATHS[] = {"resources/audio/scene.mp3"};
+static const int N_MUSIC_FILE_PATHS = sizeof(MUSIC_FILE_PATHS) / sizeof(char *);
+
+static const char *SFX_DIRS[] = {"resources/audio", "resources/items/audio"};
+static const int N_SFX_DIRS = sizeof(SFX_DIRS) / sizeof(char *);
+
+#define TEXTURE_EXTENSIONS ".png"
+
+typedef struct TextureDir {
+    const char *path;
+
+    // Sprites are trimmed and get alpha hulls. Items and UI textures are drawn
+    // on fixed quads, so they are kept as is
+    bool is_sprite;
+} TextureDir;
+
+static const TextureDir TEXTURE_DIRS[] = {
+    {"resources/golova/sprites", true},
+    {"resources/trees/sprites", true},
+    {"resources/items/sprites", false},
+    {"resources/sprites", false},
+};
+static const int N_TEXTURE_DIRS = sizeof(TEXTURE_DIRS) / sizeof(TextureDir);
+
+static bool IS_BC3;
+static int N_HULL_POINTS = DEFAULT_N_HULL_POINTS;
+
+static int N_WAVES;
+static Wave WAVES[MAX_N_BANK_SOUNDS];
+static SoundBankEntry ENTRIES[MAX_N_BANK_SOUNDS];
+
+static bool is_music_file(const char *file_path);
+static void cook_sfx_dir(const char *dir);
+static void save_sound_bank(const char *file_path);
+static void cook_music(const char *file_path);
+static void cook_texture_dir(TextureDir dir);
+static void cook_texture(const char *file_path, bool is_sprite);
+static void compress_bc3(
+    const unsigned char *pixels, int width, int height, uint8_t *dst
+);
+static void compress_bc3_block(const unsigned char *texels, uint8_t *dst);
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--bc3") == 0) {
+            IS_BC3 = true;
+        } else if (strcmp(argv[i], "--hull-points") == 0 && i + 1 < argc) {
+            N_HULL_POINTS = atoi(argv[++i]);
+        } else {
+            TraceLog(
+                LOG_ERROR,
+                "Unknown option %s, usage: cook [--bc3] [--hull-points N]",
+                argv[i]
+            );
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < N_SFX_DIRS; ++i) cook_sfx_dir(SFX_DIRS[i]);
+    save_sound_bank(SOUND_BANK_FILE_PATH);
+
+    for (int i = 0; i < N_MUSIC_FILE_PATHS; ++i) cook_music(MUSIC_FILE_PATHS[i]);
+
+    for (int i = 0; i < N_TEXTURE_DIRS; ++i) cook_texture_dir(TEXTURE_DIRS[i]);
+
+    for (int i = 0; i < N_WAVES; ++i) UnloadWave(WAVES[i]);
+    return 0;
+}
+
+static bool is_music_file(const char *file_path) {
+    for (int i = 0; i < N_MUSIC_FILE_PATHS; ++i) {
+        if (strcmp(file_path, MUSIC_FILE_PATHS[i]) == 0) return true;
+    }
+    return false;
+}
+
+static void cook_sfx_dir(const char *dir) {
+    static char file_path[2048];
+    if (!DirectoryExists(dir)) return;
+
+    int n_file_names;
+    char **file_names = get_file_names_in_dir(dir, &n_file_names);
+    for (int i = 0; i < n_file_names; ++i) {
+        sprintf(file_path, "%s/%s", dir, file_names[i]);
+        if (!IsFileExtension(file_path, SFX_EXTENSIONS) || is_music_file(file_path)) {
+            continue;
+        }
+        if (N_WAVES == MAX_N_BANK_SOUNDS) {
+            TraceLog(LOG_ERROR, "Sound bank is full, %s is skipped", file_path);
+            continue;
+        }
+        if (strlen(file_path) >= MAX_BANK_SOUND_NAME_LENGTH) {
+            TraceLog(LOG_ERROR, "Sound path %s is too long, skipped", file_path);
+            continue;
+        }
+
+        Wave wave = LoadWave(file_path);
+        if (!IsWaveReady(wave)) {
+            TraceLog(LOG_ERROR, "Failed to load %s", file_path);
+            continue;
+        }
+
+        // Resample once here, so the runtime only copies the samples
+        WaveFormat(
+            &wave, SOUND_BANK_SAMPLE_RATE, SOUND_BANK_SAMPLE_SIZE, SOUND_BANK_CHANNELS
+        );
+
+        SoundBankEntry *entry = &ENTRIES[N_WAVES];
+        memset(entry, 0, sizeof(SoundBankEntry));
+        strcpy(entry->name, file_path);
+        entry->frame_count = wave.frameCount;
+        entry->sample_rate = wave.sampleRate;
+        entry->channels = wave.channels;
+        WAVES[N_WAVES++] = wave;
+    }
+
+    for (int i = 0; i < n_file_names; ++i) free(file_names[i]);
+    free(file_names);
+}
+
+static void save_sound_bank(const char *file_path) {
+    unsigned int offset = 0;
+    for (int i = 0; i < N_WAVES; ++i) {
+        ENTRIES[i].offset = offset;
+        offset += WAVES[i].frameCount * WAVES[i].channels * SOUND_BANK_SAMPLE_SIZE / 8;
+    }
+
+    FILE *f = fopen(file_path, "wb");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "Failed to open %s for writing", file_path);
+        exit(1);
+    }
+
+    fwrite(SOUND_BANK_MAGIC, 4, 1, f);
+    fwrite(&N_WAVES, sizeof(int), 1, f);
+    fwrite(ENTRIES, sizeof(SoundBankEntry), N_WAVES, f);
+    for (int i = 0; i < N_WAVES; ++i) {
+        int size = WAVES[i].frameCount * WAVES[i].channels * SOUND_BANK_SAMPLE_SIZE / 8;
+        fwrite(WAVES[i].data, size, 1, f);
+    }
+
+    fclose(f);
+    TraceLog(
+        LOG_INFO, "Sound bank %s saved: %d sounds, %u bytes", file_path, N_WAVES, offset
+    );
+}
+
+static void cook_music(const char *file_path) {
+    static char cooked_path[2048];
+
+    if (!FileExists(file_path)) {
+        TraceLog(LOG_WARNING, "Music %s not found, skipped", file_path);
+        return;
+    }
+
+    Wave wave = LoadWave(file_path);
+    if (!IsWaveReady(wave)) {
+        TraceLog(LOG_ERROR, "Failed to load %s", file_path);
+        return;
+    }
+
+    // QOA stores 16-bit samples only
+    WaveFormat(&wave, SOUND_BANK_SAMPLE_RATE, 16, SOUND_BANK_CHANNELS);
+    get_cooked_music_path(cooked_path, file_path);
+    if (!ExportWave(wave, cooked_path)) {
+        TraceLog(LOG_ERROR, "Failed to export %s", cooked_path);
+    }
+    UnloadWave(wave);
+}
+
+static void cook_texture_dir(TextureDir dir) {
+    static char file_path[2048];
+    if (!DirectoryExists(dir.path)) return;
+
+    int n_file_names;
+    char **file_names = get_file_names_in_dir(dir.path, &n_file_names);
+    for (int i = 0; i < n_file_names; ++i) {
+        sprintf(file_path, "%s/%s", dir.path, file_names[i]);
+        if (IsFileExtension(file_path, TEXTURE_EXTENSIONS)) {
+            cook_texture(file_path, dir.is_sprite);
+        }
+    }
+
+    for (int i = 0; i < n_file_names; ++i) free(file_names[i]);
+    free(file_names);
+}
+
+static void cook_texture(const char *file_path, bool is_sprite) {
+    static char cooked_path[2048];
+
+    Image image = LoadImage(file_path);
+    if (!IsImageReady(image)) {
+        TraceLog(LOG_ERROR, "Failed to load %s", file_path);
+        return;
+    }
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    TextureFileHeader header = {0};
+    memcpy(header.magic, TEXTURE_FILE_MAGIC, 4);
+    header.source_width = image.width;
+    header.source_height = image.height;
+
+    // Trim fully transparent borders
+    if (is_sprite) {
+        Rectangle crop = GetImageAlphaBorder(image, 0.0);
+        if (crop.width > 0 && crop.height > 0) {
+            header.crop_x = crop.x;
+            header.crop_y = crop.y;
+            ImageCrop(&image, crop);
+        }
+    }
+
+    // Blocks are 4x4, so the image is padded with transparent pixels
+    if (IS_BC3) {
+        int width = (image.width + 3) / 4 * 4;
+        int height = (image.height + 3) / 4 * 4;
+        ImageResizeCanvas(&image, width, height, 0, 0, BLANK);
+    }
+    header.width = image.width;
+    header.height = image.height;
+    if (is_sprite) {
+        header.n_hull_points = compute_alpha_hull(
+            image, N_HULL_POINTS, header.hull_points
+        );
+    }
+
+    // Every BC3 mip level must consist of whole blocks
+    header.n_mipmaps = 1;
+    while (true) {
+        int width = image.width >> header.n_mipmaps;
+        int height = image.height >> header.n_mipmaps;
+        if (width < 1 && height < 1) break;
+        if (IS_BC3 && (width % 4 != 0 || height % 4 != 0)) break;
+        header.n_mipmaps += 1;
+    }
+
+    header.format = IS_BC3 ? PIXELFORMAT_COMPRESSED_DXT5_RGBA
+                           : PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    for (int i = 0; i < header.n_mipmaps; ++i) {
+        int width = MAX(1, image.width >> i);
+        int height = MAX(1, image.height >> i);
+        header.data_size += IS_BC3 ? width * height : width * height * 4;
+    }
+
+    uint8_t *data = malloc(header.data_size);
+    uint8_t *level_data = data;
+    for (int i = 0; i < header.n_mipmaps; ++i) {
+        Image level = ImageCopy(image);
+        ImageResize(&level, MAX(1, image.width >> i), MAX(1, image.height >> i));
+
+        if (IS_BC3) {
+            compress_bc3(level.data, level.width, level.height, level_data);
+            level_data += level.width * level.height;
+        } else {
+            memcpy(level_data, level.data, level.width * level.height * 4);
+            level_data += level.width * level.height * 4;
+        }
+        UnloadImage(level);
+    }
+
+    get_cooked_texture_path(cooked_path, file_path);
+    FILE *f = fopen(cooked_path, "wb");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "Failed to open %s for writing", cooked_path);
+    } else {
+        fwrite(&header, sizeof(header), 1, f);
+        fwrite(data, header.data_size, 1, f);
+        fclose(f);
+        TraceLog(
+            LOG_INFO,
+            "Texture %s cooked: %dx%d of %dx%d, %d mipmaps, %d hull points, %d bytes",
+            cooked_path,
+            header.width,
+            header.height,
+            header.source_width,
+            header.source_height,
+            header.n_mipmaps,
+            header.n_hull_points,
+            header.data_size
+        );
+    }
+
+    free(data);
+    UnloadImage(image);
+}
+
+static void compress_bc3(
+    const unsigned char *pixels, int width, int height, uint8_t *dst
+) {
+    unsigned char texels[16 * 4];
+    for (int by = 0; by < height; by += 4) {
+        for (int bx = 0; bx < width; bx += 4) {
+            for (int y = 0; y < 4; ++y) {
+                const unsigned char *row = pixels + ((by + y) * width + bx) * 4;
+                memcpy(&texels[y * 16], row, 16);
+            }
+            compress_bc3_block(texels, dst);
+            dst += 16;
+        }
+    }
+}
+
+static uint16_t pack_rgb565(int r, int g, int b) {
+    r = (r * 31 + 127) / 255;
+    g = (g * 63 + 127) / 255;
+    b = (b * 31 + 127) / 255;
+    return r << 11 | g << 5 | b;
+}
+
+static void unpack_rgb565(uint16_t c, int *rgb) {
+    rgb[0] = (c >> 11 & 31) * 255 / 31;
+    rgb[1] = (c >> 5 & 63) * 255 / 63;
+    rgb[2] = (c & 31) * 255 / 31;
+}
+
+// Range fit: endpoints are the (slightly inset) bounds of the block colors.
+// Fast and good enough for sprites
+static void compress_bc3_block(const unsigned char *texels, uint8_t *dst) {
+    // -------------------------------------------------------------------
+    // Alpha, 8 interpolated values between the min and max alpha
+    int a_min = 255;
+    int a_max = 0;
+    for (int i = 0; i < 16; ++i) {
+        a_min = MIN(a_min, texels[i * 4 + 3]);
+        a_max = MAX(a_max, texels[i * 4 + 3]);
+    }
+
+    int alphas[8] = {a_max, a_min};
+    for (int k = 1; k < 7; ++k) alphas[k + 1] = ((7 - k) * a_max + k * a_min + 3) / 7;
+
+    uint64_t alpha_bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0;
+        for (int k = 1; k < 8; ++k) {
+            int a = texels[i * 4 + 3];
+            if (abs(alphas[k] - a) < abs(alphas[best] - a)) best = k;
+        }
+        alpha_bits |= (uint64_t)best << (3 * i);
+    }
+
+    dst[0] = a_max;
+    dst[1] = a_min;
+    for (int i = 0; i < 6; ++i) dst[2 + i] = alpha_bits >> (8 * i);
+
+    // -------------------------------------------------------------------
+    // Color, colors of fully transparent texels don't matter
+    int c_min[3] = {255, 255, 255};
+    int c_max[3] = {0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        if (texels[i * 4 + 3] == 0 && a_max > 0) continue;
+        for (int j = 0; j < 3; ++j) {
+            c_min[j] = MIN(c_min[j], texels[i * 4 + j]);
+            c_max[j] = MAX(c_max[j], texels[i * 4 + j]);
+        }
+    }
+    for (int j = 0; j < 3; ++j) {
+        int inset = (c_max[j] - c_min[j]) / 16;
+        c_min[j] += inset;
+        c_max[j] -= inset;
+    }
+
+    uint16_t c0 = pack_rgb565(c_max[0], c_max[1], c_max[2]);
+    uint16_t c1 = pack_rgb565(c_min[0], c_min[1], c_min[2]);
+    if (c0 < c1) {
+        uint16_t c = c0;
+        c0 = c1;
+        c1 = c;
+    }
+
+    int colors[4][3];
+    unpack_rgb565(c0, colors[0]);
+    unpack_rgb565(c1, colors[1]);
+    for (int j = 0; j < 3; ++j) {
+        colors[2][j] = (2 * colors[0][j] + colors[1][j]) / 3;
+        colors[3][j] = (colors[0][j] + 2 * colors[1][j]) / 3;
+    }
+
+    uint32_t color_bits = 0;
+    for (int i = 0; i < 16 && c0 != c1; ++i) {
+        int best = 0;
+        int best_dist = 1 << 30;
+        for (int k = 0; k < 4; ++k) {
+            int dist = 0;
+            for (int j = 0; j < 3; ++j) {
+                int d = colors[k][j] - texels[i * 4 + j];
+                dist += d * d;
+            }
+            if (dist < best_dist) {
+                best = k;
+                best_dist = dist;
+            }
+        }
+        color_bits |= (uint32_t)best << (2 * i);
+    }
+
+    dst[8] = c0 & 0xff;
+    dst[9] = c0 >> 8;
+    dst[10] = c1 & 0xff;
+    dst[11] = c1 >> 8;
+    for (int i = 0; i < 4; ++i) dst[12 + i] = color_bits >> (8 * i);
+}
@@ -1,5 +1,17 @@
+#include "../src/assets.h"
+#include "../src/audio.h"
+#include "../src/hot_reload.h"
+#include "../src/jobs.h"
 #include "../src/math.h"
+#include "../src/postfx.h"
+#include "../src/profiler.h"
+#include "../src/render_stats.h"
+#include "../src/resources.h"
 #include "../src/scene.h"
+#include "../src/texture.h"
+#include "../src/texture_stream.h"
+#include "../src/trace.h"
+#include "../src/ui_text.h"
 #include "../src/utils.h"
 #include "raylib.h"
 #include "raymath.h"
@@ -15,6 +27,9 @@
 
 #if defined(PLATFORM_DESKTOP) && defined(DEBUG)
 #define DRAW_IMGUI
+#define HOT_RELOAD
+#define MEASURE_LATENCY
+#define TRACE_STARTUP
 #endif
 
 #ifdef DRAW_IMGUI
@@ -28,6 +43,8 @@
 // #define SCREEN_WIDTH 2560
 // #define SCREEN_HEIGHT 1440
 
+#define MAX_N_LATENCY_SAMPLES 120
+
 #define EYES_SPEED 0.08
 
 typedef enum GameState {
@@ -48,6 +65,7 @@ typedef struct Options {
     bool with_music;
     bool with_sound;
     bool with_shadows;
+    ShadowQuality shadow_quality;
 } Options;
 
 typedef enum Pivot {
@@ -69,8 +87,58 @@ typedef struct SoundsRoulette {
     int n;
     int i;
     Sound sounds[MAX_N_SOUNDS];
+
+    // Read by the startup job, uploaded on the main thread
+    char paths[MAX_N_SOUNDS][MAX_PATH_LENGTH];
+    SoundData data[MAX_N_SOUNDS];
 } SoundsRoulette;
 
+#define MAX_N_FRAME_SOUNDS 16
+typedef struct FrameSound {
+    Sound sound;
+    SoundCategory category;
+} FrameSound;
+
+// Everything a frame is drawn from. The simulation of the next frame fills one
+// snapshot while the other one is drawn, so drawing never reads the game state
+typedef struct FrameSnapshot {
+    SceneSnapshot scene;
+    GameState game_state;
+    PauseState pause_state;
+    Options options;
+    PostfxStack postfx;
+    bool is_golova_happy;
+    const char *rule;
+    int scene_id;
+    float time;
+
+    // When the input the items are drawn for was sampled
+    float input_time;
+
+    int n_hits_required;
+    int n_dead_correct_items;
+    Texture2D dead_correct_textures[2 * MAX_N_BOARD_ITEMS];
+
+    // Played when the frame is drawn, so they are heard with what caused them.
+    // A frame can be presented twice, its sounds are played only the first time
+    int n_sounds;
+    FrameSound sounds[MAX_N_FRAME_SOUNDS];
+    bool is_sounds_played;
+
+    // Not set when the simulation switched the scene and captured nothing
+    bool is_captured;
+} FrameSnapshot;
+
+// Ggui clicks, applied to the game state after the simulation is finished
+typedef struct UiActions {
+    bool is_resume;
+    bool is_options;
+    bool is_exit;
+    bool is_next_scene;
+    bool is_options_changed;
+    Options options;
+} UiActions;
+
 #define PAUSE_STATE_TO_NAME(state) \
     ((state == NOT_PAUSED)      ? "NOT_PAUSED" \
      : (state == MAIN_PAUSE)    ? "MAIN_PAUSE" \
@@ -92,9 +160,10 @@ static char *SCENES_DIR = "resources/scenes";
 static int CURR_SCENE_ID;
 static char **SCENE_FILE_NAMES;
 static int N_SCENES;
+static bool IS_SCENE_LOADED;
 
 static Texture2D TEXTURE_QUESTION_MARK;
-static Music SCENE_MUSIC;
+static bool IS_MUSIC_PAUSED;
 static SoundsRoulette TOUCH_SOUNDS;
 static SoundsRoulette WRONG_SOUNDS;
 static SoundsRoulette CORRECT_SOUNDS;
@@ -105,7 +174,11 @@ static PauseState PAUSE_STATE;
 static PauseState NEXT_PAUSE_STATE;
 static GameState GAME_STATE;
 static GameState NEXT_GAME_STATE;
-static Options OPTIONS = {.with_music = true, .with_sound = true, .with_shadows = true};
+static Options OPTIONS = {
+    .with_music = true,
+    .with_sound = true,
+    .with_shadows = true,
+    .shadow_quality = SHADOWS_MEDIUM};
 static float TIME_REMAINING;
 static bool IS_NEXT_SCENE;
 static bool IS_EXIT_GAME;
@@ -125,57 +198,133 @@ static bool IS_LMB_PRESSED;
 static bool IS_ALTF4_PRESSED;
 static Ray MOUSE_RAY;
 
-static Item *PICKED_ITEM;
+// Board item indices
+static int PICKED_ITEM = -1;
 
 static int N_DEAD_CORRECT_ITEMS;
-static Item *DEAD_CORRECT_ITEMS[MAX_N_BOARD_ITEMS];
+static int DEAD_CORRECT_ITEMS[MAX_N_BOARD_ITEMS];
 
 static int N_DEAD_WRONG_ITEMS;
-static Item *DEAD_WRONG_ITEMS[MAX_N_BOARD_ITEMS];
+static int DEAD_WRONG_ITEMS[MAX_N_BOARD_ITEMS];
+
+// The items of the drawn frame are updated with the newest input. Only the
+// pipelined frames are latched, the others are simulated with it already
+static bool IS_LATE_LATCH = true;
+static unsigned long N_LATCHED_FRAMES;
+
+#ifdef MEASURE_LATENCY
+// Input to submit latency of the last frames, in seconds. Sampled before
+// EndDrawing, so the last batch flush and the buffer swap aren't included
+static int N_LATENCY_SAMPLES;
+static float LATENCY_SAMPLES[MAX_N_LATENCY_SAMPLES];
+#endif
+
+static FrameSnapshot SNAPSHOTS[2];
+static unsigned long FRAME_ID;
+static bool IS_DRAW_SNAPSHOT_READY;
+
+// Frames drawn while the next one was simulated, and frames which waited for the
+// simulation. With workers only the first frame of a scene waits
+static unsigned long N_PIPELINED_FRAMES;
+static unsigned long N_STALLED_FRAMES;
+static bool IS_PREV_FRAME_STALLED;
+
+static Vector3 TREES_PIVOTS[MAX_N_FOREST_TREES];
+static Vector3 TREES_SWAYED_PIVOTS[MAX_N_FOREST_TREES];
 
 static float EYES_TARGET_SHIFT;
 static float EYES_TARGET_UPLIFT;
 
-static SoundsRoulette load_sounds_roulette(char *prefix);
-static void play_sound_roulette(SoundsRoulette *sounds);
+static void read_startup_sounds(void *data);
+static void read_sounds_roulette(
+    SoundsRoulette *sounds, const char *prefix, char **file_names, int n_file_names
+);
+static void upload_sounds_roulette(SoundsRoulette *sounds);
+static void play_sound_roulette(SoundsRoulette *sounds, SoundCategory category);
+static void queue_frame_sound(Sound sound, SoundCategory category);
+static const char *get_scene_file_path(int scene_id);
 static void load_curr_scene(void);
+static void draw_loading(void);
+static PostfxStack get_postfx_stack(bool is_blured, float flash_strength);
+#ifdef HOT_RELOAD
+static void update_hot_reload(void);
+#endif
 static void main_update(void);
-static void update_game(void);
-static void draw_ggui(void);
+static void sample_input(void);
+static void simulate_frame(void *data);
+static bool update_game(void);
+static bool update_item_states(
+    ItemState *states, const Matrix *matrices, int n_items, Ray ray, int *picked_item
+);
+static void latch_item_states(FrameSnapshot *snapshot);
+static void capture_frame_snapshot(FrameSnapshot *snapshot);
+static UiActions draw_frame(const FrameSnapshot *snapshot, JobCounter *counter);
+static void apply_ui_actions(UiActions actions);
+static UiActions draw_ggui(const FrameSnapshot *snapshot);
 static void draw_imgui(void);
 
 static bool ggui_button(Position pos, const char *text, int font_size);
-static void ggui_checkbox(Position pos, bool *is_checked);
+static bool ggui_checkbox(Position pos, bool *is_checked);
 static Rectangle ggui_get_rec(Position pos, int width, int height);
 static void ggui_text(Position pos, const char *text, int font_size, Color color);
 
+static void update_trees_sway(int begin, int end, void *data);
 static void update_value(float dt, float speed, float *target, float *curr);
 static void update_value2(
     float dt, float speed, float target_x, float target_y, float *curr_x, float *curr_y
 );
 
 int main(void) {
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Golova");
-    init_core(SCREEN_WIDTH, SCREEN_HEIGHT);
-    SCREEN = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+    init_trace();
+    double time = get_trace_time();
+    init_jobs(DEFAULT_N_JOB_WORKERS);
+    add_trace_event("init_jobs", time);
+
+    // Files are read and decoded by the workers while the window and the audio
+    // device are initialized, the main thread then only uploads them
+    JobCounter counter = {0};
+    request_core_assets();
+    run_job(read_startup_sounds, NULL, &counter);
+
+    // The first scene is loaded by the main loop once its assets are fetched
     SCENE_FILE_NAMES = get_file_names_in_dir(SCENES_DIR, &N_SCENES);
-    TEXTURE_QUESTION_MARK = LoadTexture("resources/sprites/question.png");
+    request_scene_assets(get_scene_file_path(CURR_SCENE_ID));
+
+    time = get_trace_time();
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Golova");
+    add_trace_event("init_window", time);
 
-    // Init audio and play main theme
+    time = get_trace_time();
     InitAudioDevice();
-    SCENE_MUSIC = LoadMusicStream("resources/audio/scene.mp3");
-    PlayMusicStream(SCENE_MUSIC);
+    add_trace_event("init_audio_device", time);
 
-    // Load touch sounds
-    TOUCH_SOUNDS = load_sounds_roulette("touch");
-    WRONG_SOUNDS = load_sounds_roulette("wrong");
-    CORRECT_SOUNDS = load_sounds_roulette("correct");
+    init_core(SCREEN_WIDTH, SCREEN_HEIGHT);
+    SCREEN = track_render_texture(
+        LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT), "screen"
+    );
+
+    set_resource_owner(OWNER_UI);
+    TEXTURE_QUESTION_MARK = load_texture("resources/sprites/question.png");
+
+    time = get_trace_time();
+    wait_job_counter(&counter);
+    upload_sounds_roulette(&TOUCH_SOUNDS);
+    upload_sounds_roulette(&WRONG_SOUNDS);
+    upload_sounds_roulette(&CORRECT_SOUNDS);
+    add_trace_event("upload_sounds", time);
+
+    // Play main theme
+    init_voice_pool(DEFAULT_N_VOICES);
+    init_music_feeder(load_music("resources/audio/scene.mp3"));
+    push_music_command(MUSIC_PLAY, 0.0);
 
 #ifdef DRAW_IMGUI
     load_imgui();
 #endif
 
-    load_curr_scene();
+#ifdef HOT_RELOAD
+    init_hot_reload("resources");
+#endif
 
 #if defined(PLATFORM_WEB)
     emscripten_set_main_loop(main_update, 0, 1);
@@ -184,55 +333,392 @@ int main(void) {
     while (!IS_EXIT_GAME) {
         main_update();
     }
+    unload_music_feeder();
+    unload_texture_streams();
+    unload_postfx();
+    unload_jobs();
+#ifdef HOT_RELOAD
+    unload_hot_reload();
+#endif
 #endif
 
     return 0;
 }
 
 static void main_update(void) {
-    update_game();
+    PROFILE_FRAME();
+    update_main_thread_jobs();
+    update_texture_streams();
+#ifdef HOT_RELOAD
+    update_hot_reload();
+#endif
 
-    if (GAME_STATE == INTRO) {
-        draw_scene(SCREEN, BLACK, SCENE.camera, OPTIONS.with_shadows, true, false, true);
+    if (OPTIONS.with_music == IS_MUSIC_PAUSED) {
+        IS_MUSIC_PAUSED = !OPTIONS.with_music;
+        push_music_command(IS_MUSIC_PAUSED ? MUSIC_PAUSE : MUSIC_RESUME, 0.0);
+    }
+    update_music_feeder();
+
+    if (!IS_SCENE_LOADED) {
+        if (!is_scene_assets_ready(get_scene_file_path(CURR_SCENE_ID))) {
+            draw_loading();
+            return;
+        }
+        double time = get_trace_time();
+        load_curr_scene();
+        add_trace_event("load_scene", time);
+        IS_SCENE_LOADED = true;
+
+        // The snapshots refer to the textures of the previous scene
+        IS_DRAW_SNAPSHOT_READY = false;
+    }
+
+    sample_input();
+
+    // The next frame is simulated by a job while the previous one is drawn on the
+    // main thread. Without workers, or when there is no previous frame yet, the
+    // simulated frame is drawn right away, without the extra frame of latency.
+    // After such a frame the snapshot to draw is the one drawn last, it's
+    // presented again while the simulation refills the pipeline
+    FrameSnapshot *sim_snapshot = &SNAPSHOTS[FRAME_ID % 2];
+    FrameSnapshot *draw_snapshot = &SNAPSHOTS[(FRAME_ID + 1) % 2];
+    JobCounter counter = {0};
+    run_job(simulate_frame, sim_snapshot, &counter);
+
+    int n_workers = get_job_stats().n_workers;
+    if (!IS_DRAW_SNAPSHOT_READY || n_workers == 0) {
+        PROFILE_BEGIN(wait_simulation);
+        wait_job_counter(&counter);
+        PROFILE_END(wait_simulation);
+        draw_snapshot = sim_snapshot;
+
+        // With workers, only the first frame after a load waits, the next one
+        // draws the snapshot of this one
+        if (n_workers > 0 && IS_PREV_FRAME_STALLED) {
+            TraceLog(LOG_WARNING, "GOLOVA: Frame %lu waited again", FRAME_ID);
+        }
+        IS_PREV_FRAME_STALLED = true;
+        N_STALLED_FRAMES += 1;
     } else {
-        draw_scene(SCREEN, BLACK, SCENE.camera, OPTIONS.with_shadows, true, true, true);
+        IS_PREV_FRAME_STALLED = false;
+        N_PIPELINED_FRAMES += 1;
     }
 
+    // The simulation switched the scene and captured nothing, the loading
+    // screen is shown until the next scene is there
+    UiActions actions = {0};
+    if (!draw_snapshot->is_captured) {
+        draw_loading();
+    } else {
+        if (IS_LATE_LATCH && draw_snapshot != sim_snapshot) {
+            latch_item_states(draw_snapshot);
+            N_LATCHED_FRAMES += 1;
+        }
+        PROFILE_BEGIN(draw_frame);
+        actions = draw_frame(draw_snapshot, &counter);
+        PROFILE_END(draw_frame);
+        draw_snapshot->is_sounds_played = true;
+    }
+
+    // The simulation of the next frame is still running if it is slower
+    PROFILE_BEGIN(wait_next_simulation);
+    wait_job_counter(&counter);
+    PROFILE_END(wait_next_simulation);
+    apply_ui_actions(actions);
+
+    FRAME_ID += 1;
+    IS_DRAW_SNAPSHOT_READY = true;
+}
+
+// Input is sampled on the main thread as late as possible, right before the
+// simulation starts. The ui of the drawn frame reads the same samples
+static void sample_input(void) {
+    DT = GetFrameTime();
+    TIME = GetTime();
+    MOUSE_POSITION = GetMousePosition();
+    IS_ESCAPE_PRESSED = IsKeyPressed(KEY_ESCAPE);
+    IS_SPACE_PRESSED = IsKeyPressed(KEY_SPACE);
+    IS_LMB_PRESSED = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    IS_ALTF4_PRESSED = IsKeyDown(KEY_LEFT_ALT) && IsKeyPressed(KEY_F4);
+    MOUSE_RAY = GetMouseRay(MOUSE_POSITION, SCENE.camera);
+    IS_ANY_KEY_PRESSED = GetKeyPressed() != 0 || IS_LMB_PRESSED;
+
+#if !defined(PLATFORM_WEB)
+    if ((WindowShouldClose() || IS_ALTF4_PRESSED) && !IS_ESCAPE_PRESSED) {
+        IS_EXIT_GAME = true;
+    }
+#endif
+}
+
+static void simulate_frame(void *data) {
+    FrameSnapshot *snapshot = data;
+    snapshot->n_sounds = 0;
+    snapshot->is_sounds_played = false;
+
+    PROFILE_BEGIN(update_game);
+    snapshot->is_captured = update_game();
+    PROFILE_END(update_game);
+    if (!snapshot->is_captured) return;
+
+    PROFILE_BEGIN(capture_frame_snapshot);
+    capture_frame_snapshot(snapshot);
+    PROFILE_END(capture_frame_snapshot);
+}
+
+// Hovers and clicks items with the ray. Returns true if an item was picked
+static bool update_item_states(
+    ItemState *states, const Matrix *matrices, int n_items, Ray ray, int *picked_item
+) {
+    bool is_picked = false;
+    bool is_hit_any = false;
+    for (int i = 0; i < n_items; ++i) {
+        // Don't update dead items
+        if (states[i] == ITEM_DEAD) continue;
+
+        // Collide mouse and item meshes
+        RayCollision collision = GetRayCollisionMesh(
+            ray, SCENE.board.item_mesh, matrices[i]
+        );
+
+        bool is_hit = collision.hit;
+        is_hit_any |= is_hit;
+        if (is_hit && IS_LMB_PRESSED) {
+            // Unpick previous item and pick the new one
+            if (*picked_item != -1 && *picked_item != i) {
+                states[*picked_item] = ITEM_COLD;
+                *picked_item = i;
+                states[*picked_item] = ITEM_ACTIVE;
+                is_picked = true;
+                // Unpick the item
+            } else if (*picked_item != -1) {
+                states[*picked_item] = ITEM_COLD;
+                *picked_item = -1;
+                // Pick the item
+            } else {
+                *picked_item = i;
+                states[*picked_item] = ITEM_ACTIVE;
+                is_picked = true;
+            }
+        } else if (is_hit) {
+            // Heat up (or stay active) the item
+            states[i] = MAX(states[i], ITEM_HOT);
+        } else if (states[i] == ITEM_HOT) {
+            // Cool down the hot item
+            states[i] = ITEM_COLD;
+        }
+    }
+
+    // Unpick when clicked on empty space
+    if (!is_hit_any && IS_LMB_PRESSED && *picked_item != -1) {
+        states[*picked_item] = ITEM_COLD;
+        *picked_item = -1;
+    }
+
+    return is_picked;
+}
+
+// The drawn snapshot was simulated from the input of the previous frame. Its
+// items are hovered and clicked again with this frame input right before they
+// are drawn, the simulation of this frame reaches the same states
+static void latch_item_states(FrameSnapshot *snapshot) {
+    if (snapshot->game_state != PLAYER_IS_PICKING) return;
+    if (snapshot->pause_state != NOT_PAUSED) return;
+
+    SceneSnapshot *scene = &snapshot->scene;
+    int picked_item = -1;
+    for (int i = 0; i < scene->n_items; ++i) {
+        if (scene->item_states[i] == ITEM_ACTIVE) picked_item = i;
+    }
+
+    Ray ray = GetMouseRay(MOUSE_POSITION, scene->camera);
+    update_item_states(
+        scene->item_states, scene->item_matrices, scene->n_items, ray, &picked_item
+    );
+    snapshot->input_time = TIME;
+}
+
+static void capture_frame_snapshot(FrameSnapshot *snapshot) {
+    capture_scene_snapshot(&snapshot->scene);
+
+    snapshot->game_state = GAME_STATE;
+    snapshot->pause_state = PAUSE_STATE;
+    snapshot->options = OPTIONS;
+    // Wrong picks flash red while the camera shakes
+    float flash_strength = 0.5 * MAX(CAMERA_SHAKING_TIME, 0.0);
+    snapshot->postfx = get_postfx_stack(IS_BLURED, flash_strength);
+    snapshot->is_golova_happy = SCENE.board.n_misses_allowed >= 0;
+    snapshot->rule = SCENE.board.rule;
+    snapshot->scene_id = CURR_SCENE_ID;
+    snapshot->time = TIME;
+    snapshot->input_time = TIME;
+    snapshot->n_hits_required = SCENE.board.n_hits_required;
+
+    // Hint items are shown as already eaten
+    Board *b = &SCENE.board;
+    int n = 0;
+    for (int i = 0; i < b->n_hint_items; ++i) {
+        snapshot->dead_correct_textures[n++] = b->hint_items[i].texture;
+    }
+    for (int i = 0; i < N_DEAD_CORRECT_ITEMS; ++i) {
+        snapshot->dead_correct_textures[n++] = b->item_textures[DEAD_CORRECT_ITEMS[i]];
+    }
+    snapshot->n_dead_correct_items = n;
+}
+
+static UiActions draw_frame(const FrameSnapshot *snapshot, JobCounter *counter) {
+    for (int i = 0; i < snapshot->n_sounds && !snapshot->is_sounds_played; ++i) {
+        play_voice(snapshot->sounds[i].sound, snapshot->sounds[i].category);
+    }
+
+    bool with_items = snapshot->game_state != INTRO;
+    Options options = snapshot->options;
+    ShadowQuality shadows = options.with_shadows ? options.shadow_quality : SHADOWS_OFF;
+    const SceneSnapshot *scene = &snapshot->scene;
+    draw_scene(scene, SCREEN, BLACK, scene->camera, shadows, true, with_items);
+
     // Draw postfx and ui
+    prepare_postfx(&snapshot->postfx, SCREEN.texture);
     BeginDrawing();
-    draw_postfx(SCREEN.texture, IS_BLURED);
-    draw_ggui();
+    draw_postfx(&snapshot->postfx, SCREEN.texture);
+    RenderPass pass = set_render_pass(RENDER_PASS_UI);
+    UiActions actions = draw_ggui(snapshot);
+    set_render_pass(pass);
+
+#ifdef DRAW_IMGUI
+    // Debug info reads the game state directly
+    wait_job_counter(counter);
+#endif
     draw_imgui();
+
+#ifdef MEASURE_LATENCY
+    // Raylib waits for the frame cap inside EndDrawing, after the swap, so a
+    // sample after it would count the wait as latency
+    float latency = GetTime() - snapshot->input_time;
+    LATENCY_SAMPLES[N_LATENCY_SAMPLES++ % MAX_N_LATENCY_SAMPLES] = latency;
+#endif
     EndDrawing();
+    end_render_frame();
+
+    mark_first_frame();
+#ifdef TRACE_STARTUP
+    static bool is_trace_saved = false;
+    if (!is_trace_saved) {
+        add_trace_event("time_to_interactive", 0.0);
+        TraceLog(LOG_INFO, "TRACE: Interactive after %.1f ms", get_trace_time());
+        is_trace_saved = save_trace("startup_trace.json");
+    }
+#endif
+    return actions;
+}
+
+// Clicks on the drawn frame take effect on the next simulated one
+static void apply_ui_actions(UiActions actions) {
+    if (actions.is_resume) NEXT_PAUSE_STATE = NOT_PAUSED;
+    if (actions.is_options) NEXT_PAUSE_STATE = OPTIONS_PAUSE;
+    if (actions.is_exit) IS_EXIT_GAME = true;
+    if (actions.is_next_scene) IS_NEXT_SCENE = true;
+    if (actions.is_options_changed) OPTIONS = actions.options;
 }
 
-static SoundsRoulette load_sounds_roulette(char *prefix) {
-    SoundsRoulette sounds = {0};
+#ifdef HOT_RELOAD
+// Runs between frames, when the simulation job is not running
+static void update_hot_reload(void) {
+    static char paths[MAX_N_CHANGED_FILES][MAX_PATH_LENGTH];
+    int n_paths = poll_changed_files(paths, MAX_N_CHANGED_FILES);
+    for (int i = 0; i < n_paths; ++i) {
+        // The game state refers to the scene items, so the scene is restarted
+        if (strcmp(paths[i], get_scene_file_path(CURR_SCENE_ID)) == 0) {
+            IS_SCENE_LOADED = false;
+        } else if (reload_scene_file(paths[i])) {
+            // The snapshot to draw refers to the unloaded resources
+            IS_DRAW_SNAPSHOT_READY = false;
+        }
+    }
+}
+#endif
+
+static void draw_loading(void) {
+    int font_size = 40;
+    Position pos = {SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, CENTER_CENTER};
+
+    // Keep the last frame of the previous scene under the blur
+    PostfxStack postfx = get_postfx_stack(true, 0.0);
+    prepare_postfx(&postfx, SCREEN.texture);
+    BeginDrawing();
+    ClearBackground(BLACK);
+    draw_postfx(&postfx, SCREEN.texture);
+    ggui_text(pos, "Loading...", font_size, WHITE);
+    EndDrawing();
+    end_render_frame();
+}
+
+// Disabled effects keep their places, so the enabled ones are always applied
+// in the same order
+static PostfxStack get_postfx_stack(bool is_blured, float flash_strength) {
+    PostfxStack stack = {0};
+    add_postfx_effect(&stack, POSTFX_BLUR, 0.0, BLANK)->is_enabled = is_blured;
+    add_postfx_effect(&stack, POSTFX_DIM, 0.4, BLANK)->is_enabled = is_blured;
+    PostfxEffect *flash = add_postfx_effect(&stack, POSTFX_FLASH, flash_strength, RED);
+    flash->is_enabled = flash_strength > 0.0;
+    return stack;
+}
+
+// Runs as a job, before the audio device is initialized
+static void read_startup_sounds(void *data) {
+    double time = get_trace_time();
+    load_sound_bank(SOUND_BANK_FILE_PATH);
 
     int n_file_names;
     char **file_names = get_file_names_in_dir("resources/audio", &n_file_names);
+    read_sounds_roulette(&TOUCH_SOUNDS, "touch", file_names, n_file_names);
+    read_sounds_roulette(&WRONG_SOUNDS, "wrong", file_names, n_file_names);
+    read_sounds_roulette(&CORRECT_SOUNDS, "correct", file_names, n_file_names);
+
+    for (int i = 0; i < n_file_names; ++i) free(file_names[i]);
+    free(file_names);
+    add_trace_event("read_sounds", time);
+}
+
+static void read_sounds_roulette(
+    SoundsRoulette *sounds, const char *prefix, char **file_names, int n_file_names
+) {
+    *sounds = (SoundsRoulette){0};
     for (int i = 0; i < n_file_names; ++i) {
-        if (sounds.n == MAX_N_SOUNDS) break;
+        if (sounds->n == MAX_N_SOUNDS) break;
 
         char *file_name = file_names[i];
-        if (strncmp(file_name, prefix, strlen(prefix)) == 0) {
-            const char *file_path_parts[2] = {"resources/audio", file_name};
-            const char *file_path = TextJoin(file_path_parts, 2, "/");
-            sounds.sounds[sounds.n++] = LoadSound(file_path);
-        }
+        if (strncmp(file_name, prefix, strlen(prefix)) != 0) continue;
+
+        // TextJoin is not thread-safe
+        char *file_path = sounds->paths[sounds->n];
+        snprintf(file_path, MAX_PATH_LENGTH, "resources/audio/%s", file_name);
+        sounds->data[sounds->n++] = read_sound_data(file_path);
     }
+}
 
-    return sounds;
+static void upload_sounds_roulette(SoundsRoulette *sounds) {
+    for (int i = 0; i < sounds->n; ++i) {
+        sounds->sounds[i] = upload_sound_data(&sounds->data[i], sounds->paths[i]);
+    }
 }
 
-static void load_curr_scene(void) {
+static const char *get_scene_file_path(int scene_id) {
     static char fp[2048];
-    sprintf(fp, "%s/%s", SCENES_DIR, SCENE_FILE_NAMES[CURR_SCENE_ID]);
+    sprintf(fp, "%s/%s", SCENES_DIR, SCENE_FILE_NAMES[scene_id]);
+    return fp;
+}
+
+static void load_curr_scene(void) {
+    load_scene(get_scene_file_path(CURR_SCENE_ID));
 
-    load_scene(fp);
+    // Fetch the next scene in the background while this one is played
+    if (CURR_SCENE_ID < N_SCENES - 1) {
+        request_scene_assets(get_scene_file_path(CURR_SCENE_ID + 1));
+    }
 
     N_DEAD_CORRECT_ITEMS = 0;
     N_DEAD_WRONG_ITEMS = 0;
+    PICKED_ITEM = -1;
     NEXT_GAME_STATE = CURR_SCENE_ID == 0 ? INTRO : PLAYER_IS_PICKING;
     TIME_REMAINING = GAME_STATE_TO_TIME[GAME_STATE];
     DEFAULT_CAMERA = SCENE.camera;
@@ -240,34 +726,13 @@ static void load_curr_scene(void) {
     ITEMS_FALL_SPEED = 0.0;
     ITEMS_ELEVATION = 1.5;
     ITEMS_FALL_ACCELERATION = 5.0;
-
-    for (int i = 0; i < SCENE.board.n_hint_items; ++i) {
-        DEAD_CORRECT_ITEMS[N_DEAD_CORRECT_ITEMS++] = &SCENE.board.hint_items[i];
-    }
 }
 
-static void update_game(void) {
-    DT = GetFrameTime();
-    TIME = GetTime();
-    MOUSE_POSITION = GetMousePosition();
-    IS_ESCAPE_PRESSED = IsKeyPressed(KEY_ESCAPE);
-    IS_SPACE_PRESSED = IsKeyPressed(KEY_SPACE);
-    IS_LMB_PRESSED = IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
-    IS_ALTF4_PRESSED = IsKeyDown(KEY_LEFT_ALT) && IsKeyPressed(KEY_F4);
-    MOUSE_RAY = GetMouseRay(MOUSE_POSITION, SCENE.camera);
-    IS_ANY_KEY_PRESSED = GetKeyPressed() != 0 || IS_LMB_PRESSED;
-
-    if (OPTIONS.with_music) UpdateMusicStream(SCENE_MUSIC);
-
-    Matrix golova_mat = MatrixMultiply(
-        get_transform_matrix(SCENE.golova.transform), SCENE.golova.matrix
-    );
-
-#if !defined(PLATFORM_WEB)
-    if ((WindowShouldClose() || IS_ALTF4_PRESSED) && !IS_ESCAPE_PRESSED) {
-        IS_EXIT_GAME = true;
-    }
-#endif
+// Runs as a job, so it must not touch GL or the audio device. Sounds are
+// queued to the snapshot and played when it's drawn. Returns false when the
+// scene is switched, then there is nothing to capture
+static bool update_game(void) {
+    Matrix golova_mat = get_scene_node_world(NODE_GOLOVA);
 
     if (IS_ESCAPE_PRESSED && GAME_STATE != INTRO) {
         if (PAUSE_STATE == NOT_PAUSED) NEXT_PAUSE_STATE = MAIN_PAUSE;
@@ -277,7 +742,8 @@ static void update_game(void) {
     if (IS_NEXT_SCENE) {
         IS_NEXT_SCENE = false;
         CURR_SCENE_ID += 1;
-        load_curr_scene();
+        IS_SCENE_LOADED = false;
+        return false;
     }
 
     if (NEXT_GAME_STATE != GAME_STATE) {
@@ -292,6 +758,7 @@ static void update_game(void) {
 
     // -------------------------------------------------------------------
     // Update camera
+    PROFILE_BEGIN(update_camera);
     if (GAME_STATE == GOLOVA_IS_EATING) {
         float end_time = GAME_STATE_TO_TIME[GOLOVA_IS_EATING];
         float cur_time = end_time - TIME_REMAINING;
@@ -310,9 +777,11 @@ static void update_game(void) {
     } else {
         SCENE.camera.target = DEFAULT_CAMERA.target;
     }
+    PROFILE_END(update_camera);
 
     // -------------------------------------------------------------------
     // Update items
+    PROFILE_BEGIN(update_items);
     if (GAME_STATE != INTRO) {
         ITEMS_ELEVATION -= ITEMS_FALL_SPEED * DT;
         if (ITEMS_ELEVATION <= 0.0) ITEMS_ELEVATION = 0.0;
@@ -320,91 +789,73 @@ static void update_game(void) {
     }
 
     Board *b = &SCENE.board;
-    Transform t = b->transform;
-    t.scale = Vector3Scale(Vector3One(), t.scale.x);
-    Matrix board_matrix = get_transform_matrix(t);
-    float *board_matrix_f = MatrixToFloat(board_matrix);
-
-    int n_rows = sqrt(b->n_items);
-    int n_cols = ceil((float)b->n_items / n_rows);
-    for (size_t i = 0; i < b->n_items; ++i) {
-        Item *item = &b->items[i];
-
-        int i_row = i / n_cols;
-        int i_col = i % n_cols;
-
-        float z = n_rows > 1 ? (float)i_row / (n_rows - 1) - 0.5 : 0.0;
-        float x = n_cols > 1 ? (float)i_col / (n_cols - 1) - 0.5 : 0.0;
-
-        rlPushMatrix();
-        {
-            rlMultMatrixf(board_matrix_f);
-
-            // Place item on the board
-            rlScalef(b->board_scale, b->board_scale, b->board_scale);
-            rlTranslatef(x, ITEMS_ELEVATION, z);
-            rlScalef(b->item_scale, b->item_scale, b->item_scale);
-
-            // Make not cold items larger
-            if (item->state > ITEM_COLD) rlScalef(1.2, 1.2, 1.2);
-
-            float elevation_offset = 0.05 * (sinf(2.0 * TIME) + 1.0);
-            rlTranslatef(0.0, b->item_elevation + elevation_offset, 0.0);
-
-            // Rotate dying item
-            if (item->state == ITEM_DYING) rlRotatef(TIME * 360.0, 0.0, 0.0, 1.0);
-
-            rlRotatef(90.0, 1.0, 0.0, 0.0);
-
-            Matrix item_mat = rlGetMatrixTransform();
-            // Translate dying item into the mouth
-            if (item->state == ITEM_DYING) {
-                Vector3 mouth_pos = {
-                    golova_mat.m12, golova_mat.m13 - 0.2, golova_mat.m14};
-                Vector3 item_pos = {item_mat.m12, item_mat.m13, item_mat.m14};
-                Vector3 d = Vector3Scale(Vector3Subtract(mouth_pos, item_pos), 0.9);
-                float k = 1.0 - TIME_REMAINING / GAME_STATE_TO_TIME[GOLOVA_IS_EATING];
-                d = Vector3Scale(d, k);
-                item_mat = MatrixMultiply(item_mat, MatrixTranslate(d.x, d.y, d.z));
-            }
+    b->items_drop_height = ITEMS_ELEVATION;
+
+    // Items bob together, so only the grid node moves. The item locals are
+    // scaled by the item scale, the bob is scaled the same way. Not cold items
+    // add the rest of their bob to their own nodes
+    b->items_bob_height = 0.05 * (sinf(2.0 * TIME) + 1.0) * b->item_scale;
+    for (int i = 0; i < b->n_items; ++i) {
+        ItemState state = b->item_states[i];
+
+        // Rotate dying item
+        Matrix local = MatrixRotateX(DEG2RAD * 90.0);
+        if (state == ITEM_DYING) {
+            local = MatrixMultiply(local, MatrixRotateZ(DEG2RAD * TIME * 360.0));
+        }
+
+        local = MatrixMultiply(local, MatrixTranslate(0.0, b->item_elevation, 0.0));
 
-            item->matrix = item_mat;
+        // Make not cold items larger
+        float scale = b->item_scale;
+        if (state > ITEM_COLD) scale *= HOT_ITEM_SCALE;
+        local = MatrixMultiply(local, MatrixScale(scale, scale, scale));
+        if (state > ITEM_COLD) {
+            float bob_height = (HOT_ITEM_SCALE - 1.0) * b->items_bob_height;
+            local = MatrixMultiply(local, MatrixTranslate(0.0, bob_height, 0.0));
         }
-        rlPopMatrix();
+
+        set_scene_node_local(NODE_ITEMS + i, local);
+    }
+    update_scene_transforms();
+
+    for (int i = 0; i < b->n_items; ++i) {
+        Matrix item_mat = get_scene_node_world(NODE_ITEMS + i);
+
+        // Translate dying item into the mouth
+        if (b->item_states[i] == ITEM_DYING) {
+            Vector3 mouth_pos = {golova_mat.m12, golova_mat.m13 - 0.2, golova_mat.m14};
+            Vector3 item_pos = {item_mat.m12, item_mat.m13, item_mat.m14};
+            Vector3 d = Vector3Scale(Vector3Subtract(mouth_pos, item_pos), 0.9);
+            float k = 1.0 - TIME_REMAINING / GAME_STATE_TO_TIME[GOLOVA_IS_EATING];
+            d = Vector3Scale(d, k);
+            item_mat = MatrixMultiply(item_mat, MatrixTranslate(d.x, d.y, d.z));
+        }
+
+        b->item_matrices[i] = item_mat;
     }
+    PROFILE_END(update_items);
 
     // -------------------------------------------------------------------
     // Update trees
-    for (size_t i = 0; i < SCENE.forest.n_trees; ++i) {
-        Tree *tree = &SCENE.forest.trees[i];
-        rlPushMatrix();
-        rlTranslatef(
-            tree->transform.translation.x,
-            tree->transform.translation.y,
-            tree->transform.translation.z
-        );
-        float a = sinf(TIME) * 2.5;
-        rlRotatef(a, 1.0, 0.0, 0.0);
-        rlRotatef(a, 0.0, 1.0, 0.0);
-        rlRotatef(a, 0.0, 0.0, 1.0);
-        rlTranslatef(
-            -tree->transform.translation.x,
-            -tree->transform.translation.y,
-            -tree->transform.translation.z
-        );
-        tree->matrix = rlGetMatrixTransform();
-        rlPopMatrix();
-    }
+    PROFILE_BEGIN(update_trees);
+    // All trees sway by the same rotation around their own positions, so the
+    // pivot offsets are a single batched point transform
+    float a = DEG2RAD * sinf(TIME) * 2.5;
+    Matrix sway = MatrixMultiply(
+        MatrixRotateZ(a), MatrixMultiply(MatrixRotateY(a), MatrixRotateX(a))
+    );
+
+    parallel_for(SCENE.forest.n_trees, 256, update_trees_sway, &sway);
+    PROFILE_END(update_trees);
 
     // -------------------------------------------------------------------
     // Update Golova
+    PROFILE_BEGIN(update_golova);
     int health = CLAMP(SCENE.board.n_misses_allowed, 0, 3);
     SCENE.golova.cracks.strength = (3 - health) / 3.0f;
 
-    rlPushMatrix();
-    rlTranslatef(0.0, sinf(TIME * 2.0) * 0.015, 0.0);
-    SCENE.golova.matrix = rlGetMatrixTransform();
-    rlPopMatrix();
+    SCENE.golova.matrix = MatrixTranslate(0.0, sinf(TIME * 2.0) * 0.015, 0.0);
 
     // -------------------------------------------------------------------
     // Update Golova gaze
@@ -412,25 +863,24 @@ static void update_game(void) {
     bool has_target = false;
 
     // Look at hot, active or dying item
-    for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-        Item *item = &SCENE.board.items[i];
-        if (item->state > ITEM_COLD && item->state < ITEM_DEAD) {
-            Matrix mat = MatrixMultiply(
-                get_transform_matrix(SCENE.board.transform), item->matrix
-            );
+    for (int i = 0; i < b->n_items; ++i) {
+        ItemState state = b->item_states[i];
+        if (state > ITEM_COLD && state < ITEM_DEAD) {
+            Matrix board = get_scene_node_world(NODE_BOARD);
+            Matrix mat = MatrixMultiply(board, b->item_matrices[i]);
             Vector3 pos = (Vector3){mat.m12, mat.m13, mat.m14};
             target = pos;
             has_target = true;
 
             // Don't check other items, we already look at the picked (active) item
-            if (item == PICKED_ITEM) break;
+            if (i == PICKED_ITEM) break;
         }
     }
 
     // If there is no target item, just follow the mouse cursor (board collision)
     if (!has_target) {
         RayCollision collision = GetRayCollisionMesh(
-            MOUSE_RAY, SCENE.board.mesh, get_transform_matrix(SCENE.board.transform)
+            MOUSE_RAY, SCENE.board.mesh, get_scene_node_world(NODE_BOARD)
         );
         has_target = collision.hit;
         target = collision.point;
@@ -455,11 +905,12 @@ static void update_game(void) {
         &SCENE.golova.eyes_curr_shift,
         &SCENE.golova.eyes_curr_uplift
     );
+    PROFILE_END(update_golova);
 
     // -------------------------------------------------------------------
     // Update game state
-    if (PAUSE_STATE > 0) return;
-    TIME_REMAINING -= GetFrameTime();
+    if (PAUSE_STATE > 0) return true;
+    TIME_REMAINING -= DT;
 
     if (IS_SPACE_PRESSED && GAME_STATE == PLAYER_IS_PICKING) {
         TIME_REMAINING = 0.0;
@@ -472,97 +923,57 @@ static void update_game(void) {
         SCENE.golova.state = GOLOVA_IDLE;
 
         // Handle mouse input and update item states
-        bool is_hit_any = false;
-        for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-            Item *item = &SCENE.board.items[i];
-
-            // Don't update dead items
-            if (item->state == ITEM_DEAD) continue;
-
-            // Collide mouse and item meshes
-            RayCollision collision = GetRayCollisionMesh(
-                MOUSE_RAY, SCENE.board.item_mesh, item->matrix
-            );
-
-            bool is_hit = collision.hit;
-            is_hit_any |= is_hit;
-            if (is_hit && IS_LMB_PRESSED) {
-                // Unpick previous item and pick the new one
-                if (PICKED_ITEM && PICKED_ITEM != item) {
-                    PICKED_ITEM->state = ITEM_COLD;
-                    PICKED_ITEM = item;
-                    PICKED_ITEM->state = ITEM_ACTIVE;
-                    play_sound_roulette(&TOUCH_SOUNDS);
-                    // Unpick the item
-                } else if (PICKED_ITEM) {
-                    PICKED_ITEM->state = ITEM_COLD;
-                    PICKED_ITEM = NULL;
-                    // Pick the item
-                } else {
-                    PICKED_ITEM = item;
-                    PICKED_ITEM->state = ITEM_ACTIVE;
-                    play_sound_roulette(&TOUCH_SOUNDS);
-                }
-            } else if (is_hit) {
-                // Heat up (or stay active) the item
-                item->state = MAX(item->state, ITEM_HOT);
-            } else if (item->state == ITEM_HOT) {
-                // Cool down the hot item
-                item->state = ITEM_COLD;
-            }
-        }
-
-        // Unpick when clicked on empty space
-        if (!is_hit_any && IS_LMB_PRESSED && PICKED_ITEM) {
-            PICKED_ITEM->state = ITEM_COLD;
-            PICKED_ITEM = NULL;
-        }
+        ItemState *states = b->item_states;
+        bool is_picked = update_item_states(
+            states, b->item_matrices, b->n_items, MOUSE_RAY, &PICKED_ITEM
+        );
+        if (is_picked) play_sound_roulette(&TOUCH_SOUNDS, SOUND_TOUCH);
 
         // PLAYER_IS_PICKING state is over
         if (TIME_REMAINING <= 0.0) {
             NEXT_GAME_STATE = GOLOVA_IS_EATING;
 
             // Pick random wrong item
-            if (!PICKED_ITEM) {
+            if (PICKED_ITEM == -1) {
                 int n_ids = 0;
                 int ids[MAX_N_BOARD_ITEMS];
-                for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-                    Item *item = &SCENE.board.items[i];
-                    if (!(item->state == ITEM_DEAD) && !item->is_correct) {
+                for (int i = 0; i < b->n_items; ++i) {
+                    if (!(states[i] == ITEM_DEAD) && !b->items[i].is_correct) {
                         ids[n_ids++] = i;
                     }
                 }
 
-                PICKED_ITEM = &SCENE.board.items[ids[rand() % (n_ids)]];
+                PICKED_ITEM = ids[rand() % (n_ids)];
             }
 
-            PICKED_ITEM->state = ITEM_DYING;
-            if (OPTIONS.with_sound) PlaySound(PICKED_ITEM->sound);
+            states[PICKED_ITEM] = ITEM_DYING;
+            Sound sound = b->items[PICKED_ITEM].sound;
+            if (OPTIONS.with_sound) queue_frame_sound(sound, SOUND_ITEM);
         }
     } else if (GAME_STATE == GOLOVA_IS_EATING) {
         // Set up Golova state
         SCENE.golova.state = GOLOVA_EAT;
 
         // Cool down all non-dying items when golova is eating
-        for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-            Item *item = &SCENE.board.items[i];
-            if (item->state < ITEM_DYING) item->state = ITEM_COLD;
+        ItemState *states = b->item_states;
+        for (int i = 0; i < b->n_items; ++i) {
+            if (states[i] < ITEM_DYING) states[i] = ITEM_COLD;
         }
 
         // GOLOVA_IS_EATING state is over
         if (TIME_REMAINING <= 0.0) {
-            PICKED_ITEM->state = ITEM_DEAD;
-            if (PICKED_ITEM->is_correct) {
+            states[PICKED_ITEM] = ITEM_DEAD;
+            if (b->items[PICKED_ITEM].is_correct) {
                 DEAD_CORRECT_ITEMS[N_DEAD_CORRECT_ITEMS++] = PICKED_ITEM;
                 SCENE.board.n_hits_required -= 1;
-                play_sound_roulette(&CORRECT_SOUNDS);
+                play_sound_roulette(&CORRECT_SOUNDS, SOUND_RESULT);
             } else {
                 DEAD_WRONG_ITEMS[N_DEAD_WRONG_ITEMS++] = PICKED_ITEM;
                 SCENE.board.n_misses_allowed -= 1;
-                play_sound_roulette(&WRONG_SOUNDS);
+                play_sound_roulette(&WRONG_SOUNDS, SOUND_RESULT);
                 CAMERA_SHAKING_TIME = 0.6;
             }
-            PICKED_ITEM = NULL;
+            PICKED_ITEM = -1;
 
             if (SCENE.board.n_misses_allowed < 0 || SCENE.board.n_hits_required == 0) {
                 NEXT_GAME_STATE = CURR_SCENE_ID < N_SCENES - 1 ? SCENE_OVER : GAME_OVER;
@@ -571,17 +982,22 @@ static void update_game(void) {
             }
         }
     } else if (GAME_STATE == SCENE_OVER) {
+        if (IS_SPACE_PRESSED) IS_NEXT_SCENE = true;
     } else if (GAME_STATE == GAME_OVER) {
     }
+
+    return true;
 }
 
-static void draw_ggui(void) {
+static UiActions draw_ggui(const FrameSnapshot *snapshot) {
+    UiActions actions = {.options = snapshot->options};
+
     int screen_height = GetScreenHeight();
     int screen_width = GetScreenWidth();
     int cx = screen_width / 2;
     int cy = screen_height / 2;
 
-    if (PAUSE_STATE > NOT_PAUSED) {
+    if (snapshot->pause_state > NOT_PAUSED) {
         int font_size = 60;
         int gap = 20;
         int pad = 50;
@@ -590,7 +1006,7 @@ static void draw_ggui(void) {
         const char *options_text = "Options";
         const char *quit_text = "Quit";
 
-        int width = MeasureText(options_text, font_size) * 1.2;
+        int width = measure_ui_text(options_text, font_size) * 1.2;
         int height = font_size * 3 + gap * 2 + pad * 2;
 
         Rectangle main_rec = ggui_get_rec(
@@ -598,54 +1014,69 @@ static void draw_ggui(void) {
         );
         DrawRectangleRounded(main_rec, 0.2, 16, (Color){100, 100, 100, 150});
         DrawRectangleRoundedLines(main_rec, 0.2, 16, 4, WHITE);
+        count_shapes_draw();
 
         int y = main_rec.y + pad;
-        if (PAUSE_STATE == MAIN_PAUSE) {
-            if (ggui_button((Position){cx, y, CENTER_TOP}, resume_text, font_size)) {
-                NEXT_PAUSE_STATE = NOT_PAUSED;
-            }
+        if (snapshot->pause_state == MAIN_PAUSE) {
+            actions.is_resume = ggui_button(
+                (Position){cx, y, CENTER_TOP}, resume_text, font_size
+            );
 
             y += font_size + gap;
-            if (ggui_button((Position){cx, y, CENTER_TOP}, options_text, font_size)) {
-                NEXT_PAUSE_STATE = OPTIONS_PAUSE;
-            }
+            actions.is_options = ggui_button(
+                (Position){cx, y, CENTER_TOP}, options_text, font_size
+            );
 
             y += font_size + gap;
-            IS_EXIT_GAME = ggui_button(
+            actions.is_exit = ggui_button(
                 (Position){cx, y, CENTER_TOP}, quit_text, font_size
             );
-        } else if (PAUSE_STATE == OPTIONS_PAUSE) {
+        } else if (snapshot->pause_state == OPTIONS_PAUSE) {
+            Options *options = &actions.options;
             font_size /= 2;
 
             ggui_text(
                 (Position){main_rec.x + gap, y, LEFT_BOT}, "Music  ", font_size, WHITE
             );
-            ggui_checkbox(
-                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &OPTIONS.with_music
+            actions.is_options_changed |= ggui_checkbox(
+                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &options->with_music
             );
 
             y += font_size + gap;
             ggui_text(
                 (Position){main_rec.x + gap, y, LEFT_BOT}, "Sound  ", font_size, WHITE
             );
-            ggui_checkbox(
-                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &OPTIONS.with_sound
+            actions.is_options_changed |= ggui_checkbox(
+                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &options->with_sound
             );
 
             y += font_size + gap;
             ggui_text(
                 (Position){main_rec.x + gap, y, LEFT_BOT}, "Shadows", font_size, WHITE
             );
-            ggui_checkbox(
-                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &OPTIONS.with_shadows
+            actions.is_options_changed |= ggui_checkbox(
+                (Position){main_rec.x + 230, y - 5, CENTER_BOT}, &options->with_shadows
             );
+
+            // Cycles through the shadow mask sizes
+            y += font_size + gap;
+            ggui_text(
+                (Position){main_rec.x + gap, y, LEFT_BOT}, "Quality", font_size, WHITE
+            );
+            const char *quality_text = SHADOW_QUALITY_TO_NAME(options->shadow_quality);
+            if (ggui_button(
+                    (Position){main_rec.x + 230, y, CENTER_BOT}, quality_text, font_size
+                )) {
+                options->shadow_quality = options->shadow_quality % SHADOWS_HIGH + 1;
+                actions.is_options_changed = true;
+            }
         }
-    } else if (GAME_STATE == SCENE_OVER || GAME_STATE == GAME_OVER) {
+    } else if (snapshot->game_state == SCENE_OVER || snapshot->game_state == GAME_OVER) {
         const char *text;
         Color color;
         Position pos;
 
-        if (SCENE.board.n_misses_allowed < 0) {
+        if (!snapshot->is_golova_happy) {
             text = "Golova feels bad...";
             color = MAROON;
         } else {
@@ -659,46 +1090,45 @@ static void draw_ggui(void) {
         ggui_text(pos, text, font_size, color);
 
         pos = (Position){cx, cy - font_size / 2, CENTER_BOT};
-        ggui_text(pos, SCENE.board.rule, font_size / 3, LIGHTGRAY);
+        ggui_text(pos, snapshot->rule, font_size / 3, LIGHTGRAY);
 
         pos = (Position){cx, cy + font_size, CENTER_TOP};
-        if (GAME_STATE == SCENE_OVER) {
-            IS_NEXT_SCENE = ggui_button(pos, "Continue", font_size / 2) || IS_SPACE_PRESSED;
-        } else if (GAME_STATE == GAME_OVER) {
+        if (snapshot->game_state == SCENE_OVER) {
+            actions.is_next_scene = ggui_button(pos, "Continue", font_size / 2);
+        } else if (snapshot->game_state == GAME_OVER) {
             ggui_text(pos, "Game Over", font_size / 2, LIGHTGRAY);
         }
     }
 
-    if (GAME_STATE != INTRO) {
+    if (snapshot->game_state != INTRO) {
         // ---------------------------------------------------------------
         // Draw correctly picked items
-        int n_items = N_DEAD_CORRECT_ITEMS + SCENE.board.n_hits_required;
+        int n_dead_items = snapshot->n_dead_correct_items;
+        int n_items = n_dead_items + snapshot->n_hits_required;
         int item_size = 64;
         int pad = 20;
-        int x = pad;
 
+        // Question marks share the texture and go in one batch
+        static Rectangle dsts[2 * MAX_N_BOARD_ITEMS];
         for (int i = 0; i < n_items; ++i) {
-            Texture texture;
-            Color color = WHITE;
-            if (i < N_DEAD_CORRECT_ITEMS) {
-                Item *item = DEAD_CORRECT_ITEMS[i];
-                texture = item->texture;
-            } else {
-                texture = TEXTURE_QUESTION_MARK;
-                color = PURPLE;
+            dsts[i] = (Rectangle){pad + i * (pad + item_size), pad, item_size, item_size};
+            if (i < n_dead_items) {
+                Texture2D texture = snapshot->dead_correct_textures[i];
+                draw_ui_texture_quads(texture, &dsts[i], 1, WHITE);
             }
-            Rectangle src = {0.0, 0.0, texture.width, texture.height};
-            Rectangle dst = {x, pad, item_size, item_size};
-            DrawTexturePro(texture, src, dst, Vector2Zero(), 0.0, color);
-
-            x += pad + item_size;
         }
+        draw_ui_texture_quads(
+            TEXTURE_QUESTION_MARK,
+            &dsts[n_dead_items],
+            n_items - n_dead_items,
+            PURPLE
+        );
 
         // ---------------------------------------------------------------
         // Draw current level number
         int font_size = 30;
-        const char *text = TextFormat("Level %d", CURR_SCENE_ID + 1);
-        int w = MeasureText(text, font_size);
+        const char *text = TextFormat("Level %d", snapshot->scene_id + 1);
+        int w = measure_ui_text(text, font_size);
         ggui_text(
             (Position){screen_width - w - 10, 10, LEFT_TOP}, text, font_size, WHITE
         );
@@ -706,15 +1136,17 @@ static void draw_ggui(void) {
 
     // -------------------------------------------------------------------
     // Draw game intro
-    if (GAME_STATE == INTRO) {
+    if (snapshot->game_state == INTRO) {
         Position pos = {screen_width / 2, screen_height / 2, CENTER_CENTER};
         ggui_text(pos, "Golova", 200, WHITE);
         pos.y += 120;
 
         Color color = WHITE;
-        color.a = 255.0 * (sinf(TIME * 8.0) * 0.4 + 0.6);
+        color.a = 255.0 * (sinf(snapshot->time * 8.0) * 0.4 + 0.6);
         ggui_text(pos, "[PRESS ANY KEY]", 40, color);
     }
+
+    return actions;
 }
 
 static Rectangle ggui_get_rec(Position pos, int width, int height) {
@@ -738,17 +1170,18 @@ static Rectangle ggui_get_rec(Position pos, int width, int height) {
 }
 
 static bool ggui_button(Position pos, const char *text, int font_size) {
-    int width = MeasureText(text, font_size);
+    int width = measure_ui_text(text, font_size);
     Rectangle rec = ggui_get_rec(pos, width, font_size);
 
     bool is_hit = CheckCollisionPointRec(MOUSE_POSITION, rec);
     Color color = is_hit ? WHITE : LIGHTGRAY;
-    DrawText(text, rec.x, rec.y, font_size, color);
+    draw_ui_text(text, (Vector2){rec.x, rec.y}, font_size, color);
 
     return is_hit && IS_LMB_PRESSED;
 }
 
-static void ggui_checkbox(Position pos, bool *is_checked) {
+// Returns true if the checkbox was toggled
+static bool ggui_checkbox(Position pos, bool *is_checked) {
     int size = 20;
     Rectangle rec = ggui_get_rec(pos, size, size);
 
@@ -760,16 +1193,39 @@ static void ggui_checkbox(Position pos, bool *is_checked) {
 
     bool is_hit = CheckCollisionPointRec(MOUSE_POSITION, bound_rec);
     Color color = is_hit ? WHITE : LIGHTGRAY;
-    *is_checked ^= is_hit && IS_LMB_PRESSED;
+    bool is_toggled = is_hit && IS_LMB_PRESSED;
+    *is_checked ^= is_toggled;
 
     DrawRectangleLinesEx(bound_rec, 3, color);
     if (*is_checked) DrawRectangle(rec.x, rec.y, rec.width, rec.height, color);
+    count_shapes_draw();
+    return is_toggled;
 }
 
+// Text layouts are cached by ui_text, only new strings are laid out
 static void ggui_text(Position pos, const char *text, int font_size, Color color) {
-    int width = MeasureText(text, font_size);
+    int width = measure_ui_text(text, font_size);
     Rectangle rec = ggui_get_rec(pos, width, font_size);
-    DrawText(text, rec.x, rec.y, font_size, color);
+    draw_ui_text(text, (Vector2){rec.x, rec.y}, font_size, color);
+}
+
+static void update_trees_sway(int begin, int end, void *data) {
+    Matrix sway = *(Matrix *)data;
+    for (int i = begin; i < end; ++i) {
+        TREES_PIVOTS[i] = SCENE.forest.tree_transforms[i].translation;
+    }
+
+    Vector3 *pivots = &TREES_PIVOTS[begin];
+    Vector3 *swayed_pivots = &TREES_SWAYED_PIVOTS[begin];
+    transform_points(sway, pivots, swayed_pivots, end - begin);
+
+    for (int i = begin; i < end; ++i) {
+        Matrix mat = sway;
+        mat.m12 = TREES_PIVOTS[i].x - TREES_SWAYED_PIVOTS[i].x;
+        mat.m13 = TREES_PIVOTS[i].y - TREES_SWAYED_PIVOTS[i].y;
+        mat.m14 = TREES_PIVOTS[i].z - TREES_SWAYED_PIVOTS[i].z;
+        SCENE.forest.tree_matrices[i] = mat;
+    }
 }
 
 static void update_value(float dt, float speed, float *target, float *curr) {
@@ -796,12 +1252,18 @@ static void update_value2(
     }
 }
 
-static void play_sound_roulette(SoundsRoulette *sounds) {
+static void play_sound_roulette(SoundsRoulette *sounds, SoundCategory category) {
     if (sounds->n == 0) return;
-    if (OPTIONS.with_sound) PlaySound(sounds->sounds[sounds->i++]);
+    if (OPTIONS.with_sound) queue_frame_sound(sounds->sounds[sounds->i++], category);
     if (sounds->i >= sounds->n) sounds->i = 0;
 }
 
+static void queue_frame_sound(Sound sound, SoundCategory category) {
+    FrameSnapshot *snapshot = &SNAPSHOTS[FRAME_ID % 2];
+    if (snapshot->n_sounds == MAX_N_FRAME_SOUNDS) return;
+    snapshot->sounds[snapshot->n_sounds++] = (FrameSound){sound, category};
+}
+
 #ifdef DRAW_IMGUI
 static void draw_imgui(void) {
     begin_imgui();
@@ -816,11 +1278,111 @@ static void draw_imgui(void) {
         igText("n_hits_required: %d", SCENE.board.n_hits_required);
         igText("n_misses_allowed: %d", SCENE.board.n_misses_allowed);
 
+        VoicePoolStats voices = get_voice_pool_stats();
+        igText("voices: %d/%d", voices.n_active, voices.max_voices);
+        igText(
+            "voices (touch/item/result): %d/%d/%d",
+            voices.n_active_by_category[SOUND_TOUCH],
+            voices.n_active_by_category[SOUND_ITEM],
+            voices.n_active_by_category[SOUND_RESULT]
+        );
+        igText("voices stolen/dropped: %d/%d", voices.n_stolen, voices.n_dropped);
+
+        MusicFeederStats music = get_music_feeder_stats();
+        igText("music feeder: %s", music.is_threaded ? "thread" : "main");
+        igText("music fill: %.2f (min %.2f)", music.fill_level, music.min_fill_level);
+        igText("music refills/underruns: %d/%d", music.n_refills, music.n_underruns);
+
+        JobStats jobs = get_job_stats();
+        igText("jobs: %d workers", jobs.n_workers);
+        igText(
+            "jobs run/stolen/inline: %ld/%ld/%ld",
+            jobs.n_jobs,
+            jobs.n_stolen,
+            jobs.n_inline
+        );
+
+        AssetFetchStats assets = get_asset_fetch_stats();
+        igText("assets: %s", assets.is_lazy ? "fetched" : "on disk");
+        igText("assets pending/failed: %d/%d", assets.n_pending, assets.n_failed);
+        igText(
+            "assets network/cache: %ld/%ld bytes",
+            assets.n_bytes_from_network,
+            assets.n_bytes_from_cache
+        );
+
+        ig_render_stats();
+
+        UiTextStats ui_texts = get_ui_text_stats();
+        igText(
+            "ui texts/layouts/hits: %d/%ld/%ld",
+            ui_texts.n_texts,
+            ui_texts.n_layouts,
+            ui_texts.n_hits
+        );
+
+        TextureStreamStats streams = get_texture_stream_stats();
+        igText("texture streams: %s", streams.with_ring ? "ring" : "direct");
+        igText(
+            "texture streams/pending: %d/%ld bytes",
+            streams.n_streams,
+            streams.n_pending_bytes
+        );
+        igText("texture uploaded: %ld bytes", streams.n_uploaded_bytes);
+        igText("time to first frame: %.1f ms", assets.time_to_first_frame);
+
+        ResourceStats resources = get_resource_stats();
+        igText("resources: %.2f MB", resources.n_total_bytes / 1048576.0);
+        for (int i = 0; i < N_RESOURCE_CATEGORIES; ++i) {
+            igText(
+                "    %s: %d, %.2f MB",
+                RESOURCE_CATEGORY_TO_NAME(i),
+                resources.n_resources[i],
+                resources.n_bytes[i] / 1048576.0
+            );
+        }
+        for (int i = 0; i < N_RESOURCE_OWNERS; ++i) {
+            igText(
+                "    %s: %.2f MB",
+                RESOURCE_OWNER_TO_NAME(i),
+                resources.n_bytes_by_owner[i] / 1048576.0
+            );
+        }
+        igText(
+            "resources leaked: %d, %.2f MB",
+            resources.n_leaked,
+            resources.n_leaked_bytes / 1048576.0
+        );
+
+        igText(
+            "pipelined frames: %lu, stalled: %lu", N_PIPELINED_FRAMES, N_STALLED_FRAMES
+        );
+        bool is_late_latch = IS_LATE_LATCH;
+        igCheckbox("late latch", &IS_LATE_LATCH);
+        igSameLine(0.0, 5.0);
+        igText("(%lu frames latched)", N_LATCHED_FRAMES);
+#ifdef MEASURE_LATENCY
+        // The samples are of one latch setting, so the two can be compared
+        if (IS_LATE_LATCH != is_late_latch) N_LATENCY_SAMPLES = 0;
+        int n_samples = MIN(N_LATENCY_SAMPLES, MAX_N_LATENCY_SAMPLES);
+        float latency_sum = 0.0;
+        float latency_max = 0.0;
+        for (int i = 0; i < n_samples; ++i) {
+            latency_sum += LATENCY_SAMPLES[i];
+            latency_max = MAX(latency_max, LATENCY_SAMPLES[i]);
+        }
+        igText(
+            "input to submit: %.1f ms (max %.1f ms)",
+            1000.0 * latency_sum / MAX(n_samples, 1),
+            1000.0 * latency_max
+        );
+#endif
+
         const char *picked_item_name = "";
         const char *picked_item_state = "";
-        if (PICKED_ITEM) {
-            picked_item_name = PICKED_ITEM->name;
-            picked_item_state = ITEM_STATE_TO_NAME(PICKED_ITEM->state);
+        if (PICKED_ITEM != -1) {
+            picked_item_name = SCENE.board.items[PICKED_ITEM].name;
+            picked_item_state = ITEM_STATE_TO_NAME(SCENE.board.item_states[PICKED_ITEM]);
         }
         igText("picked_item_name: %s", picked_item_name);
         igText("picked_item_state: %s", picked_item_state);
@@ -0,0 +1,177 @@
+#include "../src/math.h"
+#include "raylib.h"
+#include "raymath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N_ELEMS 4096
+#define N_ROUNDS 1000
+#define MAX_ERROR 1e-3
+
+static Transform TRANSFORMS[N_ELEMS];
+static Matrix LOCALS[N_ELEMS];
+static Matrix REFERENCE[N_ELEMS];
+static Matrix RESULT[N_ELEMS];
+static Matrix WORLD[N_ELEMS];
+static Vector3 POINTS[N_ELEMS];
+static Vector3 REFERENCE_POINTS[N_ELEMS];
+static Vector3 RESULT_POINTS[N_ELEMS];
+
+// Keeps the compiler from dropping the benchmarked loops
+static volatile float SINK;
+
+static double get_time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static float get_random_float(float min, float max) {
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+static Matrix get_reference_transform_matrix(Transform t) {
+    Matrix s = MatrixScale(t.scale.x, t.scale.y, t.scale.z);
+    Matrix r = QuaternionToMatrix(t.rotation);
+    Matrix p = MatrixTranslate(t.translation.x, t.translation.y, t.translation.z);
+    return MatrixMultiply(MatrixMultiply(s, r), p);
+}
+
+static float get_matrices_error(const Matrix *a, const Matrix *b, int n) {
+    float error = 0.0;
+    for (int i = 0; i < n; ++i) {
+        const float *fa = (const float *)&a[i];
+        const float *fb = (const float *)&b[i];
+        for (int j = 0; j < 16; ++j) error = fmaxf(error, fabsf(fa[j] - fb[j]));
+    }
+    return error;
+}
+
+static float get_points_error(const Vector3 *a, const Vector3 *b, int n) {
+    float error = 0.0;
+    for (int i = 0; i < n; ++i) {
+        error = fmaxf(error, Vector3Distance(a[i], b[i]));
+    }
+    return error;
+}
+
+static void report(const char *name, double ns, float error) {
+    const char *status = error > MAX_ERROR ? "  FAIL" : "";
+    printf("%-32s %8.2f ns/elem  err %.2e%s\n", name, ns, error, status);
+}
+
+static void init_data(void) {
+    srand(42);
+    for (int i = 0; i < N_ELEMS; ++i) {
+        Vector3 axis = {
+            get_random_float(-1.0, 1.0),
+            get_random_float(-1.0, 1.0),
+            get_random_float(-1.0, 1.0)};
+        TRANSFORMS[i].translation = (Vector3){
+            get_random_float(-50.0, 50.0),
+            get_random_float(-50.0, 50.0),
+            get_random_float(-50.0, 50.0)};
+        TRANSFORMS[i].rotation = QuaternionFromAxisAngle(
+            Vector3Normalize(axis), get_random_float(-PI, PI)
+        );
+        TRANSFORMS[i].scale = (Vector3){
+            get_random_float(0.5, 2.0),
+            get_random_float(0.5, 2.0),
+            get_random_float(0.5, 2.0)};
+        LOCALS[i] = get_reference_transform_matrix(TRANSFORMS[(i * 7) % (i + 1)]);
+        POINTS[i] = TRANSFORMS[i].translation;
+    }
+}
+
+int main(void) {
+    init_data();
+    printf("SIMD: %s, %d elements, %d rounds\n", get_math_simd_name(), N_ELEMS, N_ROUNDS);
+    double n_total = (double)N_ELEMS * N_ROUNDS;
+
+    // -------------------------------------------------------------------
+    // Compose transform matrices
+    double start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        for (int i = 0; i < N_ELEMS; ++i) {
+            REFERENCE[i] = get_reference_transform_matrix(TRANSFORMS[i]);
+        }
+        SINK = REFERENCE[r % N_ELEMS].m12;
+    }
+    report("compose: raymath chain", (get_time_ns() - start) / n_total, 0.0);
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        for (int i = 0; i < N_ELEMS; ++i) {
+            RESULT[i] = get_transform_matrix(TRANSFORMS[i]);
+        }
+        SINK = RESULT[r % N_ELEMS].m12;
+    }
+    report(
+        "compose: get_transform_matrix",
+        (get_time_ns() - start) / n_total,
+        get_matrices_error(REFERENCE, RESULT, N_ELEMS)
+    );
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        compose_transform_matrices(TRANSFORMS, RESULT, N_ELEMS);
+        SINK = RESULT[r % N_ELEMS].m12;
+    }
+    report(
+        "compose: batch",
+        (get_time_ns() - start) / n_total,
+        get_matrices_error(REFERENCE, RESULT, N_ELEMS)
+    );
+
+    // -------------------------------------------------------------------
+    // Multiply matrices
+    compose_transform_matrices(TRANSFORMS, WORLD, N_ELEMS);
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        for (int i = 0; i < N_ELEMS; ++i) {
+            REFERENCE[i] = MatrixMultiply(WORLD[i], LOCALS[i]);
+        }
+        SINK = REFERENCE[r % N_ELEMS].m12;
+    }
+    report("multiply: MatrixMultiply", (get_time_ns() - start) / n_total, 0.0);
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        multiply_matrices(WORLD, LOCALS, RESULT, N_ELEMS);
+        SINK = RESULT[r % N_ELEMS].m12;
+    }
+    report(
+        "multiply: batch",
+        (get_time_ns() - start) / n_total,
+        get_matrices_error(REFERENCE, RESULT, N_ELEMS)
+    );
+
+    // -------------------------------------------------------------------
+    // Transform points
+    Matrix matrix = WORLD[0];
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        for (int i = 0; i < N_ELEMS; ++i) {
+            REFERENCE_POINTS[i] = Vector3Transform(POINTS[i], matrix);
+        }
+        SINK = REFERENCE_POINTS[r % N_ELEMS].x;
+    }
+    report("points: Vector3Transform", (get_time_ns() - start) / n_total, 0.0);
+
+    start = get_time_ns();
+    for (int r = 0; r < N_ROUNDS; ++r) {
+        transform_points(matrix, POINTS, RESULT_POINTS, N_ELEMS);
+        SINK = RESULT_POINTS[r % N_ELEMS].x;
+    }
+    report(
+        "points: batch",
+        (get_time_ns() - start) / n_total,
+        get_points_error(REFERENCE_POINTS, RESULT_POINTS, N_ELEMS)
+    );
+
+    return 0;
+}
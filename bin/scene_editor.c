@@ -1,13 +1,23 @@
+#include "../src/bvh.h"
 #include "../src/cimgui_utils.h"
 #include "../src/drawing.h"
+#include "../src/hot_reload.h"
+#include "../src/jobs.h"
 #include "../src/math.h"
 #include "../src/nfd_utils.h"
+#include "../src/postfx.h"
+#include "../src/profiler.h"
+#include "../src/render_stats.h"
+#include "../src/resources.h"
 #include "../src/scene.h"
+#include "../src/texture.h"
+#include "../src/texture_stream.h"
 #include "../src/utils.h"
 #include "raylib.h"
 #include "raymath.h"
 #include "rcamera.h"
 #include "rlgl.h"
+#include <stdlib.h>
 #include <string.h>
 
 #define RAYGIZMO_IMPLEMENTATION
@@ -20,7 +30,6 @@
 // #define SCREEN_HEIGHT 768
 #define SCREEN_WIDTH 2560
 #define SCREEN_HEIGHT 1440
-#define MAX_N_COLLISION_INFOS 256
 
 typedef enum EntityType {
     NULL_TYPE = 0,
@@ -31,14 +40,28 @@ typedef enum EntityType {
     TREE_TYPE,
 } EntityType;
 
-typedef struct CollisionInfo {
-    RayCollision collision;
+// Editor-pickable entity, mirrored by a leaf in the picking BVH. The entity is
+// referenced by its type and index, so no raw pointers are kept between frames
+typedef struct Pickable {
+    EntityType entity_type;
+    int entity_id;
+
+    int generation;
+    bool is_alive;
+    int next_free;
+
+    // Last synced entity state, the BVH leaf is refitted when it changes
+    int leaf;
+    Transform transform;
     Matrix matrix;
     Mesh mesh;
-    Transform *transform;
-    EntityType entity_type;
-    void *entity;
-} CollisionInfo;
+} Pickable;
+
+// Stable pickable handle, it becomes invalid once the pickable is removed
+typedef struct PickHandle {
+    int id;
+    int generation;
+} PickHandle;
 
 typedef struct CameraShell {
     Transform transform;
@@ -60,9 +83,22 @@ static CameraShell LIGHT_CAMERA_SHELL;
 
 static char SCENE_FILE_PATH[2048];
 
-static size_t N_COLLISION_INFOS;
-static CollisionInfo *PICKED_COLLISION_INFO;
-static CollisionInfo COLLISION_INFOS[MAX_N_COLLISION_INFOS];
+static BVH PICKING_BVH;
+static int N_PICKABLES;
+static int PICKABLES_CAPACITY;
+static int FREE_PICKABLE = -1;
+static Pickable *PICKABLES;
+
+static PickHandle PICKED = {-1, 0};
+static PickHandle GOLOVA_PICKABLE = {-1, 0};
+static PickHandle BOARD_PICKABLE = {-1, 0};
+static PickHandle CAMERA_SHELL_PICKABLES[2] = {{-1, 0}, {-1, 0}};
+
+static int N_ITEM_PICKABLES;
+static PickHandle ITEM_PICKABLES[MAX_N_BOARD_ITEMS];
+
+static int N_TREE_PICKABLES;
+static PickHandle TREE_PICKABLES[MAX_N_FOREST_TREES];
 
 static bool IS_MMB_DOWN;
 static bool IS_LMB_PRESSED;
@@ -75,15 +111,24 @@ static Vector2 MOUSE_DELTA;
 static int IG_ID;
 static bool IS_IG_INTERACTED;
 
+static SceneSnapshot SNAPSHOT;
+
 static bool WITH_SHADOWS = true;
 static bool WITH_BLUR = false;
 static int CLEAR_COLOR[3];
 
 static Transform *get_picked_transform(void);
-static void *get_picked_entity(void);
+static int get_picked_entity_id(void);
 static EntityType get_picked_entity_type(void);
 
+static PickHandle add_pickable(EntityType entity_type, int entity_id);
+static void remove_pickable(PickHandle handle);
+static Pickable *get_pickable(PickHandle handle);
+static void sync_pickable(Pickable *pickable);
+static void sync_pickables(void);
+
 static void reset_camera_shells();
+static void update_hot_reload(void);
 static void update_editor(void);
 static void set_board_values(int n_items, int n_hits_required, int n_misses_allowed);
 static void draw_editor_grid(void);
@@ -93,6 +138,7 @@ static void draw_imgui(void);
 
 static bool load_sprite(
     const char *search_path,
+    ResourceOwner owner,
     char *dst_name,
     Transform *dst_transform,
     Texture2D *dst_texture,
@@ -103,21 +149,32 @@ int main(void) {
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Editor");
     SetTargetFPS(60);
 
+    init_jobs(DEFAULT_N_JOB_WORKERS);
     init_core(SCREEN_WIDTH, SCREEN_HEIGHT);
     load_scene(NULL);
     load_imgui();
-
-    FULL_SCREEN = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
-    PREVIEW_SCREEN = LoadRenderTexture(SCREEN_WIDTH / 3, SCREEN_HEIGHT / 3);
-    PREVIEW_SCREEN_POSTFX = LoadRenderTexture(SCREEN_WIDTH / 3, SCREEN_HEIGHT / 3);
+    init_hot_reload("resources");
+
+    set_resource_owner(OWNER_EDITOR);
+    int preview_width = SCREEN_WIDTH / 3;
+    int preview_height = SCREEN_HEIGHT / 3;
+    FULL_SCREEN = track_render_texture(
+        LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT), "full_screen"
+    );
+    PREVIEW_SCREEN = track_render_texture(
+        LoadRenderTexture(preview_width, preview_height), "preview_screen"
+    );
+    PREVIEW_SCREEN_POSTFX = track_render_texture(
+        LoadRenderTexture(preview_width, preview_height), "preview_screen_postfx"
+    );
     GIZMO = rgizmo_create();
 
-    CAMERA_SHELL.mesh = GenMeshSphere(0.15, 16, 16);
+    CAMERA_SHELL.mesh = track_mesh(GenMeshSphere(0.15, 16, 16), "camera_shell");
     CAMERA_SHELL.material = LoadMaterialDefault();
     CAMERA_SHELL.material.maps[0].color = RAYWHITE;
     CAMERA_SHELL.camera = &SCENE.camera;
 
-    LIGHT_CAMERA_SHELL.mesh = GenMeshSphere(0.15, 16, 16);
+    LIGHT_CAMERA_SHELL.mesh = track_mesh(GenMeshSphere(0.15, 16, 16), "light_shell");
     LIGHT_CAMERA_SHELL.material = LoadMaterialDefault();
     LIGHT_CAMERA_SHELL.material.maps[0].color = YELLOW;
     LIGHT_CAMERA_SHELL.camera = &SCENE.light_camera;
@@ -129,54 +186,70 @@ int main(void) {
     CAMERA.projection = CAMERA_PERSPECTIVE;
     CAMERA.up = (Vector3){0.0, 1.0, 0.0};
 
+    init_bvh(&PICKING_BVH);
+    GOLOVA_PICKABLE = add_pickable(GOLOVA_TYPE, 0);
+    BOARD_PICKABLE = add_pickable(BOARD_TYPE, 0);
+    CAMERA_SHELL_PICKABLES[0] = add_pickable(CAMERA_SHELL_TYPE, 0);
+    CAMERA_SHELL_PICKABLES[1] = add_pickable(CAMERA_SHELL_TYPE, 1);
+
     while (!WindowShouldClose()) {
+        PROFILE_FRAME();
+        update_main_thread_jobs();
+        update_texture_streams();
+        update_hot_reload();
         update_editor();
 
-        bool sort_trees = get_picked_entity_type() != TREE_TYPE;
-
         // Draw main editor screen
-        draw_scene(FULL_SCREEN, DARKGRAY, CAMERA, WITH_SHADOWS, false, true, sort_trees);
+        capture_scene_snapshot(&SNAPSHOT);
+        ShadowQuality shadows = WITH_SHADOWS ? SHADOWS_HIGH : SHADOWS_OFF;
+        draw_scene(&SNAPSHOT, FULL_SCREEN, DARKGRAY, CAMERA, shadows, false, true);
 
-        BeginTextureMode(FULL_SCREEN);
+        begin_texture_mode(FULL_SCREEN);
         rlDisableBackfaceCulling();
 
-        BeginMode3D(CAMERA);
+        begin_mode_3d(CAMERA);
         rlSetLineWidth(2.0);
         draw_editor_grid();
-        EndMode3D();
+        end_mode_3d();
 
-        BeginMode3D(CAMERA);
+        begin_mode_3d(CAMERA);
         rlSetLineWidth(3.0);
         draw_camera_shells();
         draw_item_boxes();
-        EndMode3D();
+        end_mode_3d();
 
-        BeginMode3D(CAMERA);
+        begin_mode_3d(CAMERA);
         if (get_picked_transform()) {
             rgizmo_draw(GIZMO, CAMERA, get_picked_transform()->translation);
         }
-        EndMode3D();
+        end_mode_3d();
 
         draw_imgui();
 
-        EndTextureMode();
+        end_texture_mode();
 
-        // Draw scene preview screen
+        // Draw scene preview screen, imgui could have changed the scene
         rlEnableBackfaceCulling();
         Color clear_color = {CLEAR_COLOR[0], CLEAR_COLOR[1], CLEAR_COLOR[2], 255};
+        capture_scene_snapshot(&SNAPSHOT);
+        shadows = WITH_SHADOWS ? SHADOWS_HIGH : SHADOWS_OFF;
         draw_scene(
+            &SNAPSHOT,
             PREVIEW_SCREEN,
             clear_color,
             SCENE.camera,
-            WITH_SHADOWS,
+            shadows,
             false,
-            true,
-            sort_trees
+            true
         );
 
-        BeginTextureMode(PREVIEW_SCREEN_POSTFX);
-        draw_postfx(PREVIEW_SCREEN.texture, WITH_BLUR);
-        EndTextureMode();
+        PostfxStack postfx = {0};
+        add_postfx_effect(&postfx, POSTFX_BLUR, 0.0, BLANK)->is_enabled = WITH_BLUR;
+        add_postfx_effect(&postfx, POSTFX_DIM, 0.4, BLANK)->is_enabled = WITH_BLUR;
+        prepare_postfx(&postfx, PREVIEW_SCREEN.texture);
+        begin_texture_mode(PREVIEW_SCREEN_POSTFX);
+        draw_postfx(&postfx, PREVIEW_SCREEN.texture);
+        end_texture_mode();
 
         // Blit screens
         BeginDrawing();
@@ -184,24 +257,170 @@ int main(void) {
         draw_screen(FULL_SCREEN);
         draw_screen_top_right(PREVIEW_SCREEN_POSTFX);
         EndDrawing();
+        end_render_frame();
     }
 
+    unload_hot_reload();
+    unload_texture_streams();
+    unload_postfx();
+    unload_jobs();
     return 0;
 }
 
+static Transform *get_entity_transform(EntityType entity_type, int entity_id) {
+    if (entity_type == GOLOVA_TYPE) {
+        return &SCENE.golova.transform;
+    } else if (entity_type == BOARD_TYPE) {
+        return &SCENE.board.transform;
+    } else if (entity_type == CAMERA_SHELL_TYPE && entity_id == 0) {
+        return &CAMERA_SHELL.transform;
+    } else if (entity_type == CAMERA_SHELL_TYPE) {
+        return &LIGHT_CAMERA_SHELL.transform;
+    } else if (entity_type == TREE_TYPE) {
+        return &SCENE.forest.tree_transforms[entity_id];
+    }
+    return NULL;
+}
+
+static Mesh get_entity_mesh(EntityType entity_type, int entity_id) {
+    if (entity_type == GOLOVA_TYPE) {
+        return SCENE.golova.idle.mesh;
+    } else if (entity_type == BOARD_TYPE) {
+        return SCENE.board.mesh;
+    } else if (entity_type == CAMERA_SHELL_TYPE && entity_id == 0) {
+        return CAMERA_SHELL.mesh;
+    } else if (entity_type == CAMERA_SHELL_TYPE) {
+        return LIGHT_CAMERA_SHELL.mesh;
+    } else if (entity_type == ITEM_TYPE) {
+        return SCENE.board.item_mesh;
+    } else if (entity_type == TREE_TYPE) {
+        return SCENE.forest.tree_meshes[entity_id];
+    }
+    return (Mesh){0};
+}
+
 static Transform *get_picked_transform(void) {
-    if (!PICKED_COLLISION_INFO) return NULL;
-    return PICKED_COLLISION_INFO->transform;
+    Pickable *pickable = get_pickable(PICKED);
+    if (!pickable) return NULL;
+    return get_entity_transform(pickable->entity_type, pickable->entity_id);
 }
 
-static void *get_picked_entity(void) {
-    if (!PICKED_COLLISION_INFO) return NULL;
-    return PICKED_COLLISION_INFO->entity;
+static int get_picked_entity_id(void) {
+    Pickable *pickable = get_pickable(PICKED);
+    if (!pickable) return -1;
+    return pickable->entity_id;
 }
 
 static EntityType get_picked_entity_type(void) {
-    if (!PICKED_COLLISION_INFO) return NULL_TYPE;
-    return PICKED_COLLISION_INFO->entity_type;
+    Pickable *pickable = get_pickable(PICKED);
+    if (!pickable) return NULL_TYPE;
+    return pickable->entity_type;
+}
+
+static PickHandle add_pickable(EntityType entity_type, int entity_id) {
+    if (FREE_PICKABLE == -1) {
+        if (N_PICKABLES == PICKABLES_CAPACITY) {
+            PICKABLES_CAPACITY = PICKABLES_CAPACITY ? PICKABLES_CAPACITY * 2 : 64;
+            PICKABLES = realloc(PICKABLES, PICKABLES_CAPACITY * sizeof(Pickable));
+        }
+        PICKABLES[N_PICKABLES] = (Pickable){0};
+        FREE_PICKABLE = N_PICKABLES++;
+        PICKABLES[FREE_PICKABLE].next_free = -1;
+    }
+
+    int id = FREE_PICKABLE;
+    Pickable *pickable = &PICKABLES[id];
+    FREE_PICKABLE = pickable->next_free;
+
+    pickable->entity_type = entity_type;
+    pickable->entity_id = entity_id;
+    pickable->is_alive = true;
+    pickable->next_free = -1;
+    pickable->mesh = (Mesh){0};
+    pickable->leaf = insert_bvh_leaf(&PICKING_BVH, (BoundingBox){0}, id);
+    sync_pickable(pickable);
+
+    return (PickHandle){id, pickable->generation};
+}
+
+static void remove_pickable(PickHandle handle) {
+    Pickable *pickable = get_pickable(handle);
+    if (!pickable) return;
+
+    remove_bvh_leaf(&PICKING_BVH, pickable->leaf);
+    pickable->is_alive = false;
+    pickable->generation += 1;
+    pickable->next_free = FREE_PICKABLE;
+    FREE_PICKABLE = handle.id;
+}
+
+static Pickable *get_pickable(PickHandle handle) {
+    if (handle.id < 0 || handle.id >= N_PICKABLES) return NULL;
+
+    Pickable *pickable = &PICKABLES[handle.id];
+    if (!pickable->is_alive || pickable->generation != handle.generation) return NULL;
+    return pickable;
+}
+
+// Refits the pickable BVH leaf if the entity has been moved or its mesh changed
+static void sync_pickable(Pickable *pickable) {
+    EntityType type = pickable->entity_type;
+    int id = pickable->entity_id;
+    Transform *transform = get_entity_transform(type, id);
+    Mesh mesh = get_entity_mesh(type, id);
+
+    bool is_changed = mesh.vaoId != pickable->mesh.vaoId
+                      || mesh.vertexCount != pickable->mesh.vertexCount;
+    if (transform) {
+        if (is_changed || memcmp(transform, &pickable->transform, sizeof(Transform))) {
+            pickable->transform = *transform;
+            pickable->matrix = get_transform_matrix(*transform);
+            is_changed = true;
+        }
+    } else {
+        Matrix matrix = SCENE.board.item_matrices[id];
+        if (is_changed || memcmp(&matrix, &pickable->matrix, sizeof(Matrix))) {
+            pickable->matrix = matrix;
+            is_changed = true;
+        }
+    }
+
+    if (!is_changed) return;
+    pickable->mesh = mesh;
+
+    BoundingBox box = {0};
+    if (mesh.vertices) box = GetMeshBoundingBox(mesh);
+    box = get_transformed_box(box, pickable->matrix);
+    refit_bvh_leaf(&PICKING_BVH, pickable->leaf, box);
+}
+
+static void sync_pickables(void) {
+    // Keep pickables in line with the board items and forest trees
+    while (N_ITEM_PICKABLES < SCENE.board.n_items) {
+        int id = N_ITEM_PICKABLES++;
+        ITEM_PICKABLES[id] = add_pickable(ITEM_TYPE, id);
+    }
+    while (N_ITEM_PICKABLES > SCENE.board.n_items) {
+        remove_pickable(ITEM_PICKABLES[--N_ITEM_PICKABLES]);
+    }
+
+    while (N_TREE_PICKABLES < SCENE.forest.n_trees) {
+        int id = N_TREE_PICKABLES++;
+        TREE_PICKABLES[id] = add_pickable(TREE_TYPE, id);
+    }
+    while (N_TREE_PICKABLES > SCENE.forest.n_trees) {
+        remove_pickable(TREE_PICKABLES[--N_TREE_PICKABLES]);
+    }
+
+    for (int i = 0; i < N_PICKABLES; ++i) {
+        if (PICKABLES[i].is_alive) sync_pickable(&PICKABLES[i]);
+    }
+}
+
+static float test_pickable(int id, Ray ray, void *ctx) {
+    Pickable *pickable = &PICKABLES[id];
+    RayCollision collision = GetRayCollisionMesh(ray, pickable->mesh, pickable->matrix);
+    return collision.hit ? collision.distance : -1.0;
 }
 
 static void reset_camera_shells(void) {
@@ -217,21 +436,34 @@ static void reset_camera_shells(void) {
     }
 }
 
+static void unpick(void) {
+    PICKED = (PickHandle){-1, 0};
+    GIZMO.state = RGIZMO_STATE_COLD;
+}
+
 static void delete_tree(size_t idx) {
-    Tree *tree = &SCENE.forest.trees[idx];
-    UnloadTexture(tree->texture);
-    UnloadMesh(tree->mesh);
-    SCENE.forest.n_trees -= 1;
-    size_t n_move = SCENE.forest.n_trees - idx;
-    if (n_move > 0) {
-        size_t size_move = n_move * sizeof(SCENE.forest.trees[0]);
-        memmove(&SCENE.forest.trees[idx], &SCENE.forest.trees[idx + 1], size_move);
+    remove_forest_tree(&SCENE.forest, idx);
+
+    // Drop the tree pickable and shift the indices of the following trees
+    PickHandle handle = TREE_PICKABLES[idx];
+    if (handle.id == PICKED.id && handle.generation == PICKED.generation) unpick();
+    remove_pickable(handle);
+
+    N_TREE_PICKABLES -= 1;
+    for (size_t i = idx; i < N_TREE_PICKABLES; ++i) {
+        TREE_PICKABLES[i] = TREE_PICKABLES[i + 1];
+        get_pickable(TREE_PICKABLES[i])->entity_id = i;
     }
 }
 
-static void unpick(void) {
-    PICKED_COLLISION_INFO = NULL;
-    GIZMO.state = RGIZMO_STATE_COLD;
+static void update_hot_reload(void) {
+    static char paths[MAX_N_CHANGED_FILES][MAX_PATH_LENGTH];
+    int n_paths = poll_changed_files(paths, MAX_N_CHANGED_FILES);
+    for (int i = 0; i < n_paths; ++i) {
+        // Scenes and forests are written by the editor itself
+        if (IsFileExtension(paths[i], ".scn;.fst")) continue;
+        reload_scene_file(paths[i]);
+    }
 }
 
 static void update_editor(void) {
@@ -268,75 +500,22 @@ static void update_editor(void) {
         }
     }
 
-    // ------------------------------------------------------------------
-    // Collision infos
-    N_COLLISION_INFOS = 0;
-
-    COLLISION_INFOS[N_COLLISION_INFOS].entity_type = GOLOVA_TYPE;
-    COLLISION_INFOS[N_COLLISION_INFOS].transform = &SCENE.golova.transform;
-    COLLISION_INFOS[N_COLLISION_INFOS++].mesh = SCENE.golova.idle.mesh;
-
-    COLLISION_INFOS[N_COLLISION_INFOS].entity_type = BOARD_TYPE;
-    COLLISION_INFOS[N_COLLISION_INFOS].transform = &SCENE.board.transform;
-    COLLISION_INFOS[N_COLLISION_INFOS++].mesh = SCENE.board.mesh;
-
-    COLLISION_INFOS[N_COLLISION_INFOS].entity_type = CAMERA_SHELL_TYPE;
-    COLLISION_INFOS[N_COLLISION_INFOS].transform = &CAMERA_SHELL.transform;
-    COLLISION_INFOS[N_COLLISION_INFOS++].mesh = CAMERA_SHELL.mesh;
-
-    COLLISION_INFOS[N_COLLISION_INFOS].entity_type = CAMERA_SHELL_TYPE;
-    COLLISION_INFOS[N_COLLISION_INFOS].transform = &LIGHT_CAMERA_SHELL.transform;
-    COLLISION_INFOS[N_COLLISION_INFOS++].mesh = LIGHT_CAMERA_SHELL.mesh;
-
-    for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-        Item *item = &SCENE.board.items[i];
-
-        COLLISION_INFOS[N_COLLISION_INFOS].entity_type = ITEM_TYPE;
-        COLLISION_INFOS[N_COLLISION_INFOS].transform = NULL;
-        COLLISION_INFOS[N_COLLISION_INFOS].matrix = item->matrix;
-        COLLISION_INFOS[N_COLLISION_INFOS].entity = item;
-        COLLISION_INFOS[N_COLLISION_INFOS++].mesh = SCENE.board.item_mesh;
-    }
-
-    for (size_t i = 0; i < SCENE.forest.n_trees; ++i) {
-        Tree *tree = &SCENE.forest.trees[i];
-
-        COLLISION_INFOS[N_COLLISION_INFOS].entity_type = TREE_TYPE;
-        COLLISION_INFOS[N_COLLISION_INFOS].transform = &tree->transform;
-        COLLISION_INFOS[N_COLLISION_INFOS].entity = tree;
-        COLLISION_INFOS[N_COLLISION_INFOS++].mesh = tree->mesh;
-    }
-
     // -------------------------------------------------------------------
     // Board items
     Board *b = &SCENE.board;
-    Transform t = b->transform;
-    t.scale = Vector3Scale(Vector3One(), t.scale.x);
-
-    size_t n_items = b->n_items;
-
-    int n_rows = sqrt(n_items);
-    int n_cols = ceil((float)n_items / n_rows);
-    for (size_t i = 0; i < n_items; ++i) {
-        Item *item = &b->items[i];
-
-        int i_row = i / n_cols;
-        int i_col = i % n_cols;
-
-        float z = n_rows > 1 ? (float)i_row / (n_rows - 1) - 0.5 : 0.0;
-        float x = n_cols > 1 ? (float)i_col / (n_cols - 1) - 0.5 : 0.0;
+    Matrix item_local = MatrixMultiply(
+        MatrixRotateX(DEG2RAD * 90.0), MatrixTranslate(0.0, b->item_elevation, 0.0)
+    );
+    item_local = MatrixMultiply(
+        item_local, MatrixScale(b->item_scale, b->item_scale, b->item_scale)
+    );
+    for (size_t i = 0; i < b->n_items; ++i) {
+        set_scene_node_local(NODE_ITEMS + i, item_local);
+    }
+    update_scene_transforms();
 
-        rlPushMatrix();
-        {
-            rlMultMatrixf(MatrixToFloat(get_transform_matrix(t)));
-            rlScalef(b->board_scale, b->board_scale, b->board_scale);
-            rlTranslatef(x, 0.0, z);
-            rlScalef(b->item_scale, b->item_scale, b->item_scale);
-            rlTranslatef(0.0, b->item_elevation, 0.0);
-            rlRotatef(90.0, 1.0, 0.0, 0.0);
-            item->matrix = rlGetMatrixTransform();
-        }
-        rlPopMatrix();
+    for (size_t i = 0; i < b->n_items; ++i) {
+        b->item_matrices[i] = get_scene_node_world(NODE_ITEMS + i);
     }
 
     // -------------------------------------------------------------------
@@ -380,41 +559,22 @@ static void update_editor(void) {
 
     // -------------------------------------------------------------------
     // Picking
+    PROFILE_BEGIN(editor_picking);
+    sync_pickables();
+
     if (IS_LMB_PRESSED && GIZMO.state == RGIZMO_STATE_COLD) {
         unpick();
         Ray ray = GetMouseRay(MOUSE_POSITION, CAMERA);
 
-        for (size_t id = 0; id < N_COLLISION_INFOS; ++id) {
-            CollisionInfo *info = &COLLISION_INFOS[id];
-
-            Matrix matrix;
-            matrix = info->transform ? get_transform_matrix(*info->transform)
-                                     : info->matrix;
-            info->collision = GetRayCollisionMesh(ray, info->mesh, matrix);
-
-            if (!info->collision.hit) continue;
-
-            if (!PICKED_COLLISION_INFO) {
-                PICKED_COLLISION_INFO = info;
-                continue;
-            }
-
-            if (info->collision.distance < PICKED_COLLISION_INFO->collision.distance) {
-                PICKED_COLLISION_INFO = info;
-            }
-        }
+        int id = raycast_bvh(&PICKING_BVH, ray, test_pickable, NULL, NULL);
+        if (id != -1) PICKED = (PickHandle){id, PICKABLES[id].generation};
     }
+    PROFILE_END(editor_picking);
 
     // -------------------------------------------------------------------
     // Forest
-    if (IS_DELETE_PRESSED && PICKED_COLLISION_INFO->entity) {
-        for (size_t i = 0; i < SCENE.forest.n_trees; ++i) {
-            if (&SCENE.forest.trees[i] == PICKED_COLLISION_INFO->entity) {
-                delete_tree(i);
-                unpick();
-                break;
-            }
-        }
+    if (IS_DELETE_PRESSED && get_picked_entity_type() == TREE_TYPE) {
+        delete_tree(get_pickable(PICKED)->entity_id);
     }
 
     // -------------------------------------------------------------------
@@ -429,6 +589,7 @@ static void update_editor(void) {
             QuaternionFromAxisAngle(GIZMO.update.axis, GIZMO.update.angle),
             picked_transform->rotation
         );
+        sync_pickable(get_pickable(PICKED));
     }
 }
 
@@ -438,14 +599,9 @@ static void set_board_values(int n_items, int n_hits_required, int n_misses_allo
     if (n_items < 0 || n_items > MAX_N_BOARD_ITEMS) return;
     while (n_items < b->n_items) {
         b->n_items -= 1;
-        Item *item = &b->items[b->n_items];
-        UnloadTexture(item->texture);
-        *item = (Item){0};
-    }
-    while (n_items > b->n_items) {
-        Item *item = &b->items[b->n_items];
-        b->n_items += 1;
+        unload_board_item(b, b->n_items);
     }
+    b->n_items = MAX(b->n_items, n_items);
 
     n_hits_required = CLAMP(n_hits_required, 0, b->n_items);
     n_misses_allowed = CLAMP(n_misses_allowed, 0, b->n_items);
@@ -479,11 +635,10 @@ static void draw_camera_shells(void) {
 
 static void draw_item_boxes(void) {
     BoundingBox box = GetMeshBoundingBox(SCENE.board.item_mesh);
-    for (size_t i = 0; i < SCENE.board.n_items; ++i) {
-        Item *item = &SCENE.board.items[i];
-        Color color = item->is_correct ? GREEN : RED;
+    for (int i = 0; i < SCENE.board.n_items; ++i) {
+        Color color = SCENE.board.items[i].is_correct ? GREEN : RED;
         rlPushMatrix();
-        rlMultMatrixf(MatrixToFloat(item->matrix));
+        rlMultMatrixf(MatrixToFloat(SCENE.board.item_matrices[i]));
         DrawBoundingBox(box, color);
         rlPopMatrix();
     }
@@ -507,6 +662,7 @@ static void draw_imgui(void) {
             igCheckbox("WITH_SHADOWS", &WITH_SHADOWS);
             igCheckbox("WITH_BLUR", &WITH_BLUR);
             igDragInt3("CLEAR_COLOR", CLEAR_COLOR, 1, 0, 255, "%d", 0);
+            ig_render_stats();
         }
 
         if (ig_collapsing_header("Camera", true)) {
@@ -541,7 +697,7 @@ static void draw_imgui(void) {
             igInputInt("N hint items", &SCENE.board.n_hint_items, 1, 1, 0);
             for (int i = 0; i < SCENE.board.n_hint_items; ++i) {
                 if (i > 0) igSameLine(0, 5);
-                Item *item = &SCENE.board.hint_items[i];
+                HintItem *item = &SCENE.board.hint_items[i];
                 Texture2D texture = item->texture;
                 int texture_id = texture.id;
 
@@ -562,7 +718,12 @@ static void draw_imgui(void) {
 
                 if (is_clicked) {
                     load_sprite(
-                        "resources/items/sprites", item->name, 0, &item->texture, 0
+                        "resources/items/sprites",
+                        OWNER_ITEMS,
+                        item->name,
+                        0,
+                        &item->texture,
+                        0
                     );
                 }
             }
@@ -583,8 +744,10 @@ static void draw_imgui(void) {
         }
 
         if (ig_collapsing_header("Item", true) && get_picked_entity_type() == ITEM_TYPE) {
-            Item *item = get_picked_entity();
-            Texture2D texture = item->texture;
+            Board *b = &SCENE.board;
+            int idx = get_picked_entity_id();
+            Item *item = &b->items[idx];
+            Texture2D texture = b->item_textures[idx];
             int texture_id = texture.id;
 
             bool is_clicked = igImageButton(
@@ -598,7 +761,14 @@ static void draw_imgui(void) {
             );
 
             if (is_clicked) {
-                load_sprite("resources/items/sprites", item->name, 0, &item->texture, 0);
+                load_sprite(
+                    "resources/items/sprites",
+                    OWNER_ITEMS,
+                    item->name,
+                    0,
+                    &b->item_textures[idx],
+                    0
+                );
             }
 
             igSameLine(0.0, 5.0);
@@ -647,19 +817,20 @@ static void draw_imgui(void) {
             igSeparatorText("Trees");
             if (f->n_trees < MAX_N_FOREST_TREES
                 && igButton("New tree", (ImVec2){0.0, 0.0})) {
-                Tree *tree = &f->trees[f->n_trees];
+                int idx = f->n_trees;
+                Transform *transform = &f->tree_transforms[idx];
                 f->n_trees += load_sprite(
                     "resources/trees/sprites",
-                    tree->name,
-                    &tree->transform,
-                    &tree->texture,
-                    &tree->mesh
+                    OWNER_FOREST,
+                    f->tree_names[idx],
+                    transform,
+                    &f->tree_textures[idx],
+                    &f->tree_meshes[idx]
                 );
-                tree->transform.rotation = QuaternionMultiply(
-                    tree->transform.rotation,
-                    QuaternionFromEuler(DEG2RAD * 90.0, 0.0, 0.0)
+                transform->rotation = QuaternionMultiply(
+                    transform->rotation, QuaternionFromEuler(DEG2RAD * 90.0, 0.0, 0.0)
                 );
-                tree->matrix = MatrixIdentity();
+                f->tree_matrices[idx] = MatrixIdentity();
             }
             for (size_t i = 0; i < f->n_trees; ++i) {
                 igPushID_Int(IG_ID++);
@@ -667,10 +838,9 @@ static void draw_imgui(void) {
                 if (i % 3 != 0) igSameLine(0, 5);
                 igBeginGroup();
 
-                Tree *tree = &f->trees[i];
-                igText(tree->name);
+                igText(f->tree_names[i]);
 
-                Texture2D texture = tree->texture;
+                Texture2D texture = f->tree_textures[i];
                 int texture_id = texture.id;
 
                 bool is_clicked = igImageButton(
@@ -686,36 +856,22 @@ static void draw_imgui(void) {
                 if (is_clicked) {
                     load_sprite(
                         "resources/trees/sprites",
-                        tree->name,
-                        &tree->transform,
-                        &tree->texture,
-                        &tree->mesh
+                        OWNER_FOREST,
+                        f->tree_names[i],
+                        &f->tree_transforms[i],
+                        &f->tree_textures[i],
+                        &f->tree_meshes[i]
                     );
                 }
                 igSameLine(0, 3);
 
                 igBeginGroup();
-                if (igButton("Pick", (ImVec2){0.0, 0.0})) {
-                    for (size_t i = 0; i < N_COLLISION_INFOS; ++i) {
-                        CollisionInfo *info = &COLLISION_INFOS[i];
-                        if (info->entity == tree) PICKED_COLLISION_INFO = info;
-                    }
+                if (igButton("Pick", (ImVec2){0.0, 0.0}) && i < N_TREE_PICKABLES) {
+                    PICKED = TREE_PICKABLES[i];
                 }
 
                 if (igButton("Remove", (ImVec2){0.0, 0.0})) {
-                    size_t pop_idx;
-                    for (size_t i = 0; i < SCENE.forest.n_trees; ++i) {
-                        if (&SCENE.forest.trees[i] == tree) {
-                            pop_idx = i;
-                            if (PICKED_COLLISION_INFO
-                                && PICKED_COLLISION_INFO->entity == tree) {
-                                unpick();
-                            }
-                            break;
-                        };
-                    }
-
-                    delete_tree(pop_idx);
+                    delete_tree(i);
                 }
                 igEndGroup();
                 igEndGroup();
@@ -730,6 +886,7 @@ static void draw_imgui(void) {
 
 static bool load_sprite(
     const char *search_path,
+    ResourceOwner owner,
     char *dst_name,
     Transform *dst_transform,
     Texture2D *dst_texture,
@@ -738,13 +895,17 @@ static bool load_sprite(
     char *fp = open_nfd(search_path, NFD_TEXTURE_FILTER, 1);
     if (fp != NULL) {
         get_file_name(dst_name, fp, true);
-        *dst_texture = LoadTexture(fp);
-        NFD_FreePathN(fp);
 
-        if (dst_mesh) {
-            float aspect = (float)dst_texture->width / dst_texture->height;
-            *dst_mesh = GenMeshPlane(aspect, 1.0, 2, 2);
-        }
+        // Replace the previous sprite, if any
+        cancel_texture_stream(dst_texture);
+        unload_texture(*dst_texture);
+        if (dst_mesh) unload_mesh(*dst_mesh);
+
+        owner = set_resource_owner(owner);
+        SpriteData data = read_sprite_data(fp, dst_mesh != NULL);
+        stream_sprite_data(&data, fp, dst_texture, dst_mesh, NULL);
+        set_resource_owner(owner);
+        NFD_FreePathN(fp);
 
         if (dst_transform) {
             *dst_transform = get_default_transform();
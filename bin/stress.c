@@ -0,0 +1,510 @@
+#include "../src/bvh.h"
+#include "../src/jobs.h"
+#include "../src/math.h"
+#include "../src/render_queue.h"
+#include "../src/render_stats.h"
+#include "../src/scene.h"
+#include "../src/texture_stream.h"
+#include "../src/utils.h"
+#include "raylib.h"
+#include "raymath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(PLATFORM_WEB)
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#endif
+
+// Synthetic scenes for the scaling benchmarks. "generate" writes a scene with
+// the given number of items and trees, "sweep" generates the scenes for every
+// combination of the counts, runs each through the game rendering path and
+// writes the mean subsystem times per frame to a CSV:
+//
+//   stress generate --items 64 --trees 2048 --spread 6 --sprites 4
+//   stress sweep --items 1,16,64 --trees 0,256,1024,4096 --out sweep.csv
+//
+// The scenes and their forests are written to the working directory, so the
+// game doesn't list them, load_scene finds a forest next to its scene first
+#define SCREEN_WIDTH 1024
+#define SCREEN_HEIGHT 768
+
+#define ITEM_SPRITES_DIR "resources/items/sprites"
+#define TREE_SPRITES_DIR "resources/trees/sprites"
+#define DEFAULT_BASE_SCENE_FILE_PATH "resources/scenes/0000.scn"
+#define SWEEP_SCENE_NAME "stress_sweep"
+
+#define MAX_N_STRESS_SPRITES 256
+#define MAX_N_SWEEP_COUNTS 16
+#define DEFAULT_N_SWEEP_FRAMES 120
+#define MAX_N_WARMUP_FRAMES 600
+
+// Trees are scattered behind the board, between the radius and the radius
+// plus the spread
+#define TREE_RING_RADIUS 2.0
+#define TREE_ELEVATION 0.6
+
+// Picking rays are cast through a grid over the screen
+#define PICKING_GRID_SIZE 8
+#define MAX_N_PICKABLES (MAX_N_BOARD_ITEMS + MAX_N_FOREST_TREES)
+
+typedef struct StressParams {
+    int n_items;
+    int n_trees;
+    float tree_spread;
+
+    // Distinct sprites of the items and the trees, 0 uses all of them
+    int n_sprites;
+    unsigned int seed;
+} StressParams;
+
+// Mean milliseconds per frame. Sort is the render queue sort, a part of draw
+typedef struct StressTimes {
+    double transforms;
+    double snapshot;
+    double sort;
+    double picking;
+    double draw;
+    double frame;
+} StressTimes;
+
+typedef struct Pickable {
+    Mesh mesh;
+    Matrix matrix;
+} Pickable;
+
+static char BASE_SCENE_FILE_PATH[MAX_PATH_LENGTH] = DEFAULT_BASE_SCENE_FILE_PATH;
+
+static int N_ITEM_SPRITES;
+static char ITEM_SPRITE_NAMES[MAX_N_STRESS_SPRITES][MAX_NAME_LENGTH];
+static int N_TREE_SPRITES;
+static char TREE_SPRITE_NAMES[MAX_N_STRESS_SPRITES][MAX_NAME_LENGTH];
+
+// Only the names and the transforms are saved, the trees are loaded by
+// load_scene
+static Forest FOREST;
+
+static SceneSnapshot SNAPSHOT;
+static RenderTexture2D SCREEN;
+
+static BVH PICKING_BVH;
+static Pickable PICKABLES[MAX_N_PICKABLES];
+
+static int parse_counts(const char *text, int *counts);
+static int read_sprite_names(const char *dir, char names[][MAX_NAME_LENGTH]);
+static int compare_names(const void *a, const void *b);
+static float get_random_float(float min, float max);
+static void generate_stress_scene(StressParams params, const char *name);
+static bool run_sweep(
+    StressParams params,
+    const int *n_items,
+    int n_item_counts,
+    const int *n_trees,
+    int n_tree_counts,
+    int n_frames,
+    const char *file_path
+);
+static void build_picking_bvh(void);
+static float test_pickable(int id, Ray ray, void *ctx);
+static Matrix get_item_local(int idx, int frame);
+static void run_frame(int frame, StressTimes *times);
+
+int main(int argc, char **argv) {
+    static int n_items[MAX_N_SWEEP_COUNTS] = {1, 4, 16, 36, 64};
+    static int n_trees[MAX_N_SWEEP_COUNTS] = {0, 64, 256, 1024, 4096};
+    int n_item_counts = 5;
+    int n_tree_counts = 5;
+
+    StressParams params = {16, 256, 4.0, 0, 42};
+    int n_frames = DEFAULT_N_SWEEP_FRAMES;
+    const char *name = "stress";
+    const char *out_file_path = "stress_sweep.csv";
+
+    bool is_sweep = argc > 1 && strcmp(argv[1], "sweep") == 0;
+    bool is_generate = argc > 1 && strcmp(argv[1], "generate") == 0;
+    bool is_valid = is_sweep || is_generate;
+    for (int i = 2; is_valid && i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--items") == 0 && has_value) {
+            n_item_counts = parse_counts(argv[++i], n_items);
+            params.n_items = n_items[0];
+        } else if (strcmp(argv[i], "--trees") == 0 && has_value) {
+            n_tree_counts = parse_counts(argv[++i], n_trees);
+            params.n_trees = n_trees[0];
+        } else if (strcmp(argv[i], "--spread") == 0 && has_value) {
+            params.tree_spread = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--sprites") == 0 && has_value) {
+            params.n_sprites = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            params.seed = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--base") == 0 && has_value) {
+            snprintf(BASE_SCENE_FILE_PATH, MAX_PATH_LENGTH, "%s", argv[++i]);
+        } else if (strcmp(argv[i], "--name") == 0 && has_value && is_generate) {
+            name = argv[++i];
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value && is_sweep) {
+            n_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && has_value && is_sweep) {
+            out_file_path = argv[++i];
+        } else {
+            is_valid = false;
+        }
+    }
+
+    if (!is_valid || n_item_counts == 0 || n_tree_counts == 0 || n_frames < 1) {
+        TraceLog(
+            LOG_ERROR,
+            "Usage: stress generate|sweep [--items N[,N...]] [--trees N[,N...]] "
+            "[--spread F] [--sprites N] [--seed N] [--base FILE] "
+            "[--name NAME] [--frames N] [--out FILE]"
+        );
+        return 1;
+    }
+
+    N_ITEM_SPRITES = read_sprite_names(ITEM_SPRITES_DIR, ITEM_SPRITE_NAMES);
+    N_TREE_SPRITES = read_sprite_names(TREE_SPRITES_DIR, TREE_SPRITE_NAMES);
+    if (N_ITEM_SPRITES == 0 || N_TREE_SPRITES == 0) {
+        TraceLog(LOG_ERROR, "STRESS: No item or tree sprites in resources");
+        return 1;
+    }
+
+    // Nothing is shown, the frames are drawn to the screen render texture
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Stress");
+    InitAudioDevice();
+    init_jobs(DEFAULT_N_JOB_WORKERS);
+    init_core(SCREEN_WIDTH, SCREEN_HEIGHT);
+    SCREEN = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    bool is_ok = true;
+    if (is_generate) {
+        generate_stress_scene(params, name);
+    } else {
+        is_ok = run_sweep(
+            params,
+            n_items,
+            n_item_counts,
+            n_trees,
+            n_tree_counts,
+            n_frames,
+            out_file_path
+        );
+    }
+
+    UnloadRenderTexture(SCREEN);
+    unload_texture_streams();
+    unload_jobs();
+    CloseAudioDevice();
+    CloseWindow();
+    return is_ok ? 0 : 1;
+}
+
+static int parse_counts(const char *text, int *counts) {
+    static char buffer[256];
+    snprintf(buffer, sizeof(buffer), "%s", text);
+
+    int n_counts = 0;
+    char *token = strtok(buffer, ",");
+    while (token && n_counts < MAX_N_SWEEP_COUNTS) {
+        counts[n_counts++] = atoi(token);
+        token = strtok(NULL, ",");
+    }
+    return n_counts;
+}
+
+// Sorted, so the same seed gives the same scene on every machine
+static int read_sprite_names(const char *dir, char names[][MAX_NAME_LENGTH]) {
+    if (!DirectoryExists(dir)) return 0;
+
+    int n_file_names;
+    char **file_names = get_file_names_in_dir(dir, &n_file_names);
+    int n_names = 0;
+    for (int i = 0; i < n_file_names; ++i) {
+        if (IsFileExtension(file_names[i], ".png") && n_names < MAX_N_STRESS_SPRITES) {
+            get_file_name(names[n_names++], file_names[i], true);
+        }
+        free(file_names[i]);
+    }
+    free(file_names);
+
+    qsort(names, n_names, MAX_NAME_LENGTH, compare_names);
+    return n_names;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp((const char *)a, (const char *)b);
+}
+
+static float get_random_float(float min, float max) {
+    return min + (max - min) * ((float)rand() / RAND_MAX);
+}
+
+// The camera, the golova and the board are taken from the base scene. Items are
+// limited by the board grid (MAX_N_BOARD_ITEMS), trees by MAX_N_FOREST_TREES
+static void generate_stress_scene(StressParams params, const char *name) {
+    static char fp[2048];
+    srand(params.seed);
+
+    int n_items = params.n_items < 0 ? 0 : params.n_items;
+    int n_trees = params.n_trees < 0 ? 0 : params.n_trees;
+    if (n_items > MAX_N_BOARD_ITEMS) n_items = MAX_N_BOARD_ITEMS;
+    if (n_trees > MAX_N_FOREST_TREES) n_trees = MAX_N_FOREST_TREES;
+    if (n_items != params.n_items || n_trees != params.n_trees) {
+        TraceLog(
+            LOG_WARNING, "STRESS: Clamped to %d items and %d trees", n_items, n_trees
+        );
+    }
+
+    int n_item_sprites = N_ITEM_SPRITES;
+    int n_tree_sprites = N_TREE_SPRITES;
+    if (params.n_sprites > 0 && params.n_sprites < n_item_sprites) {
+        n_item_sprites = params.n_sprites;
+    }
+    if (params.n_sprites > 0 && params.n_sprites < n_tree_sprites) {
+        n_tree_sprites = params.n_sprites;
+    }
+
+    load_scene(BASE_SCENE_FILE_PATH);
+
+    // -------------------------------------------------------------------
+    // Forest
+    snprintf(FOREST.name, sizeof(FOREST.name), "%s", name);
+    FOREST.n_trees = n_trees;
+    Quaternion tree_rotation = QuaternionFromAxisAngle((Vector3){1.0, 0.0, 0.0}, PI / 2);
+    for (int i = 0; i < n_trees; ++i) {
+        const char *sprite_name = TREE_SPRITE_NAMES[rand() % n_tree_sprites];
+        snprintf(FOREST.tree_names[i], MAX_NAME_LENGTH, "%s", sprite_name);
+
+        float angle = get_random_float(PI, 2.0 * PI);
+        float radius = TREE_RING_RADIUS + get_random_float(0.0, params.tree_spread);
+        Transform *transform = &FOREST.tree_transforms[i];
+        *transform = get_default_transform();
+        transform->translation = (Vector3){
+            radius * cosf(angle), TREE_ELEVATION, radius * sinf(angle)};
+        transform->rotation = tree_rotation;
+    }
+    sprintf(fp, "%s.fst", name);
+    save_forest(&FOREST, fp);
+
+    // -------------------------------------------------------------------
+    // Board items, every other one is correct
+    Board *b = &SCENE.board;
+    b->n_items = n_items;
+    b->n_hint_items = 0;
+    for (int i = 0; i < n_items; ++i) {
+        Item *item = &b->items[i];
+        const char *sprite_name = ITEM_SPRITE_NAMES[i % n_item_sprites];
+        snprintf(item->name, sizeof(item->name), "%s", sprite_name);
+        item->is_correct = i % 2 == 0;
+        set_scene_node_local(NODE_ITEMS + i, get_item_local(i, 0));
+    }
+    update_scene_transforms();
+    for (int i = 0; i < n_items; ++i) {
+        b->item_matrices[i] = get_scene_node_world(NODE_ITEMS + i);
+    }
+
+    int n_correct = (n_items + 1) / 2;
+    if (b->n_hits_required > n_correct) b->n_hits_required = n_correct;
+    snprintf(SCENE.forest.name, sizeof(SCENE.forest.name), "%s", name);
+    sprintf(fp, "%s.scn", name);
+    save_scene(fp);
+
+    TraceLog(
+        LOG_INFO,
+        "STRESS: Generated %s with %d items and %d trees, %d/%d sprites",
+        fp,
+        n_items,
+        n_trees,
+        n_item_sprites,
+        n_tree_sprites
+    );
+}
+
+static bool run_sweep(
+    StressParams params,
+    const int *n_items,
+    int n_item_counts,
+    const int *n_trees,
+    int n_tree_counts,
+    int n_frames,
+    const char *file_path
+) {
+    static char scene_file_path[MAX_PATH_LENGTH];
+    static char forest_file_path[MAX_PATH_LENGTH];
+    sprintf(scene_file_path, "%s.scn", SWEEP_SCENE_NAME);
+    sprintf(forest_file_path, "%s.fst", SWEEP_SCENE_NAME);
+
+    FILE *f = fopen(file_path, "w");
+    if (f == NULL) {
+        TraceLog(LOG_ERROR, "STRESS: Failed to open %s", file_path);
+        return false;
+    }
+    fprintf(
+        f,
+        "n_items,n_trees,load_ms,transforms_ms,snapshot_ms,sort_ms,picking_ms,"
+        "draw_ms,frame_ms,draw_calls,texture_binds,shader_switches,location_lookups,"
+        "uniform_uploads,batch_flushes\n"
+    );
+
+    int frame = 0;
+    for (int i = 0; i < n_item_counts; ++i) {
+        for (int j = 0; j < n_tree_counts; ++j) {
+            params.n_items = n_items[i];
+            params.n_trees = n_trees[j];
+            generate_stress_scene(params, SWEEP_SCENE_NAME);
+
+            // The scene is loaded the way the game loads it
+            double time = GetTime();
+            load_scene(scene_file_path);
+            double load_time = (GetTime() - time) * 1000.0;
+
+            // Streamed textures are replaced by the full ones, then the frames
+            // are measured in the steady state
+            StressTimes times = {0};
+            for (int k = 0; k < MAX_N_WARMUP_FRAMES; ++k) {
+                run_frame(frame++, &times);
+                if (get_texture_stream_stats().n_streams == 0) break;
+            }
+
+            build_picking_bvh();
+            times = (StressTimes){0};
+            for (int k = 0; k < n_frames; ++k) run_frame(frame++, &times);
+            unload_bvh(&PICKING_BVH);
+
+            times.transforms /= n_frames;
+            times.snapshot /= n_frames;
+            times.sort /= n_frames;
+            times.picking /= n_frames;
+            times.draw /= n_frames;
+            times.frame /= n_frames;
+
+            // The counters don't change between the steady frames, so the
+            // last one stands for all of them
+            RenderCounters counters = get_render_stats().total;
+
+            fprintf(
+                f,
+                "%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d,%d\n",
+                SCENE.board.n_items,
+                SCENE.forest.n_trees,
+                load_time,
+                times.transforms,
+                times.snapshot,
+                times.sort,
+                times.picking,
+                times.draw,
+                times.frame,
+                counters.n_draw_calls,
+                counters.n_texture_binds,
+                counters.n_shader_switches,
+                counters.n_location_lookups,
+                counters.n_uniform_uploads,
+                counters.n_batch_flushes
+            );
+            TraceLog(
+                LOG_INFO,
+                "STRESS: %d items, %d trees: %.2f ms per frame",
+                SCENE.board.n_items,
+                SCENE.forest.n_trees,
+                times.frame
+            );
+            log_render_stats();
+        }
+    }
+
+    fclose(f);
+    remove(scene_file_path);
+    remove(forest_file_path);
+    TraceLog(LOG_INFO, "STRESS: Saved the sweep to %s", file_path);
+    return true;
+}
+
+// Mesh boxes of the items and the trees, as the editor picks them
+static void build_picking_bvh(void) {
+    init_bvh(&PICKING_BVH);
+
+    int n_pickables = 0;
+    Board *b = &SCENE.board;
+    for (int i = 0; i < b->n_items; ++i) {
+        PICKABLES[n_pickables++] = (Pickable){b->item_mesh, b->item_matrices[i]};
+    }
+
+    Forest *forest = &SCENE.forest;
+    for (int i = 0; i < forest->n_trees; ++i) {
+        Matrix matrix = get_transform_matrix(forest->tree_transforms[i]);
+        PICKABLES[n_pickables++] = (Pickable){forest->tree_meshes[i], matrix};
+    }
+
+    for (int i = 0; i < n_pickables; ++i) {
+        Pickable *pickable = &PICKABLES[i];
+        BoundingBox box = {0};
+        if (pickable->mesh.vertices) box = GetMeshBoundingBox(pickable->mesh);
+        box = get_transformed_box(box, pickable->matrix);
+        insert_bvh_leaf(&PICKING_BVH, box, i);
+    }
+}
+
+static float test_pickable(int id, Ray ray, void *ctx) {
+    Pickable *pickable = &PICKABLES[id];
+    RayCollision collision = GetRayCollisionMesh(ray, pickable->mesh, pickable->matrix);
+    return collision.hit ? collision.distance : -1.0;
+}
+
+// Items bob like the hot items of the game, so the item transforms and the
+// shadow mask are updated on every frame
+static Matrix get_item_local(int idx, int frame) {
+    Board *b = &SCENE.board;
+    float lift = 0.05 * sinf(0.1 * frame + idx);
+    Matrix local = MatrixMultiply(
+        MatrixRotateX(DEG2RAD * 90.0),
+        MatrixTranslate(0.0, b->item_elevation + lift, 0.0)
+    );
+    float scale = b->item_scale;
+    return MatrixMultiply(local, MatrixScale(scale, scale, scale));
+}
+
+// The sorting time is the render queue sort of draw_scene, as the queue
+// measures it. Drawing waits for the GPU
+static void run_frame(int frame, StressTimes *times) {
+    double frame_time = GetTime();
+    update_main_thread_jobs();
+    update_texture_streams();
+
+    double time = GetTime();
+    for (int i = 0; i < SCENE.board.n_items; ++i) {
+        set_scene_node_local(NODE_ITEMS + i, get_item_local(i, frame));
+    }
+    update_scene_transforms();
+    times->transforms += (GetTime() - time) * 1000.0;
+
+    time = GetTime();
+    capture_scene_snapshot(&SNAPSHOT);
+    times->snapshot += (GetTime() - time) * 1000.0;
+
+    time = GetTime();
+    if (PICKING_BVH.nodes) {
+        for (int y = 0; y < PICKING_GRID_SIZE; ++y) {
+            for (int x = 0; x < PICKING_GRID_SIZE; ++x) {
+                Vector2 position = {
+                    (x + 0.5) * SCREEN_WIDTH / PICKING_GRID_SIZE,
+                    (y + 0.5) * SCREEN_HEIGHT / PICKING_GRID_SIZE};
+                Ray ray = GetMouseRay(position, SCENE.camera);
+                raycast_bvh(&PICKING_BVH, ray, test_pickable, NULL, NULL);
+            }
+        }
+    }
+    times->picking += (GetTime() - time) * 1000.0;
+
+    time = GetTime();
+    BeginDrawing();
+    draw_scene(&SNAPSHOT, SCREEN, BLACK, SNAPSHOT.camera, SHADOWS_MEDIUM, true, true);
+    EndDrawing();
+    end_render_frame();
+    glFinish();
+    times->draw += (GetTime() - time) * 1000.0;
+    times->sort += get_render_queue_stats().sort_ms;
+
+    times->frame += (GetTime() - frame_time) * 1000.0;
+}
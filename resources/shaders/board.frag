@@ -1,19 +1,21 @@
+#pragma features WITH_SHADOWS
+
+#ifdef WITH_SHADOWS
 in vec2 shadow_uv;
+#endif
 in vec2 fragTexCoord;
 in vec4 fragColor;
 
 uniform sampler2D texture0;
 uniform vec4 colDiffuse;
 
-uniform bool u_with_shadows;
-
 out vec4 finalColor;
 
 void main() {
     float shadow = 0.0;
-    if (u_with_shadows) {
-        shadow = blur_texture(texture0, shadow_uv).a;
-    }
+#ifdef WITH_SHADOWS
+    shadow = texture(texture0, shadow_uv).r;
+#endif
 
     vec2 uv = fragTexCoord;
     vec3 color;
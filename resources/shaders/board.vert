@@ -1,3 +1,5 @@
+#pragma features WITH_SHADOWS
+
 // Input vertex attributes
 in vec3 vertexPosition;
 in vec2 vertexTexCoord;
@@ -7,10 +9,14 @@ in vec4 vertexColor;
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matModel;
+#ifdef WITH_SHADOWS
 uniform mat4 u_light_vp;
+#endif
 
 // Output vertex attributes (to fragment shader)
+#ifdef WITH_SHADOWS
 out vec2 shadow_uv;
+#endif
 out vec2 fragTexCoord;
 out vec4 fragColor;
 
@@ -21,10 +27,12 @@ void main() {
     fragTexCoord = vertexTexCoord;
     fragColor = vertexColor;
 
+#ifdef WITH_SHADOWS
     // Get shadowmap gl position
     vec4 shadow_gl_position = matModel * u_light_vp * vec4(vertexPosition, 1.0);
     vec2 shadow_screen_position = shadow_gl_position.xy / shadow_gl_position.w;
     shadow_uv = (shadow_screen_position + 1.0) / 2.0;
+#endif
 
     // Calculate final vertex position
     gl_Position = mvp * vec4(vertexPosition, 1.0);
@@ -1,9 +1,13 @@
+#pragma features WITH_BORDER
+
 in vec2 fragTexCoord;
 in vec4 fragColor;
 
 uniform sampler2D texture0;
 uniform vec4 colDiffuse;
+#ifdef WITH_BORDER
 uniform vec4 u_border_color;
+#endif
 
 out vec4 finalColor;
 
@@ -11,12 +15,17 @@ void main() {
     vec4 tex_color;
 
     vec2 uv = fragTexCoord;
+#ifdef WITH_BORDER
     bool is_border = min(uv.x, uv.y) <= 0.05 || max(uv.x, uv.y) >= 0.95;
-    if (is_border && u_border_color.a > 0.0) {
+    if (is_border) {
         tex_color = u_border_color;
     } else {
         tex_color = texture(texture0, uv);
     }
+#else
+    bool is_border = false;
+    tex_color = texture(texture0, uv);
+#endif
 
     if (tex_color.a < 0.01) {
         discard;
@@ -0,0 +1,25 @@
+// Per-pixel post-processing effects. The postfx passes are generated to call
+// only the enabled ones, each function is named after its effect type
+
+vec3 dim(vec3 color, vec2 uv, float strength, vec3 tint) {
+    return color * strength;
+}
+
+vec3 vignette(vec3 color, vec2 uv, float strength, vec3 tint) {
+    vec2 d = uv - 0.5;
+    float k = clamp(1.0 - 2.0 * strength * dot(d, d), 0.0, 1.0);
+    return color * k;
+}
+
+vec3 color_grade(vec3 color, vec2 uv, float strength, vec3 tint) {
+    float luma = dot(color, vec3(0.299, 0.587, 0.114));
+    return mix(vec3(luma), color, strength) * tint;
+}
+
+vec3 flash(vec3 color, vec2 uv, float strength, vec3 tint) {
+    return color + tint * strength;
+}
+
+vec3 fade(vec3 color, vec2 uv, float strength, vec3 tint) {
+    return mix(color, tint, strength);
+}
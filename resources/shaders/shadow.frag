@@ -0,0 +1,14 @@
+in vec2 fragTexCoord;
+
+uniform sampler2D texture0;
+
+out vec4 finalColor;
+
+// Coverage of the item sprite, the shadow mask keeps it in the red channel
+void main() {
+    float a = texture(texture0, fragTexCoord).a;
+    if (a < 0.01) discard;
+    if (a > 0.1) a = 1.0;
+
+    finalColor = vec4(1.0, 1.0, 1.0, a);
+}
@@ -0,0 +1,19 @@
+in vec2 fragTexCoord;
+
+uniform sampler2D texture0;
+uniform vec2 u_direction;
+
+out vec4 finalColor;
+
+// One direction of the separable shadow mask blur, u_direction is a texel step
+void main() {
+    vec2 uv = fragTexCoord;
+
+    float shadow = texture(texture0, uv).r * weight[0];
+    for (int i = 1; i < 3; i++) {
+        shadow += texture(texture0, uv + offset[i] * u_direction).r * weight[i];
+        shadow += texture(texture0, uv - offset[i] * u_direction).r * weight[i];
+    }
+
+    finalColor = vec4(shadow, shadow, shadow, 1.0);
+}
@@ -0,0 +1,206 @@
+#include "assets.h"
+
+#include "raylib.h"
+#include "scene.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(PLATFORM_WEB)
+#include <emscripten/emscripten.h>
+#include <emscripten/fetch.h>
+#include <sys/stat.h>
+#endif
+
+#define MAX_N_SCENE_ASSETS (4 * MAX_N_BOARD_ITEMS)
+
+typedef enum AssetState {
+    ASSET_PENDING = 0,
+    ASSET_READY,
+    ASSET_FAILED,
+} AssetState;
+
+typedef struct Asset {
+    char path[MAX_PATH_LENGTH];
+    AssetState state;
+} Asset;
+
+static int N_ASSETS;
+static Asset ASSETS[MAX_N_ASSETS];
+static AssetFetchStats STATS;
+
+static char SCENE_ASSET_PATHS[MAX_N_SCENE_ASSETS][MAX_PATH_LENGTH];
+
+static int request_asset(const char *path);
+static int find_asset(const char *path);
+static double get_now_ms(void);
+
+#if defined(PLATFORM_WEB)
+static void start_fetch(int asset, bool from_cache);
+static void on_fetch_success(emscripten_fetch_t *fetch);
+static void on_fetch_error(emscripten_fetch_t *fetch);
+static bool write_memfs_file(const char *path, const char *data, long n_bytes);
+#endif
+
+void request_scene_assets(const char *scene_file_path) {
+    int n = get_scene_asset_paths(scene_file_path, SCENE_ASSET_PATHS, MAX_N_SCENE_ASSETS);
+    for (int i = 0; i < n; ++i) request_asset(SCENE_ASSET_PATHS[i]);
+}
+
+bool is_scene_assets_ready(const char *scene_file_path) {
+    int n = get_scene_asset_paths(scene_file_path, SCENE_ASSET_PATHS, MAX_N_SCENE_ASSETS);
+    for (int i = 0; i < n; ++i) {
+        int asset = request_asset(SCENE_ASSET_PATHS[i]);
+        if (asset != -1 && ASSETS[asset].state == ASSET_PENDING) return false;
+    }
+    return true;
+}
+
+void mark_first_frame(void) {
+    if (STATS.time_to_first_frame > 0.0) return;
+
+    STATS.time_to_first_frame = get_now_ms();
+    TraceLog(
+        LOG_INFO,
+        "ASSETS: First frame after %.1f ms, fetched %ld bytes (%d files), %ld bytes "
+        "from cache (%d files)",
+        STATS.time_to_first_frame,
+        STATS.n_bytes_from_network,
+        STATS.n_from_network,
+        STATS.n_bytes_from_cache,
+        STATS.n_from_cache
+    );
+}
+
+AssetFetchStats get_asset_fetch_stats(void) {
+#if defined(PLATFORM_WEB)
+    STATS.is_lazy = true;
+#endif
+    return STATS;
+}
+
+// Returns the asset index, or -1 if the file is already available and
+// doesn't need to be tracked
+static int request_asset(const char *path) {
+    int asset = find_asset(path);
+    if (asset != -1) return asset;
+    if (FileExists(path)) return -1;
+
+    if (N_ASSETS == MAX_N_ASSETS) {
+        TraceLog(LOG_WARNING, "ASSETS: Too many assets, can't fetch %s", path);
+        return -1;
+    }
+
+    asset = N_ASSETS++;
+    strncpy(ASSETS[asset].path, path, MAX_PATH_LENGTH - 1);
+    STATS.n_requested += 1;
+
+#if defined(PLATFORM_WEB)
+    ASSETS[asset].state = ASSET_PENDING;
+    STATS.n_pending += 1;
+    start_fetch(asset, true);
+#else
+    ASSETS[asset].state = ASSET_FAILED;
+    STATS.n_failed += 1;
+#endif
+
+    return asset;
+}
+
+static int find_asset(const char *path) {
+    for (int i = 0; i < N_ASSETS; ++i) {
+        if (strcmp(ASSETS[i].path, path) == 0) return i;
+    }
+    return -1;
+}
+
+static double get_now_ms(void) {
+#if defined(PLATFORM_WEB)
+    // performance.now(), counted from the start of the page navigation, so it
+    // includes the download of the boot bundle
+    return emscripten_get_now();
+#else
+    return GetTime() * 1000.0;
+#endif
+}
+
+#if defined(PLATFORM_WEB)
+// The cache is looked up first, and only on a miss the file is downloaded and
+// persisted, so the stats can tell the network bytes from the cached ones
+static void start_fetch(int asset, bool from_cache) {
+    emscripten_fetch_attr_t attr;
+    emscripten_fetch_attr_init(&attr);
+    strcpy(attr.requestMethod, "GET");
+    attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY | EMSCRIPTEN_FETCH_PERSIST_FILE;
+    if (from_cache) attr.attributes |= EMSCRIPTEN_FETCH_NO_DOWNLOAD;
+    else attr.attributes |= EMSCRIPTEN_FETCH_REPLACE;
+    attr.userData = (void *)(intptr_t)(from_cache ? -(asset + 1) : asset + 1);
+    attr.onsuccess = on_fetch_success;
+    attr.onerror = on_fetch_error;
+    emscripten_fetch(&attr, ASSETS[asset].path);
+}
+
+static void on_fetch_success(emscripten_fetch_t *fetch) {
+    int tag = (int)(intptr_t)fetch->userData;
+    bool from_cache = tag < 0;
+    Asset *asset = &ASSETS[(from_cache ? -tag : tag) - 1];
+
+    long n_bytes = (long)fetch->numBytes;
+    if (write_memfs_file(asset->path, fetch->data, n_bytes)) {
+        asset->state = ASSET_READY;
+        if (from_cache) {
+            STATS.n_from_cache += 1;
+            STATS.n_bytes_from_cache += n_bytes;
+        } else {
+            STATS.n_from_network += 1;
+            STATS.n_bytes_from_network += n_bytes;
+        }
+    } else {
+        asset->state = ASSET_FAILED;
+        STATS.n_failed += 1;
+    }
+
+    STATS.n_pending -= 1;
+    emscripten_fetch_close(fetch);
+}
+
+static void on_fetch_error(emscripten_fetch_t *fetch) {
+    int tag = (int)(intptr_t)fetch->userData;
+    bool from_cache = tag < 0;
+    int asset = (from_cache ? -tag : tag) - 1;
+    emscripten_fetch_close(fetch);
+
+    // Cache miss, go to the network
+    if (from_cache) {
+        start_fetch(asset, false);
+        return;
+    }
+
+    TraceLog(LOG_WARNING, "ASSETS: Failed to fetch %s", ASSETS[asset].path);
+    ASSETS[asset].state = ASSET_FAILED;
+    STATS.n_failed += 1;
+    STATS.n_pending -= 1;
+}
+
+static bool write_memfs_file(const char *path, const char *data, long n_bytes) {
+    // Create the parent directories, the boot bundle doesn't have them
+    static char dir[MAX_PATH_LENGTH];
+    strcpy(dir, path);
+    for (char *c = dir + 1; *c; ++c) {
+        if (*c != '/') continue;
+        *c = '\0';
+        mkdir(dir, 0777);
+        *c = '/';
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        TraceLog(LOG_WARNING, "ASSETS: Failed to write %s", path);
+        return false;
+    }
+
+    fwrite(data, 1, n_bytes, f);
+    fclose(f);
+    return true;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Lazy asset fetching. The web build only bundles what is needed to boot the
+// game, the item sprites and sounds of each scene are fetched on demand into
+// the in-memory file system under their resource paths, so the loaders don't
+// know the difference. Fetched files are persisted in IndexedDB and served
+// from there on the next visit. On desktop every file is already on disk
+#define MAX_N_ASSETS 1024
+
+typedef struct AssetFetchStats {
+    bool is_lazy;
+    int n_requested;
+    int n_pending;
+    int n_from_network;
+    int n_from_cache;
+    int n_failed;
+    long n_bytes_from_network;
+    long n_bytes_from_cache;
+
+    // Milliseconds since the page (or the process) started
+    double time_to_first_frame;
+} AssetFetchStats;
+
+// Start fetching all files of the scene which are not available yet
+void request_scene_assets(const char *scene_file_path);
+
+// True when every file of the scene is either available or failed to fetch
+bool is_scene_assets_ready(const char *scene_file_path);
+
+void mark_first_frame(void);
+AssetFetchStats get_asset_fetch_stats(void);
@@ -0,0 +1,418 @@
+#include "audio.h"
+
+#include "math.h"
+#include "raylib.h"
+#include "resources.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(PLATFORM_WEB)
+#include <pthread.h>
+#endif
+
+static unsigned char *BANK_DATA;
+static int N_BANK_SOUNDS;
+static SoundBankEntry *BANK_SOUNDS;
+static unsigned char *BANK_PCM;
+static int BANK_PCM_SIZE;
+
+typedef struct Voice {
+    Sound alias;
+    bool is_alias_loaded;
+
+    // Buffer of the source sound the alias shares the samples with
+    void *source;
+    SoundCategory category;
+    unsigned int play_id;
+} Voice;
+
+static int MAX_VOICES = DEFAULT_N_VOICES;
+static Voice VOICES[MAX_N_VOICES];
+static unsigned int N_PLAYED_VOICES;
+static int N_STOLEN_VOICES;
+static int N_DROPPED_VOICES;
+static int CATEGORY_PRIORITIES[N_SOUND_CATEGORIES] = {
+    [SOUND_TOUCH] = 0, [SOUND_ITEM] = 1, [SOUND_RESULT] = 2};
+
+static bool is_voice_active(Voice *voice);
+static void release_voice(Voice *voice);
+
+// Queue indices grow monotonically and wrap through the mask. The head is
+// written by the feeder only, the tail by the main thread only
+static MusicCommand MUSIC_COMMANDS[MUSIC_COMMAND_QUEUE_SIZE];
+static unsigned int MUSIC_COMMANDS_HEAD;
+static unsigned int MUSIC_COMMANDS_TAIL;
+
+// Owned by the feeder
+static Music FEEDER_MUSIC;
+static bool IS_FEEDER_MUSIC_LOADED;
+static bool IS_FEEDER_MUSIC_PLAYING;
+static double LAST_REFILL_TIME;
+
+// Written by the feeder, read by the main thread
+static int N_MUSIC_REFILLS;
+static int N_MUSIC_UNDERRUNS;
+static float MUSIC_FILL_LEVEL;
+static float MIN_MUSIC_FILL_LEVEL = 1.0;
+
+// Written by the main thread only
+static int N_DROPPED_MUSIC_COMMANDS;
+
+#if !defined(PLATFORM_WEB)
+static pthread_t FEEDER_THREAD;
+static bool IS_FEEDER_RUNNING;
+#endif
+static bool IS_FEEDER_THREADED;
+
+static double get_monotonic_time(void);
+static bool pop_music_command(MusicCommand *command);
+static void apply_music_command(MusicCommand command);
+static void feed_music(void);
+#if !defined(PLATFORM_WEB)
+static void *run_music_feeder(void *arg);
+#endif
+
+void load_sound_bank(const char *file_path) {
+    unload_sound_bank();
+    if (!FileExists(file_path)) {
+        TraceLog(LOG_WARNING, "Sound bank %s not found, decoding sounds", file_path);
+        return;
+    }
+
+    int n_bytes;
+    unsigned char *data = LoadFileData(file_path, &n_bytes);
+    int header_size = 4 + sizeof(int);
+    if (data == NULL || n_bytes < header_size
+        || memcmp(data, SOUND_BANK_MAGIC, 4) != 0) {
+        TraceLog(LOG_ERROR, "Failed to load sound bank %s", file_path);
+        if (data) UnloadFileData(data);
+        return;
+    }
+
+    int n_sounds;
+    memcpy(&n_sounds, data + 4, sizeof(int));
+    int index_size = n_sounds * sizeof(SoundBankEntry);
+    if (n_sounds < 0 || n_sounds > MAX_N_BANK_SOUNDS
+        || header_size + index_size > n_bytes) {
+        TraceLog(LOG_ERROR, "Sound bank %s is corrupted", file_path);
+        UnloadFileData(data);
+        return;
+    }
+
+    BANK_DATA = data;
+    N_BANK_SOUNDS = n_sounds;
+    BANK_SOUNDS = (SoundBankEntry *)(data + header_size);
+    BANK_PCM = data + header_size + index_size;
+    BANK_PCM_SIZE = n_bytes - header_size - index_size;
+    TraceLog(LOG_INFO, "Sound bank %s loaded: %d sounds", file_path, n_sounds);
+}
+
+void unload_sound_bank(void) {
+    if (BANK_DATA) UnloadFileData(BANK_DATA);
+    BANK_DATA = NULL;
+    BANK_SOUNDS = NULL;
+    BANK_PCM = NULL;
+    BANK_PCM_SIZE = 0;
+    N_BANK_SOUNDS = 0;
+}
+
+Sound load_sound(const char *file_path) {
+    SoundData data = read_sound_data(file_path);
+    return upload_sound_data(&data, file_path);
+}
+
+SoundData read_sound_data(const char *file_path) {
+    SoundData data = {0};
+    for (int i = 0; i < N_BANK_SOUNDS; ++i) {
+        SoundBankEntry *entry = &BANK_SOUNDS[i];
+        if (strcmp(entry->name, file_path) != 0) continue;
+
+        unsigned int size = entry->frame_count * entry->channels
+                            * SOUND_BANK_SAMPLE_SIZE / 8;
+        if ((unsigned long)entry->offset + size > (unsigned long)BANK_PCM_SIZE) break;
+
+        // The bank keeps owning the samples
+        data.wave = (Wave){
+            .frameCount = entry->frame_count,
+            .sampleRate = entry->sample_rate,
+            .sampleSize = SOUND_BANK_SAMPLE_SIZE,
+            .channels = entry->channels,
+            .data = BANK_PCM + entry->offset};
+        return data;
+    }
+
+    data.wave = LoadWave(file_path);
+    data.is_owned = true;
+    return data;
+}
+
+Sound upload_sound_data(SoundData *data, const char *file_path) {
+    // LoadSoundFromWave copies the samples
+    Sound sound = LoadSoundFromWave(data->wave);
+    if (data->is_owned) UnloadWave(data->wave);
+    *data = (SoundData){0};
+    return track_sound(sound, file_path);
+}
+
+Music load_music(const char *file_path) {
+    static char cooked_path[2048];
+    get_cooked_music_path(cooked_path, file_path);
+    if (!FileExists(cooked_path)) strcpy(cooked_path, file_path);
+
+    // Fixed buffer size makes the fill level and underruns measurable
+    SetAudioStreamBufferSizeDefault(MUSIC_STREAM_BUFFER_FRAMES);
+    Music music = LoadMusicStream(cooked_path);
+    SetAudioStreamBufferSizeDefault(0);
+    return music;
+}
+
+void get_cooked_music_path(char *dst, const char *file_path) {
+    const char *ext = strrchr(file_path, '.');
+    int n = ext ? (int)(ext - file_path) : (int)strlen(file_path);
+    sprintf(dst, "%.*s.qoa", n, file_path);
+}
+
+void init_voice_pool(int max_voices) {
+    unload_voice_pool();
+    MAX_VOICES = CLAMP(max_voices, 1, MAX_N_VOICES);
+    N_PLAYED_VOICES = 0;
+    N_STOLEN_VOICES = 0;
+    N_DROPPED_VOICES = 0;
+}
+
+void unload_voice_pool(void) {
+    for (int i = 0; i < MAX_N_VOICES; ++i) release_voice(&VOICES[i]);
+}
+
+void set_sound_category_priority(SoundCategory category, int priority) {
+    CATEGORY_PRIORITIES[category] = priority;
+}
+
+bool play_voice(Sound sound, SoundCategory category) {
+    if (!IsSoundReady(sound)) return false;
+
+    // Prefer an idle voice which already aliases this sound, then any idle one
+    Voice *voice = NULL;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        Voice *candidate = &VOICES[i];
+        if (is_voice_active(candidate)) continue;
+        if (candidate->is_alias_loaded && candidate->source == sound.stream.buffer) {
+            voice = candidate;
+            break;
+        }
+        if (!voice) voice = candidate;
+    }
+
+    // Steal the oldest voice among the lowest priority ones
+    if (!voice) {
+        int priority = CATEGORY_PRIORITIES[category];
+        for (int i = 0; i < MAX_VOICES; ++i) {
+            Voice *candidate = &VOICES[i];
+            int candidate_priority = CATEGORY_PRIORITIES[candidate->category];
+            if (candidate_priority > priority) continue;
+            if (!voice || candidate_priority < CATEGORY_PRIORITIES[voice->category]
+                || (candidate_priority == CATEGORY_PRIORITIES[voice->category]
+                    && candidate->play_id < voice->play_id)) {
+                voice = candidate;
+            }
+        }
+
+        if (!voice) {
+            N_DROPPED_VOICES += 1;
+            return false;
+        }
+        StopSound(voice->alias);
+        N_STOLEN_VOICES += 1;
+    }
+
+    if (!voice->is_alias_loaded || voice->source != sound.stream.buffer) {
+        release_voice(voice);
+        voice->alias = LoadSoundAlias(sound);
+        voice->is_alias_loaded = true;
+        voice->source = sound.stream.buffer;
+    }
+
+    voice->category = category;
+    voice->play_id = N_PLAYED_VOICES++;
+    PlaySound(voice->alias);
+    return true;
+}
+
+void stop_sound_voices(Sound sound) {
+    for (int i = 0; i < MAX_N_VOICES; ++i) {
+        Voice *voice = &VOICES[i];
+        if (voice->is_alias_loaded && voice->source == sound.stream.buffer) {
+            release_voice(voice);
+        }
+    }
+}
+
+VoicePoolStats get_voice_pool_stats(void) {
+    VoicePoolStats stats = {0};
+    stats.max_voices = MAX_VOICES;
+    stats.n_stolen = N_STOLEN_VOICES;
+    stats.n_dropped = N_DROPPED_VOICES;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        Voice *voice = &VOICES[i];
+        if (!is_voice_active(voice)) continue;
+        stats.n_active += 1;
+        stats.n_active_by_category[voice->category] += 1;
+    }
+    return stats;
+}
+
+static bool is_voice_active(Voice *voice) {
+    return voice->is_alias_loaded && IsSoundPlaying(voice->alias);
+}
+
+static void release_voice(Voice *voice) {
+    if (voice->is_alias_loaded) {
+        StopSound(voice->alias);
+        UnloadSoundAlias(voice->alias);
+    }
+    *voice = (Voice){0};
+}
+
+void init_music_feeder(Music music) {
+    unload_music_feeder();
+
+    FEEDER_MUSIC = music;
+    IS_FEEDER_MUSIC_LOADED = true;
+    IS_FEEDER_MUSIC_PLAYING = false;
+
+#if !defined(PLATFORM_WEB)
+    __atomic_store_n(&IS_FEEDER_RUNNING, true, __ATOMIC_RELEASE);
+    int status = pthread_create(&FEEDER_THREAD, NULL, run_music_feeder, NULL);
+    IS_FEEDER_THREADED = status == 0;
+    if (!IS_FEEDER_THREADED) {
+        TraceLog(LOG_WARNING, "Failed to start music feeder thread, feeding on main");
+    }
+#endif
+}
+
+void unload_music_feeder(void) {
+#if !defined(PLATFORM_WEB)
+    if (IS_FEEDER_THREADED) {
+        __atomic_store_n(&IS_FEEDER_RUNNING, false, __ATOMIC_RELEASE);
+        pthread_join(FEEDER_THREAD, NULL);
+    }
+#endif
+    IS_FEEDER_THREADED = false;
+
+    if (IS_FEEDER_MUSIC_LOADED) UnloadMusicStream(FEEDER_MUSIC);
+    IS_FEEDER_MUSIC_LOADED = false;
+    IS_FEEDER_MUSIC_PLAYING = false;
+    MUSIC_COMMANDS_HEAD = 0;
+    MUSIC_COMMANDS_TAIL = 0;
+}
+
+bool push_music_command(MusicCommandType type, float value) {
+    unsigned int tail = __atomic_load_n(&MUSIC_COMMANDS_TAIL, __ATOMIC_RELAXED);
+    unsigned int head = __atomic_load_n(&MUSIC_COMMANDS_HEAD, __ATOMIC_ACQUIRE);
+    if (tail - head == MUSIC_COMMAND_QUEUE_SIZE) {
+        N_DROPPED_MUSIC_COMMANDS += 1;
+        return false;
+    }
+
+    MusicCommand *command = &MUSIC_COMMANDS[tail % MUSIC_COMMAND_QUEUE_SIZE];
+    command->type = type;
+    command->value = value;
+    __atomic_store_n(&MUSIC_COMMANDS_TAIL, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void update_music_feeder(void) {
+    if (!IS_FEEDER_THREADED) feed_music();
+}
+
+MusicFeederStats get_music_feeder_stats(void) {
+    MusicFeederStats stats = {0};
+    stats.is_threaded = IS_FEEDER_THREADED;
+    stats.n_refills = __atomic_load_n(&N_MUSIC_REFILLS, __ATOMIC_RELAXED);
+    stats.n_underruns = __atomic_load_n(&N_MUSIC_UNDERRUNS, __ATOMIC_RELAXED);
+    stats.n_dropped_commands = N_DROPPED_MUSIC_COMMANDS;
+    __atomic_load(&MUSIC_FILL_LEVEL, &stats.fill_level, __ATOMIC_RELAXED);
+    __atomic_load(&MIN_MUSIC_FILL_LEVEL, &stats.min_fill_level, __ATOMIC_RELAXED);
+    return stats;
+}
+
+static double get_monotonic_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool pop_music_command(MusicCommand *command) {
+    unsigned int head = __atomic_load_n(&MUSIC_COMMANDS_HEAD, __ATOMIC_RELAXED);
+    unsigned int tail = __atomic_load_n(&MUSIC_COMMANDS_TAIL, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+
+    *command = MUSIC_COMMANDS[head % MUSIC_COMMAND_QUEUE_SIZE];
+    __atomic_store_n(&MUSIC_COMMANDS_HEAD, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static void apply_music_command(MusicCommand command) {
+    if (command.type == MUSIC_PLAY) {
+        PlayMusicStream(FEEDER_MUSIC);
+        IS_FEEDER_MUSIC_PLAYING = true;
+    } else if (command.type == MUSIC_STOP) {
+        StopMusicStream(FEEDER_MUSIC);
+        IS_FEEDER_MUSIC_PLAYING = false;
+    } else if (command.type == MUSIC_PAUSE) {
+        PauseMusicStream(FEEDER_MUSIC);
+        IS_FEEDER_MUSIC_PLAYING = false;
+    } else if (command.type == MUSIC_RESUME) {
+        ResumeMusicStream(FEEDER_MUSIC);
+        IS_FEEDER_MUSIC_PLAYING = true;
+    } else if (command.type == MUSIC_SET_VOLUME) {
+        SetMusicVolume(FEEDER_MUSIC, command.value);
+    }
+
+    // Playback (re)starts with the buffer freshly filled
+    if (IS_FEEDER_MUSIC_PLAYING) LAST_REFILL_TIME = get_monotonic_time();
+}
+
+static void feed_music(void) {
+    if (!IS_FEEDER_MUSIC_LOADED) return;
+
+    MusicCommand command;
+    while (pop_music_command(&command)) apply_music_command(command);
+    if (!IS_FEEDER_MUSIC_PLAYING) return;
+
+    // The stream is double buffered: once a sub-buffer is consumed it's
+    // refilled here. If the whole buffer has been played since the last
+    // refill, the mixer had nothing to play
+    double now = get_monotonic_time();
+    float duration = (float)MUSIC_STREAM_BUFFER_FRAMES * 2.0
+                     / FEEDER_MUSIC.stream.sampleRate;
+    float elapsed = now - LAST_REFILL_TIME;
+
+    if (IsAudioStreamProcessed(FEEDER_MUSIC.stream)) {
+        if (elapsed > duration) {
+            __atomic_add_fetch(&N_MUSIC_UNDERRUNS, 1, __ATOMIC_RELAXED);
+        }
+        UpdateMusicStream(FEEDER_MUSIC);
+        __atomic_add_fetch(&N_MUSIC_REFILLS, 1, __ATOMIC_RELAXED);
+        LAST_REFILL_TIME = now;
+        elapsed = 0.0;
+    }
+
+    float fill_level = CLAMP(1.0 - elapsed / duration, 0.0, 1.0);
+    float min_fill_level = MIN(MIN_MUSIC_FILL_LEVEL, fill_level);
+    __atomic_store(&MUSIC_FILL_LEVEL, &fill_level, __ATOMIC_RELAXED);
+    __atomic_store(&MIN_MUSIC_FILL_LEVEL, &min_fill_level, __ATOMIC_RELAXED);
+}
+
+#if !defined(PLATFORM_WEB)
+static void *run_music_feeder(void *arg) {
+    struct timespec period = {0, MUSIC_FEEDER_PERIOD_MS * 1000000L};
+    while (__atomic_load_n(&IS_FEEDER_RUNNING, __ATOMIC_ACQUIRE)) {
+        feed_music();
+        nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+#endif
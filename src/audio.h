@@ -0,0 +1,123 @@
+#pragma once
+
+#include "raylib.h"
+
+// Sound bank produced by the cook tool. SFX are stored as raw 16-bit PCM at
+// the device sample rate, so loading them needs neither decoding nor
+// resampling. Index entries are keyed by the original resource path
+#define SOUND_BANK_FILE_PATH "resources/audio/sfx.bank"
+#define SOUND_BANK_MAGIC "GSB1"
+#define SOUND_BANK_SAMPLE_RATE 48000
+#define SOUND_BANK_SAMPLE_SIZE 16
+#define SOUND_BANK_CHANNELS 2
+#define MAX_N_BANK_SOUNDS 256
+#define MAX_BANK_SOUND_NAME_LENGTH 128
+
+typedef struct SoundBankEntry {
+    char name[MAX_BANK_SOUND_NAME_LENGTH];
+
+    // Byte offset of the samples from the start of the PCM data
+    unsigned int offset;
+    unsigned int frame_count;
+    unsigned int sample_rate;
+    unsigned int channels;
+} SoundBankEntry;
+
+void load_sound_bank(const char *file_path);
+void unload_sound_bank(void);
+
+// Load from the sound bank if the sound was cooked, fall back to the source
+// file otherwise
+Sound load_sound(const char *file_path);
+
+// Decoding half of load_sound, safe on worker threads. Sounds from the bank
+// are not copied
+typedef struct SoundData {
+    Wave wave;
+    bool is_owned;
+} SoundData;
+
+SoundData read_sound_data(const char *file_path);
+
+// Creates the sound on the main thread and releases the decoded samples
+Sound upload_sound_data(SoundData *data, const char *file_path);
+
+// Prefer the cooked .qoa next to the source file, which is much cheaper to
+// decode while streaming
+Music load_music(const char *file_path);
+
+void get_cooked_music_path(char *dst, const char *file_path);
+
+// Voice pool. Every played sound gets a voice which is an alias of the source
+// sound, so overlapping plays share the decoded samples. When all voices are
+// busy, the oldest voice of the lowest priority category is stolen, unless
+// all of them have higher priority than the new sound
+#define MAX_N_VOICES 32
+#define DEFAULT_N_VOICES 16
+
+typedef enum SoundCategory {
+    SOUND_TOUCH = 0,
+    SOUND_ITEM,
+    SOUND_RESULT,
+    N_SOUND_CATEGORIES,
+} SoundCategory;
+
+typedef struct VoicePoolStats {
+    int max_voices;
+    int n_active;
+    int n_active_by_category[N_SOUND_CATEGORIES];
+    int n_stolen;
+    int n_dropped;
+} VoicePoolStats;
+
+void init_voice_pool(int max_voices);
+void unload_voice_pool(void);
+void set_sound_category_priority(SoundCategory category, int priority);
+
+bool play_voice(Sound sound, SoundCategory category);
+
+// Must be called before the source sound is unloaded
+void stop_sound_voices(Sound sound);
+
+VoicePoolStats get_voice_pool_stats(void);
+
+// Music feeder. Music streams are refilled on a dedicated thread, so frame
+// hitches on the main thread don't starve the stream. The main thread talks
+// to the feeder only through a lock-free single-producer single-consumer
+// command queue. Web builds have no threads and feed from update_music_feeder
+#define MUSIC_COMMAND_QUEUE_SIZE 64
+#define MUSIC_STREAM_BUFFER_FRAMES 4096
+#define MUSIC_FEEDER_PERIOD_MS 4
+
+typedef enum MusicCommandType {
+    MUSIC_PLAY = 0,
+    MUSIC_STOP,
+    MUSIC_PAUSE,
+    MUSIC_RESUME,
+    MUSIC_SET_VOLUME,
+} MusicCommandType;
+
+typedef struct MusicCommand {
+    MusicCommandType type;
+    float value;
+} MusicCommand;
+
+typedef struct MusicFeederStats {
+    bool is_threaded;
+    int n_refills;
+    int n_underruns;
+    int n_dropped_commands;
+
+    // Estimated share of the stream buffer which is still queued for playback
+    float fill_level;
+    float min_fill_level;
+} MusicFeederStats;
+
+// The feeder owns the music after this call, the caller must not touch it
+void init_music_feeder(Music music);
+void unload_music_feeder(void);
+
+bool push_music_command(MusicCommandType type, float value);
+void update_music_feeder(void);
+
+MusicFeederStats get_music_feeder_stats(void);
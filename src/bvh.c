@@ -0,0 +1,240 @@
+#include "bvh.h"
+
+#include "math.h"
+#include "raymath.h"
+#include <float.h>
+#include <stdlib.h>
+
+#define BVH_INITIAL_CAPACITY 64
+
+// Traversal stack on the call stack, enough for the trees of the scene. Taller
+// trees get a heap stack
+#define BVH_STACK_SIZE 64
+
+static int alloc_node(BVH *bvh);
+static void free_node(BVH *bvh, int node);
+static void refit_ancestors(BVH *bvh, int node);
+static float get_box_area(BoundingBox box);
+static BoundingBox merge_boxes(BoundingBox a, BoundingBox b);
+static float raycast_box(Ray ray, Vector3 inv_dir, BoundingBox box);
+
+void init_bvh(BVH *bvh) {
+    *bvh = (BVH){0};
+    bvh->root = BVH_NULL_NODE;
+    bvh->free_node = BVH_NULL_NODE;
+}
+
+void unload_bvh(BVH *bvh) {
+    free(bvh->nodes);
+    init_bvh(bvh);
+}
+
+int insert_bvh_leaf(BVH *bvh, BoundingBox box, int user_id) {
+    int leaf = alloc_node(bvh);
+    BVHNode *nodes = bvh->nodes;
+    nodes[leaf].box = box;
+    nodes[leaf].user_id = user_id;
+    nodes[leaf].height = 0;
+    bvh->n_leaves += 1;
+
+    if (bvh->root == BVH_NULL_NODE) {
+        bvh->root = leaf;
+        return leaf;
+    }
+
+    // Find the best sibling by descending towards the cheapest child, where
+    // the cost is the growth of the surface area (Box2D heuristic)
+    int sibling = bvh->root;
+    while (nodes[sibling].height > 0) {
+        int left = nodes[sibling].left;
+        int right = nodes[sibling].right;
+
+        float area = get_box_area(nodes[sibling].box);
+        float merged_area = get_box_area(merge_boxes(nodes[sibling].box, box));
+        float cost = 2.0 * merged_area;
+        float inheritance_cost = 2.0 * (merged_area - area);
+
+        float child_costs[2];
+        int children[2] = {left, right};
+        for (int i = 0; i < 2; ++i) {
+            BVHNode *child = &nodes[children[i]];
+            float child_area = get_box_area(merge_boxes(child->box, box));
+            if (child->height > 0) child_area -= get_box_area(child->box);
+            child_costs[i] = child_area + inheritance_cost;
+        }
+
+        if (cost < child_costs[0] && cost < child_costs[1]) break;
+        sibling = child_costs[0] < child_costs[1] ? left : right;
+    }
+
+    // Create a new parent for the sibling and the new leaf
+    int old_parent = nodes[sibling].parent;
+    int new_parent = alloc_node(bvh);
+    nodes = bvh->nodes;
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].box = merge_boxes(box, nodes[sibling].box);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].left = sibling;
+    nodes[new_parent].right = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    if (old_parent == BVH_NULL_NODE) {
+        bvh->root = new_parent;
+    } else if (nodes[old_parent].left == sibling) {
+        nodes[old_parent].left = new_parent;
+    } else {
+        nodes[old_parent].right = new_parent;
+    }
+
+    refit_ancestors(bvh, nodes[leaf].parent);
+    return leaf;
+}
+
+void remove_bvh_leaf(BVH *bvh, int leaf) {
+    BVHNode *nodes = bvh->nodes;
+    bvh->n_leaves -= 1;
+
+    if (leaf == bvh->root) {
+        bvh->root = BVH_NULL_NODE;
+        free_node(bvh, leaf);
+        return;
+    }
+
+    // Replace the parent with the sibling of the removed leaf
+    int parent = nodes[leaf].parent;
+    int grand_parent = nodes[parent].parent;
+    int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+    if (grand_parent == BVH_NULL_NODE) {
+        bvh->root = sibling;
+        nodes[sibling].parent = BVH_NULL_NODE;
+    } else {
+        if (nodes[grand_parent].left == parent) nodes[grand_parent].left = sibling;
+        else nodes[grand_parent].right = sibling;
+        nodes[sibling].parent = grand_parent;
+        refit_ancestors(bvh, grand_parent);
+    }
+
+    free_node(bvh, parent);
+    free_node(bvh, leaf);
+}
+
+void refit_bvh_leaf(BVH *bvh, int leaf, BoundingBox box) {
+    bvh->nodes[leaf].box = box;
+    refit_ancestors(bvh, bvh->nodes[leaf].parent);
+}
+
+int raycast_bvh(BVH *bvh, Ray ray, BVHRayTestFn test, void *ctx, float *distance) {
+    if (bvh->root == BVH_NULL_NODE) return -1;
+
+    Vector3 d = ray.direction;
+    Vector3 inv_dir = {1.0 / d.x, 1.0 / d.y, 1.0 / d.z};
+
+    int best_user_id = -1;
+    float best_distance = FLT_MAX;
+
+    // Depth-first traversal never holds more than height + 1 nodes
+    int n_stack = 0;
+    int fixed_stack[BVH_STACK_SIZE];
+    int *stack = fixed_stack;
+    int stack_size = bvh->nodes[bvh->root].height + 2;
+    if (stack_size > BVH_STACK_SIZE) stack = malloc(stack_size * sizeof(int));
+    stack[n_stack++] = bvh->root;
+
+    while (n_stack > 0) {
+        BVHNode *node = &bvh->nodes[stack[--n_stack]];
+
+        float box_distance = raycast_box(ray, inv_dir, node->box);
+        if (box_distance < 0.0 || box_distance > best_distance) continue;
+
+        if (node->height == 0) {
+            float leaf_distance = test(node->user_id, ray, ctx);
+            if (leaf_distance >= 0.0 && leaf_distance < best_distance) {
+                best_distance = leaf_distance;
+                best_user_id = node->user_id;
+            }
+        } else {
+            stack[n_stack++] = node->left;
+            stack[n_stack++] = node->right;
+        }
+    }
+
+    if (stack != fixed_stack) free(stack);
+    if (distance) *distance = best_distance;
+    return best_user_id;
+}
+
+static int alloc_node(BVH *bvh) {
+    if (bvh->free_node == BVH_NULL_NODE) {
+        int capacity = bvh->capacity ? bvh->capacity * 2 : BVH_INITIAL_CAPACITY;
+        bvh->nodes = realloc(bvh->nodes, capacity * sizeof(BVHNode));
+
+        // Chain the new nodes into the free list
+        for (int i = bvh->capacity; i < capacity; ++i) {
+            bvh->nodes[i].parent = i + 1 < capacity ? i + 1 : BVH_NULL_NODE;
+            bvh->nodes[i].height = -1;
+        }
+        bvh->free_node = bvh->capacity;
+        bvh->capacity = capacity;
+    }
+
+    int node = bvh->free_node;
+    bvh->free_node = bvh->nodes[node].parent;
+    bvh->nodes[node] = (BVHNode){0};
+    bvh->nodes[node].parent = BVH_NULL_NODE;
+    bvh->nodes[node].left = BVH_NULL_NODE;
+    bvh->nodes[node].right = BVH_NULL_NODE;
+    bvh->nodes[node].user_id = -1;
+    bvh->n_nodes += 1;
+    return node;
+}
+
+static void free_node(BVH *bvh, int node) {
+    bvh->nodes[node].parent = bvh->free_node;
+    bvh->nodes[node].height = -1;
+    bvh->free_node = node;
+    bvh->n_nodes -= 1;
+}
+
+static void refit_ancestors(BVH *bvh, int node) {
+    BVHNode *nodes = bvh->nodes;
+    while (node != BVH_NULL_NODE) {
+        BVHNode *left = &nodes[nodes[node].left];
+        BVHNode *right = &nodes[nodes[node].right];
+        nodes[node].box = merge_boxes(left->box, right->box);
+        nodes[node].height = 1 + MAX(left->height, right->height);
+        node = nodes[node].parent;
+    }
+}
+
+static float get_box_area(BoundingBox box) {
+    Vector3 d = Vector3Subtract(box.max, box.min);
+    return 2.0 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static BoundingBox merge_boxes(BoundingBox a, BoundingBox b) {
+    BoundingBox box = {Vector3Min(a.min, b.min), Vector3Max(a.max, b.max)};
+    return box;
+}
+
+// Slab test. Returns the entry distance or a negative value on miss
+static float raycast_box(Ray ray, Vector3 inv_dir, BoundingBox box) {
+    float t1 = (box.min.x - ray.position.x) * inv_dir.x;
+    float t2 = (box.max.x - ray.position.x) * inv_dir.x;
+    float t_min = MIN(t1, t2);
+    float t_max = MAX(t1, t2);
+
+    t1 = (box.min.y - ray.position.y) * inv_dir.y;
+    t2 = (box.max.y - ray.position.y) * inv_dir.y;
+    t_min = MAX(t_min, MIN(t1, t2));
+    t_max = MIN(t_max, MAX(t1, t2));
+
+    t1 = (box.min.z - ray.position.z) * inv_dir.z;
+    t2 = (box.max.z - ray.position.z) * inv_dir.z;
+    t_min = MAX(t_min, MIN(t1, t2));
+    t_max = MIN(t_max, MAX(t1, t2));
+
+    if (t_max < MAX(t_min, 0.0)) return -1.0;
+    return MAX(t_min, 0.0);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "raylib.h"
+
+#define BVH_NULL_NODE -1
+
+typedef struct BVHNode {
+    BoundingBox box;
+    int parent;
+    int left;
+    int right;
+
+    // Leaf nodes have height 0, free nodes have height -1
+    int height;
+    int user_id;
+} BVHNode;
+
+// Dynamic bounding volume hierarchy. Leaves are inserted and removed one by
+// one and can be refitted in place, so the tree is never rebuilt from scratch
+typedef struct BVH {
+    int root;
+    int free_node;
+    int n_leaves;
+    int n_nodes;
+    int capacity;
+    BVHNode *nodes;
+} BVH;
+
+// Exact ray test for the leaf payload. Returns the hit distance or a
+// negative value if the ray misses the leaf
+typedef float (*BVHRayTestFn)(int user_id, Ray ray, void *ctx);
+
+void init_bvh(BVH *bvh);
+void unload_bvh(BVH *bvh);
+
+int insert_bvh_leaf(BVH *bvh, BoundingBox box, int user_id);
+void remove_bvh_leaf(BVH *bvh, int leaf);
+void refit_bvh_leaf(BVH *bvh, int leaf, BoundingBox box);
+
+int raycast_bvh(BVH *bvh, Ray ray, BVHRayTestFn test, void *ctx, float *distance);
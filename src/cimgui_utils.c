@@ -1,6 +1,8 @@
 #include "cimgui_utils.h"
 
 #include "raylib.h"
+#include "render_queue.h"
+#include "render_stats.h"
 
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #define CIMGUI_USE_GLFW
@@ -53,3 +55,25 @@ bool ig_collapsing_header(const char *name, bool is_opened) {
     int flags = is_opened ? ImGuiTreeNodeFlags_DefaultOpen : 0;
     return igCollapsingHeader_TreeNodeFlags(name, flags);
 }
+
+void ig_render_stats(void) {
+    RenderStats stats = get_render_stats();
+    igText("render (draws/binds/switches/lookups/uniforms/flushes):");
+    for (int i = 0; i <= N_RENDER_PASSES; ++i) {
+        RenderCounters c = i < N_RENDER_PASSES ? stats.passes[i] : stats.total;
+        if (i < N_RENDER_PASSES && c.n_draw_calls == 0) continue;
+        igText(
+            "  %s: %d/%d/%d/%d/%d/%d",
+            i < N_RENDER_PASSES ? RENDER_PASS_TO_NAME(i) : "total",
+            c.n_draw_calls,
+            c.n_texture_binds,
+            c.n_shader_switches,
+            c.n_location_lookups,
+            c.n_uniform_uploads,
+            c.n_batch_flushes
+        );
+    }
+
+    RenderQueueStats queue = get_render_queue_stats();
+    igText("render queue: %d packets, sort %.3f ms", queue.n_packets, queue.sort_ms);
+}
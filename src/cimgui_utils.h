@@ -11,3 +11,7 @@ void end_imgui(void);
 void ig_fix_window_top_left(void);
 void ig_fix_window_bot_left(void);
 bool ig_collapsing_header(const char *name, bool is_opened);
+
+// Counters of the last frame per render pass, the passes without draws skipped,
+// and the render queue size and sort time
+void ig_render_stats(void);
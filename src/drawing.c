@@ -3,6 +3,7 @@
 #include "math.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "render_stats.h"
 #include "rlgl.h"
 #include <stdio.h>
 
@@ -14,6 +15,7 @@ void draw_screen_ex(RenderTexture2D screen, Vector2 position) {
     h = screen.texture.height;
     r = (Rectangle){0, 0, w, -h};
     DrawTextureRec(screen.texture, r, position, WHITE);
+    count_batch_draw(screen.texture.id);
 }
 
 void draw_screen(RenderTexture2D screen) {
@@ -34,6 +36,7 @@ void draw_mesh_m(Matrix matrix, Material material, Mesh mesh) {
     {
         rlMultMatrixf(MatrixToFloat(matrix));
         DrawMesh(mesh, material, MatrixIdentity());
+        count_mesh_draw(material);
     }
     rlPopMatrix();
 }
@@ -0,0 +1,142 @@
+#include "hot_reload.h"
+
+#include "raylib.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__) && !defined(PLATFORM_WEB)
+#define HAS_WATCHER 1
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#define HAS_WATCHER 0
+#endif
+
+#if HAS_WATCHER
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+typedef struct WatchedDir {
+    int wd;
+    char path[MAX_PATH_LENGTH];
+} WatchedDir;
+
+static int INOTIFY_FD = -1;
+static int N_WATCHED_DIRS;
+static WatchedDir WATCHED_DIRS[MAX_N_WATCHED_DIRS];
+
+static void watch_dir_tree(const char *path);
+static WatchedDir *find_watched_dir(int wd);
+#endif
+
+void init_hot_reload(const char *dir_path) {
+#if HAS_WATCHER
+    INOTIFY_FD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (INOTIFY_FD == -1) {
+        TraceLog(LOG_WARNING, "HOT_RELOAD: Failed to init inotify");
+        return;
+    }
+
+    N_WATCHED_DIRS = 0;
+    watch_dir_tree(dir_path);
+    TraceLog(
+        LOG_INFO, "HOT_RELOAD: Watching %d directories in %s", N_WATCHED_DIRS, dir_path
+    );
+#endif
+}
+
+void unload_hot_reload(void) {
+#if HAS_WATCHER
+    // Closing the descriptor removes all the watches
+    if (INOTIFY_FD != -1) close(INOTIFY_FD);
+    INOTIFY_FD = -1;
+    N_WATCHED_DIRS = 0;
+#endif
+}
+
+int poll_changed_files(char paths[][MAX_PATH_LENGTH], int max_n_paths) {
+    int n_paths = 0;
+
+#if HAS_WATCHER
+    if (INOTIFY_FD == -1) return 0;
+
+    static char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (true) {
+        // Fails with EAGAIN once the queue is drained
+        long n_bytes = read(INOTIFY_FD, buffer, sizeof(buffer));
+        if (n_bytes <= 0) break;
+
+        char *p = buffer;
+        while (p < buffer + n_bytes) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            WatchedDir *dir = find_watched_dir(event->wd);
+            if (!dir || event->len == 0) continue;
+
+            char path[MAX_PATH_LENGTH];
+            int n = snprintf(path, sizeof(path), "%s/%s", dir->path, event->name);
+            if (n >= MAX_PATH_LENGTH) continue;
+
+            // New directories are watched too. New files are reported once
+            // they are written
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) watch_dir_tree(path);
+                continue;
+            }
+            if (!(event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) continue;
+
+            // Editors often write a file several times in a row
+            bool is_reported = false;
+            for (int i = 0; i < n_paths && !is_reported; ++i) {
+                is_reported = strcmp(paths[i], path) == 0;
+            }
+            if (!is_reported && n_paths < max_n_paths) strcpy(paths[n_paths++], path);
+        }
+    }
+#endif
+
+    return n_paths;
+}
+
+#if HAS_WATCHER
+static void watch_dir_tree(const char *path) {
+    if (N_WATCHED_DIRS == MAX_N_WATCHED_DIRS) {
+        TraceLog(LOG_WARNING, "HOT_RELOAD: Too many directories, %s is skipped", path);
+        return;
+    }
+
+    int wd = inotify_add_watch(INOTIFY_FD, path, WATCH_MASK);
+    if (wd == -1) {
+        TraceLog(LOG_WARNING, "HOT_RELOAD: Failed to watch %s", path);
+        return;
+    }
+    if (find_watched_dir(wd)) return;
+
+    WatchedDir *dir = &WATCHED_DIRS[N_WATCHED_DIRS++];
+    dir->wd = wd;
+    strncpy(dir->path, path, MAX_PATH_LENGTH - 1);
+    dir->path[MAX_PATH_LENGTH - 1] = '\0';
+
+    // inotify is not recursive
+    DIR *d = opendir(path);
+    if (d == NULL) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+
+        char child_path[MAX_PATH_LENGTH];
+        int n = snprintf(child_path, sizeof(child_path), "%s/%s", path, entry->d_name);
+        if (n < MAX_PATH_LENGTH) watch_dir_tree(child_path);
+    }
+    closedir(d);
+}
+
+static WatchedDir *find_watched_dir(int wd) {
+    for (int i = 0; i < N_WATCHED_DIRS; ++i) {
+        if (WATCHED_DIRS[i].wd == wd) return &WATCHED_DIRS[i];
+    }
+    return NULL;
+}
+#endif
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "scene.h"
+#include <stdbool.h>
+
+// Asset file watcher. The resources directory tree is watched with inotify and
+// every file written or moved into it is reported once per poll. Poll from the
+// main thread, between frames, and reload the reported files in place.
+//
+// Only desktop Linux builds have the watcher, elsewhere nothing is reported
+#define MAX_N_WATCHED_DIRS 64
+#define MAX_N_CHANGED_FILES 64
+
+void init_hot_reload(const char *dir_path);
+void unload_hot_reload(void);
+
+// Fills the paths of the files changed since the last poll, the paths start
+// with the watched directory, e.g. "resources/shaders/sprite.frag"
+int poll_changed_files(char paths[][MAX_PATH_LENGTH], int max_n_paths);
@@ -0,0 +1,331 @@
+#include "jobs.h"
+
+#include "math.h"
+#include "raylib.h"
+#include <stdlib.h>
+
+#if defined(PLATFORM_WEB) || defined(JOBS_SINGLE_THREADED)
+#define IS_SINGLE_THREADED_BUILD 1
+#else
+#define IS_SINGLE_THREADED_BUILD 0
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+typedef struct Job {
+    JobFn fn;
+    void *data;
+    JobCounter *counter;
+} Job;
+
+typedef struct ParallelForBatch {
+    ParallelForFn fn;
+    void *data;
+    int begin;
+    int end;
+} ParallelForBatch;
+
+static int N_WORKERS;
+static JobStats STATS;
+
+// Set on the thread which called init_jobs only, the threads the job system
+// doesn't know about (e.g. the audio) are neither the main thread nor workers
+static __thread bool IS_MAIN_THREAD;
+
+static void execute_job(Job job);
+static void execute_parallel_for_batch(void *data);
+
+#if !IS_SINGLE_THREADED_BUILD
+// Ring buffer, the owner works on the back and thieves take from the front
+typedef struct JobQueue {
+    pthread_mutex_t mutex;
+    int front;
+    int back;
+    Job jobs[JOB_QUEUE_SIZE];
+} JobQueue;
+
+// Queue 0 belongs to the main thread
+static JobQueue QUEUES[MAX_N_JOB_WORKERS + 1];
+static pthread_t WORKERS[MAX_N_JOB_WORKERS];
+static __thread int QUEUE_ID;
+
+// Ring buffer too, run in the order the jobs are queued
+static int MAIN_THREAD_JOBS_FRONT;
+static int MAIN_THREAD_JOBS_BACK;
+static Job MAIN_THREAD_JOBS[MAX_N_MAIN_THREAD_JOBS];
+static pthread_mutex_t MAIN_THREAD_JOBS_MUTEX = PTHREAD_MUTEX_INITIALIZER;
+
+// Idle workers sleep until a job is pushed
+static pthread_mutex_t SLEEP_MUTEX = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t SLEEP_COND = PTHREAD_COND_INITIALIZER;
+static int N_QUEUED_JOBS;
+static bool IS_RUNNING;
+
+static bool push_job(int queue_id, Job job);
+static bool pop_job(int queue_id, Job *job);
+static bool steal_job(int queue_id, Job *job);
+static bool run_next_job(void);
+static bool run_next_main_thread_job(void);
+static void *run_worker(void *arg);
+#endif
+
+void init_jobs(int n_workers) {
+    STATS = (JobStats){0};
+    IS_MAIN_THREAD = true;
+
+#if IS_SINGLE_THREADED_BUILD
+    n_workers = 0;
+    N_WORKERS = 0;
+#else
+    if (n_workers == DEFAULT_N_JOB_WORKERS) {
+        n_workers = sysconf(_SC_NPROCESSORS_ONLN) - 2;
+    }
+    n_workers = CLAMP(n_workers, 0, MAX_N_JOB_WORKERS);
+
+    for (int i = 0; i <= n_workers; ++i) {
+        pthread_mutex_init(&QUEUES[i].mutex, NULL);
+        QUEUES[i].front = 0;
+        QUEUES[i].back = 0;
+    }
+
+    // Workers steal from the queues of each other from the start
+    QUEUE_ID = 0;
+    N_WORKERS = n_workers;
+    __atomic_store_n(&IS_RUNNING, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < n_workers; ++i) {
+        int status = pthread_create(&WORKERS[i], NULL, run_worker, (void *)(long)(i + 1));
+        if (status != 0) {
+            TraceLog(LOG_WARNING, "JOBS: Failed to create worker %d", i + 1);
+            n_workers = i;
+            __atomic_store_n(&N_WORKERS, n_workers, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+#endif
+
+    STATS.n_workers = n_workers;
+    TraceLog(LOG_INFO, "JOBS: Initialized with %d workers", n_workers);
+}
+
+void unload_jobs(void) {
+#if !IS_SINGLE_THREADED_BUILD
+    pthread_mutex_lock(&SLEEP_MUTEX);
+    __atomic_store_n(&IS_RUNNING, false, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&SLEEP_COND);
+    pthread_mutex_unlock(&SLEEP_MUTEX);
+
+    for (int i = 0; i < N_WORKERS; ++i) pthread_join(WORKERS[i], NULL);
+    for (int i = 0; i <= N_WORKERS; ++i) pthread_mutex_destroy(&QUEUES[i].mutex);
+#endif
+
+    update_main_thread_jobs();
+    N_WORKERS = 0;
+}
+
+void run_job(JobFn fn, void *data, JobCounter *counter) {
+    Job job = {fn, data, counter};
+    if (counter) __atomic_add_fetch(&counter->value, 1, __ATOMIC_ACQ_REL);
+
+#if !IS_SINGLE_THREADED_BUILD
+    if (N_WORKERS > 0 && push_job(QUEUE_ID, job)) {
+        pthread_mutex_lock(&SLEEP_MUTEX);
+        N_QUEUED_JOBS += 1;
+        pthread_cond_signal(&SLEEP_COND);
+        pthread_mutex_unlock(&SLEEP_MUTEX);
+        return;
+    }
+#endif
+
+    // No workers or the queue is full
+    __atomic_add_fetch(&STATS.n_inline, 1, __ATOMIC_RELAXED);
+    execute_job(job);
+}
+
+// The main thread also runs the jobs queued for it, the waited jobs may have
+// queued them
+void wait_job_counter(JobCounter *counter) {
+    while (__atomic_load_n(&counter->value, __ATOMIC_ACQUIRE) > 0) {
+#if !IS_SINGLE_THREADED_BUILD
+        if (IS_MAIN_THREAD && run_next_main_thread_job()) continue;
+        if (!run_next_job()) sched_yield();
+#endif
+    }
+}
+
+void parallel_for(int n, int batch_size, ParallelForFn fn, void *data) {
+    if (n <= 0) return;
+
+    batch_size = MAX(batch_size, 1);
+    int n_batches = (n + batch_size - 1) / batch_size;
+    if (N_WORKERS == 0 || n_batches == 1) {
+        fn(0, n, data);
+        return;
+    }
+
+    n_batches = MIN(n_batches, MAX_N_PARALLEL_FOR_BATCHES);
+    batch_size = (n + n_batches - 1) / n_batches;
+
+    ParallelForBatch batches[MAX_N_PARALLEL_FOR_BATCHES];
+    JobCounter counter = {0};
+    for (int i = 0; i < n_batches; ++i) {
+        int begin = i * batch_size;
+        batches[i] = (ParallelForBatch){fn, data, begin, MIN(begin + batch_size, n)};
+    }
+
+    // The first batch is kept for the calling thread
+    for (int i = 1; i < n_batches; ++i) {
+        run_job(execute_parallel_for_batch, &batches[i], &counter);
+    }
+    execute_parallel_for_batch(&batches[0]);
+    wait_job_counter(&counter);
+}
+
+void run_main_thread_job(JobFn fn, void *data, JobCounter *counter) {
+    Job job = {fn, data, counter};
+    if (counter) __atomic_add_fetch(&counter->value, 1, __ATOMIC_ACQ_REL);
+    if (is_main_thread()) {
+        __atomic_add_fetch(&STATS.n_main_thread, 1, __ATOMIC_RELAXED);
+        execute_job(job);
+        return;
+    }
+
+#if !IS_SINGLE_THREADED_BUILD
+    // Workers wait for the main thread to make room
+    while (true) {
+        pthread_mutex_lock(&MAIN_THREAD_JOBS_MUTEX);
+        int n_jobs = MAIN_THREAD_JOBS_BACK - MAIN_THREAD_JOBS_FRONT;
+        if (n_jobs < MAX_N_MAIN_THREAD_JOBS) {
+            MAIN_THREAD_JOBS[MAIN_THREAD_JOBS_BACK++ % MAX_N_MAIN_THREAD_JOBS] = job;
+            pthread_mutex_unlock(&MAIN_THREAD_JOBS_MUTEX);
+            return;
+        }
+        pthread_mutex_unlock(&MAIN_THREAD_JOBS_MUTEX);
+        sched_yield();
+    }
+#else
+    // Nothing would run the queued job, a foreign thread runs it itself
+    __atomic_add_fetch(&STATS.n_main_thread, 1, __ATOMIC_RELAXED);
+    execute_job(job);
+#endif
+}
+
+void update_main_thread_jobs(void) {
+#if !IS_SINGLE_THREADED_BUILD
+    while (run_next_main_thread_job()) continue;
+#endif
+}
+
+bool is_main_thread(void) {
+    return IS_MAIN_THREAD;
+}
+
+// Other threads keep the zero QUEUE_ID, they push to and run from the main
+// thread queue, which is locked as any other
+int get_job_thread_id(void) {
+    if (IS_MAIN_THREAD) return 0;
+#if IS_SINGLE_THREADED_BUILD
+    return -1;
+#else
+    return QUEUE_ID > 0 ? QUEUE_ID : -1;
+#endif
+}
+
+JobStats get_job_stats(void) {
+    JobStats stats = STATS;
+    stats.n_jobs = __atomic_load_n(&STATS.n_jobs, __ATOMIC_RELAXED);
+    stats.n_stolen = __atomic_load_n(&STATS.n_stolen, __ATOMIC_RELAXED);
+    return stats;
+}
+
+static void execute_job(Job job) {
+    job.fn(job.data);
+    __atomic_add_fetch(&STATS.n_jobs, 1, __ATOMIC_RELAXED);
+    if (job.counter) __atomic_sub_fetch(&job.counter->value, 1, __ATOMIC_ACQ_REL);
+}
+
+static void execute_parallel_for_batch(void *data) {
+    ParallelForBatch *batch = data;
+    batch->fn(batch->begin, batch->end, batch->data);
+}
+
+#if !IS_SINGLE_THREADED_BUILD
+static bool push_job(int queue_id, Job job) {
+    JobQueue *queue = &QUEUES[queue_id];
+    pthread_mutex_lock(&queue->mutex);
+    bool is_full = queue->back - queue->front == JOB_QUEUE_SIZE;
+    if (!is_full) queue->jobs[queue->back++ % JOB_QUEUE_SIZE] = job;
+    pthread_mutex_unlock(&queue->mutex);
+    return !is_full;
+}
+
+static bool pop_job(int queue_id, Job *job) {
+    JobQueue *queue = &QUEUES[queue_id];
+    pthread_mutex_lock(&queue->mutex);
+    bool is_empty = queue->back == queue->front;
+    if (!is_empty) *job = queue->jobs[--queue->back % JOB_QUEUE_SIZE];
+    if (queue->back == queue->front) queue->front = queue->back = 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return !is_empty;
+}
+
+static bool steal_job(int queue_id, Job *job) {
+    JobQueue *queue = &QUEUES[queue_id];
+    if (pthread_mutex_trylock(&queue->mutex) != 0) return false;
+    bool is_empty = queue->back == queue->front;
+    if (!is_empty) *job = queue->jobs[queue->front++ % JOB_QUEUE_SIZE];
+    if (queue->back == queue->front) queue->front = queue->back = 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return !is_empty;
+}
+
+// Runs a job from the own queue, or steals one starting from the next queue,
+// so the thieves don't all go after the same victim
+static bool run_next_job(void) {
+    Job job;
+    bool is_found = pop_job(QUEUE_ID, &job);
+    for (int i = 1; !is_found && i <= N_WORKERS; ++i) {
+        is_found = steal_job((QUEUE_ID + i) % (N_WORKERS + 1), &job);
+        if (is_found) __atomic_add_fetch(&STATS.n_stolen, 1, __ATOMIC_RELAXED);
+    }
+    if (!is_found) return false;
+
+    pthread_mutex_lock(&SLEEP_MUTEX);
+    N_QUEUED_JOBS -= 1;
+    pthread_mutex_unlock(&SLEEP_MUTEX);
+
+    execute_job(job);
+    return true;
+}
+
+static bool run_next_main_thread_job(void) {
+    pthread_mutex_lock(&MAIN_THREAD_JOBS_MUTEX);
+    if (MAIN_THREAD_JOBS_FRONT == MAIN_THREAD_JOBS_BACK) {
+        pthread_mutex_unlock(&MAIN_THREAD_JOBS_MUTEX);
+        return false;
+    }
+    int idx = MAIN_THREAD_JOBS_FRONT++ % MAX_N_MAIN_THREAD_JOBS;
+    Job job = MAIN_THREAD_JOBS[idx];
+    pthread_mutex_unlock(&MAIN_THREAD_JOBS_MUTEX);
+
+    __atomic_add_fetch(&STATS.n_main_thread, 1, __ATOMIC_RELAXED);
+    execute_job(job);
+    return true;
+}
+
+static void *run_worker(void *arg) {
+    QUEUE_ID = (int)(long)arg;
+
+    while (__atomic_load_n(&IS_RUNNING, __ATOMIC_ACQUIRE)) {
+        if (run_next_job()) continue;
+
+        pthread_mutex_lock(&SLEEP_MUTEX);
+        while (N_QUEUED_JOBS == 0 && __atomic_load_n(&IS_RUNNING, __ATOMIC_ACQUIRE)) {
+            pthread_cond_wait(&SLEEP_COND, &SLEEP_MUTEX);
+        }
+        pthread_mutex_unlock(&SLEEP_MUTEX);
+    }
+
+    return NULL;
+}
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Work-stealing job system. Every worker thread and the main thread own a job
+// queue: jobs are pushed to and popped from the back of the own queue, and
+// idle threads steal from the front of the others. Waiting on a counter runs
+// other jobs instead of blocking, so jobs can wait on jobs they spawn.
+//
+// With 0 workers, on the web build, or with JOBS_SINGLE_THREADED defined every
+// job runs right away on the calling thread, in submission order
+#define MAX_N_JOB_WORKERS 15
+#define JOB_QUEUE_SIZE 1024
+#define MAX_N_MAIN_THREAD_JOBS 1024
+#define MAX_N_PARALLEL_FOR_BATCHES 64
+
+// Spare a core for the main thread and one for the audio
+#define DEFAULT_N_JOB_WORKERS -1
+
+typedef void (*JobFn)(void *data);
+
+// Processes the [begin, end) range of a parallel_for
+typedef void (*ParallelForFn)(int begin, int end, void *data);
+
+// Number of unfinished jobs. Zero initialized counters are ready to use
+typedef struct JobCounter {
+    int value;
+} JobCounter;
+
+typedef struct JobStats {
+    int n_workers;
+    long n_jobs;
+    long n_stolen;
+    long n_inline;
+    long n_main_thread;
+} JobStats;
+
+void init_jobs(int n_workers);
+void unload_jobs(void);
+
+// The counter, if not NULL, is incremented now and decremented when the job
+// finishes
+void run_job(JobFn fn, void *data, JobCounter *counter);
+void wait_job_counter(JobCounter *counter);
+
+// Splits [0, n) into batches of at least batch_size items, and returns when
+// all of them are processed. The calling thread processes batches too
+void parallel_for(int n, int batch_size, ParallelForFn fn, void *data);
+
+// GL and audio device calls must be made on the main thread. Jobs queue them
+// here and the main thread runs them on update_main_thread_jobs, or while it
+// waits on a counter. The counter works as in run_job
+void run_main_thread_job(JobFn fn, void *data, JobCounter *counter);
+void update_main_thread_jobs(void);
+
+// The main thread is the one which called init_jobs
+bool is_main_thread(void);
+
+// 0 on the main thread, 1..n_workers on the workers, -1 on the other threads
+int get_job_thread_id(void);
+JobStats get_job_stats(void);
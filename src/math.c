@@ -1,8 +1,25 @@
 #include "math.h"
 
 #include "raymath.h"
+#include <math.h>
 #include <stdio.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_NAME "AVX2"
+#define SIMD_WIDTH 8
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_NAME "SSE2"
+#define SIMD_WIDTH 4
+#else
+#define SIMD_NAME "scalar"
+#define SIMD_WIDTH 1
+#endif
+
+// Transform is packed as translation (3), rotation (4) and scale (3) floats
+#define TRANSFORM_N_FLOATS 10
+
 Transform get_default_transform(void) {
     Transform transform = {0};
     transform.scale = Vector3One();
@@ -10,15 +27,277 @@ Transform get_default_transform(void) {
     return transform;
 }
 
+// Composes the scale -> rotation -> translation matrix directly, which is the
+// same as MatrixMultiply(ms, MatrixMultiply(mr, mt)) without the full 4x4
+// products
 Matrix get_transform_matrix(Transform transform) {
     Vector3 t = transform.translation;
     Vector3 s = transform.scale;
     Quaternion q = transform.rotation;
 
-    Matrix mt = MatrixTranslate(t.x, t.y, t.z);
-    Matrix mr = QuaternionToMatrix(q);
-    Matrix ms = MatrixScale(s.x, s.y, s.z);
-    Matrix m = MatrixMultiply(ms, MatrixMultiply(mr, mt));
+    float a2 = q.x * q.x, b2 = q.y * q.y, c2 = q.z * q.z;
+    float ac = q.x * q.z, ab = q.x * q.y, bc = q.y * q.z;
+    float ad = q.w * q.x, bd = q.w * q.y, cd = q.w * q.z;
+
+    Matrix m = {0};
+    m.m0 = s.x * (1.0f - 2.0f * (b2 + c2));
+    m.m1 = s.x * 2.0f * (ab + cd);
+    m.m2 = s.x * 2.0f * (ac - bd);
+
+    m.m4 = s.y * 2.0f * (ab - cd);
+    m.m5 = s.y * (1.0f - 2.0f * (a2 + c2));
+    m.m6 = s.y * 2.0f * (bc + ad);
+
+    m.m8 = s.z * 2.0f * (ac + bd);
+    m.m9 = s.z * 2.0f * (bc - ad);
+    m.m10 = s.z * (1.0f - 2.0f * (a2 + b2));
+
+    m.m12 = t.x;
+    m.m13 = t.y;
+    m.m14 = t.z;
+    m.m15 = 1.0f;
 
     return m;
 }
+
+// Axis-aligned box which encloses the transformed box (Arvo's method)
+BoundingBox get_transformed_box(BoundingBox box, Matrix matrix) {
+    float m[3][3] = {
+        {matrix.m0, matrix.m4, matrix.m8},
+        {matrix.m1, matrix.m5, matrix.m9},
+        {matrix.m2, matrix.m6, matrix.m10}};
+    float t[3] = {matrix.m12, matrix.m13, matrix.m14};
+    float src_min[3] = {box.min.x, box.min.y, box.min.z};
+    float src_max[3] = {box.max.x, box.max.y, box.max.z};
+    float dst_min[3] = {t[0], t[1], t[2]};
+    float dst_max[3] = {t[0], t[1], t[2]};
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            float a = m[i][j] * src_min[j];
+            float b = m[i][j] * src_max[j];
+            dst_min[i] += MIN(a, b);
+            dst_max[i] += MAX(a, b);
+        }
+    }
+
+    BoundingBox result = {
+        {dst_min[0], dst_min[1], dst_min[2]}, {dst_max[0], dst_max[1], dst_max[2]}};
+    return result;
+}
+
+const char *get_math_simd_name(void) {
+    return SIMD_NAME;
+}
+
+// -----------------------------------------------------------------------
+// Compose
+#if SIMD_WIDTH > 1
+
+#if SIMD_WIDTH == 8
+typedef __m256 vfloat;
+#define VSET1(x) _mm256_set1_ps(x)
+#define VADD(a, b) _mm256_add_ps(a, b)
+#define VSUB(a, b) _mm256_sub_ps(a, b)
+#define VMUL(a, b) _mm256_mul_ps(a, b)
+#define VSTORE(p, a) _mm256_storeu_ps(p, a)
+#else
+typedef __m128 vfloat;
+#define VSET1(x) _mm_set1_ps(x)
+#define VADD(a, b) _mm_add_ps(a, b)
+#define VSUB(a, b) _mm_sub_ps(a, b)
+#define VMUL(a, b) _mm_mul_ps(a, b)
+#define VSTORE(p, a) _mm_storeu_ps(p, a)
+#endif
+
+// Loads the same transform field of SIMD_WIDTH consecutive transforms
+static vfloat load_transform_field(const Transform *transforms, int field) {
+    const float *f = (const float *)transforms + field;
+#if SIMD_WIDTH == 8
+    __m256i idx = _mm256_setr_epi32(0, 10, 20, 30, 40, 50, 60, 70);
+    return _mm256_i32gather_ps(f, idx, 4);
+#else
+    int s = TRANSFORM_N_FLOATS;
+    return _mm_setr_ps(f[0], f[s], f[2 * s], f[3 * s]);
+#endif
+}
+
+static void compose_transform_matrices_simd(
+    const Transform *transforms, Matrix *matrices
+) {
+    vfloat tx = load_transform_field(transforms, 0);
+    vfloat ty = load_transform_field(transforms, 1);
+    vfloat tz = load_transform_field(transforms, 2);
+    vfloat qx = load_transform_field(transforms, 3);
+    vfloat qy = load_transform_field(transforms, 4);
+    vfloat qz = load_transform_field(transforms, 5);
+    vfloat qw = load_transform_field(transforms, 6);
+    vfloat sx = load_transform_field(transforms, 7);
+    vfloat sy = load_transform_field(transforms, 8);
+    vfloat sz = load_transform_field(transforms, 9);
+
+    vfloat one = VSET1(1.0f);
+    vfloat two = VSET1(2.0f);
+
+    vfloat a2 = VMUL(qx, qx), b2 = VMUL(qy, qy), c2 = VMUL(qz, qz);
+    vfloat ac = VMUL(qx, qz), ab = VMUL(qx, qy), bc = VMUL(qy, qz);
+    vfloat ad = VMUL(qw, qx), bd = VMUL(qw, qy), cd = VMUL(qw, qz);
+
+    // Matrix fields in the raylib declaration order: m0, m4, m8, m12, m1, ...
+    float out[16][SIMD_WIDTH];
+    VSTORE(out[0], VMUL(sx, VSUB(one, VMUL(two, VADD(b2, c2)))));
+    VSTORE(out[1], VMUL(sy, VMUL(two, VSUB(ab, cd))));
+    VSTORE(out[2], VMUL(sz, VMUL(two, VADD(ac, bd))));
+    VSTORE(out[3], tx);
+    VSTORE(out[4], VMUL(sx, VMUL(two, VADD(ab, cd))));
+    VSTORE(out[5], VMUL(sy, VSUB(one, VMUL(two, VADD(a2, c2)))));
+    VSTORE(out[6], VMUL(sz, VMUL(two, VSUB(bc, ad))));
+    VSTORE(out[7], ty);
+    VSTORE(out[8], VMUL(sx, VMUL(two, VSUB(ac, bd))));
+    VSTORE(out[9], VMUL(sy, VMUL(two, VADD(bc, ad))));
+    VSTORE(out[10], VMUL(sz, VSUB(one, VMUL(two, VADD(a2, b2)))));
+    VSTORE(out[11], tz);
+
+    for (int lane = 0; lane < SIMD_WIDTH; ++lane) {
+        float *m = (float *)&matrices[lane];
+        for (int i = 0; i < 12; ++i) m[i] = out[i][lane];
+        m[12] = 0.0f;
+        m[13] = 0.0f;
+        m[14] = 0.0f;
+        m[15] = 1.0f;
+    }
+}
+#endif
+
+void compose_transform_matrices(const Transform *transforms, Matrix *matrices, int n) {
+    int i = 0;
+#if SIMD_WIDTH > 1
+    for (; i + SIMD_WIDTH <= n; i += SIMD_WIDTH) {
+        compose_transform_matrices_simd(&transforms[i], &matrices[i]);
+    }
+#endif
+    for (; i < n; ++i) matrices[i] = get_transform_matrix(transforms[i]);
+}
+
+// -----------------------------------------------------------------------
+// Multiply
+// Matrix memory holds the rows of the math matrix and MatrixMultiply(l, r)
+// is r * l, so every result row is a combination of the rows of l weighted
+// by the elements of the same row of r
+static void multiply_matrix(const float *l, const float *r, float *result) {
+#if SIMD_WIDTH == 8
+    __m256 l0 = _mm256_broadcast_ps((const __m128 *)&l[0]);
+    __m256 l1 = _mm256_broadcast_ps((const __m128 *)&l[4]);
+    __m256 l2 = _mm256_broadcast_ps((const __m128 *)&l[8]);
+    __m256 l3 = _mm256_broadcast_ps((const __m128 *)&l[12]);
+    for (int i = 0; i < 16; i += 8) {
+        __m256 rr = _mm256_loadu_ps(&r[i]);
+        __m256 row = _mm256_mul_ps(_mm256_shuffle_ps(rr, rr, 0x00), l0);
+#if defined(__FMA__)
+        row = _mm256_fmadd_ps(_mm256_shuffle_ps(rr, rr, 0x55), l1, row);
+        row = _mm256_fmadd_ps(_mm256_shuffle_ps(rr, rr, 0xaa), l2, row);
+        row = _mm256_fmadd_ps(_mm256_shuffle_ps(rr, rr, 0xff), l3, row);
+#else
+        row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(rr, rr, 0x55), l1));
+        row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(rr, rr, 0xaa), l2));
+        row = _mm256_add_ps(row, _mm256_mul_ps(_mm256_shuffle_ps(rr, rr, 0xff), l3));
+#endif
+        _mm256_storeu_ps(&result[i], row);
+    }
+#elif SIMD_WIDTH == 4
+    __m128 l0 = _mm_loadu_ps(&l[0]);
+    __m128 l1 = _mm_loadu_ps(&l[4]);
+    __m128 l2 = _mm_loadu_ps(&l[8]);
+    __m128 l3 = _mm_loadu_ps(&l[12]);
+    for (int i = 0; i < 16; i += 4) {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(r[i]), l0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[i + 1]), l1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[i + 2]), l2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(r[i + 3]), l3));
+        _mm_storeu_ps(&result[i], row);
+    }
+#else
+    float tmp[16];
+    for (int i = 0; i < 16; i += 4) {
+        for (int j = 0; j < 4; ++j) {
+            tmp[i + j] = r[i] * l[j] + r[i + 1] * l[4 + j] + r[i + 2] * l[8 + j]
+                         + r[i + 3] * l[12 + j];
+        }
+    }
+    for (int i = 0; i < 16; ++i) result[i] = tmp[i];
+#endif
+}
+
+void multiply_matrices(const Matrix *left, const Matrix *right, Matrix *result, int n) {
+    for (int i = 0; i < n; ++i) {
+        multiply_matrix(
+            (const float *)&left[i], (const float *)&right[i], (float *)&result[i]
+        );
+    }
+}
+
+void multiply_matrices_by(const Matrix *left, Matrix right, Matrix *result, int n) {
+    for (int i = 0; i < n; ++i) {
+        const float *l = (const float *)&left[i];
+        multiply_matrix(l, (const float *)&right, (float *)&result[i]);
+    }
+}
+
+// -----------------------------------------------------------------------
+// Points and spheres
+static Vector3 transform_point(Matrix m, Vector3 p) {
+#if SIMD_WIDTH > 1
+    // Columns of the math matrix, the last lane is unused
+    __m128 c0 = _mm_setr_ps(m.m0, m.m1, m.m2, 0.0f);
+    __m128 c1 = _mm_setr_ps(m.m4, m.m5, m.m6, 0.0f);
+    __m128 c2 = _mm_setr_ps(m.m8, m.m9, m.m10, 0.0f);
+    __m128 c3 = _mm_setr_ps(m.m12, m.m13, m.m14, 0.0f);
+    __m128 v = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), c3);
+    v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+    v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+
+    float out[4];
+    _mm_storeu_ps(out, v);
+    return (Vector3){out[0], out[1], out[2]};
+#else
+    return Vector3Transform(p, m);
+#endif
+}
+
+void transform_points(Matrix matrix, const Vector3 *points, Vector3 *result, int n) {
+#if SIMD_WIDTH > 1
+    __m128 c0 = _mm_setr_ps(matrix.m0, matrix.m1, matrix.m2, 0.0f);
+    __m128 c1 = _mm_setr_ps(matrix.m4, matrix.m5, matrix.m6, 0.0f);
+    __m128 c2 = _mm_setr_ps(matrix.m8, matrix.m9, matrix.m10, 0.0f);
+    __m128 c3 = _mm_setr_ps(matrix.m12, matrix.m13, matrix.m14, 0.0f);
+    for (int i = 0; i < n; ++i) {
+        Vector3 p = points[i];
+        __m128 v = _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), c3);
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(p.y)));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(p.z)));
+
+        float out[4];
+        _mm_storeu_ps(out, v);
+        result[i] = (Vector3){out[0], out[1], out[2]};
+    }
+#else
+    for (int i = 0; i < n; ++i) result[i] = Vector3Transform(points[i], matrix);
+#endif
+}
+
+void transform_spheres(
+    const Matrix *matrices, const BoundingSphere *spheres, BoundingSphere *result, int n
+) {
+    for (int i = 0; i < n; ++i) {
+        Matrix m = matrices[i];
+
+        // The largest axis scale bounds the radius under non-uniform scaling
+        float sx = m.m0 * m.m0 + m.m1 * m.m1 + m.m2 * m.m2;
+        float sy = m.m4 * m.m4 + m.m5 * m.m5 + m.m6 * m.m6;
+        float sz = m.m8 * m.m8 + m.m9 * m.m9 + m.m10 * m.m10;
+        float scale = sqrtf(MAX(sx, MAX(sy, sz)));
+
+        result[i].center = transform_point(m, spheres[i].center);
+        result[i].radius = spheres[i].radius * scale;
+    }
+}
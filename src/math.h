@@ -7,5 +7,23 @@
 #define CLAMP(value, min, max) \
     (((value) < (min)) ? (min) : (((value) > (max)) ? (max) : (value)))
 
+typedef struct BoundingSphere {
+    Vector3 center;
+    float radius;
+} BoundingSphere;
+
 Transform get_default_transform(void);
 Matrix get_transform_matrix(Transform transform);
+BoundingBox get_transformed_box(BoundingBox box, Matrix matrix);
+
+// Batch kernels. They use AVX2 or SSE2 when the compiler targets them and
+// fall back to scalar code otherwise. Matrix order follows raymath, so
+// multiply_matrices computes MatrixMultiply(left[i], right[i])
+const char *get_math_simd_name(void);
+void compose_transform_matrices(const Transform *transforms, Matrix *matrices, int n);
+void multiply_matrices(const Matrix *left, const Matrix *right, Matrix *result, int n);
+void multiply_matrices_by(const Matrix *left, Matrix right, Matrix *result, int n);
+void transform_points(Matrix matrix, const Vector3 *points, Vector3 *result, int n);
+void transform_spheres(
+    const Matrix *matrices, const BoundingSphere *spheres, BoundingSphere *result, int n
+);
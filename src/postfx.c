@@ -0,0 +1,256 @@
+#include "postfx.h"
+
+#include "raylib.h"
+#include "render_stats.h"
+#include "resources.h"
+#include "rlgl.h"
+#include "scene.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Enabled effects drawn by one full-screen pass
+typedef struct PostfxPass {
+    bool with_blur;
+    int n_effects;
+    const PostfxEffect *effects[MAX_N_POSTFX_EFFECTS];
+} PostfxPass;
+
+typedef struct PostfxShader {
+    uint64_t key;
+    Shader shader;
+    int u_strength_loc;
+    int u_color_loc;
+} PostfxShader;
+
+static int N_POSTFX_SHADERS;
+static int NEXT_EVICTED_POSTFX_SHADER;
+static PostfxShader POSTFX_SHADERS[MAX_N_POSTFX_SHADERS];
+
+// Ping-pong targets of the passes before the last one
+static RenderTexture2D PASS_SCREENS[2];
+
+static int get_postfx_passes(const PostfxStack *stack, PostfxPass *passes);
+static uint64_t get_postfx_pass_key(const PostfxPass *pass);
+static PostfxShader *get_postfx_shader(const PostfxPass *pass);
+static Shader compile_postfx_shader(const PostfxPass *pass);
+static RenderTexture2D get_pass_screen(int idx, int width, int height);
+static void draw_postfx_pass(const PostfxPass *pass, Texture2D texture);
+
+PostfxEffect *add_postfx_effect(
+    PostfxStack *stack, PostfxEffectType type, float strength, Color color
+) {
+    if (stack->n_effects == MAX_N_POSTFX_EFFECTS) return NULL;
+
+    PostfxEffect *effect = &stack->effects[stack->n_effects++];
+    *effect = (PostfxEffect){type, true, strength, color};
+    return effect;
+}
+
+void prepare_postfx(const PostfxStack *stack, Texture2D texture) {
+    PostfxPass passes[MAX_N_POSTFX_EFFECTS];
+    int n_passes = get_postfx_passes(stack, passes);
+
+    RenderPass pass = set_render_pass(RENDER_PASS_POSTFX);
+    for (int i = 0; i < n_passes - 1; ++i) {
+        RenderTexture2D screen = get_pass_screen(i % 2, texture.width, texture.height);
+        begin_texture_mode(screen);
+        draw_postfx_pass(&passes[i], texture);
+        end_texture_mode();
+        texture = screen.texture;
+    }
+    set_render_pass(pass);
+}
+
+void draw_postfx(const PostfxStack *stack, Texture2D texture) {
+    PostfxPass passes[MAX_N_POSTFX_EFFECTS];
+    int n_passes = get_postfx_passes(stack, passes);
+
+    if (n_passes > 1) texture = PASS_SCREENS[(n_passes - 2) % 2].texture;
+    RenderPass pass = set_render_pass(RENDER_PASS_POSTFX);
+    draw_postfx_pass(&passes[n_passes - 1], texture);
+    set_render_pass(pass);
+}
+
+int reload_postfx_shaders(const char *file_name) {
+    bool is_used = strcmp(file_name, "postfx.glsl") == 0
+                   || strcmp(file_name, "common.glsl") == 0;
+    if (!is_used) return 0;
+
+    int n_unloaded = N_POSTFX_SHADERS;
+    for (int i = 0; i < N_POSTFX_SHADERS; ++i) {
+        unload_shader(POSTFX_SHADERS[i].shader);
+    }
+    N_POSTFX_SHADERS = 0;
+    NEXT_EVICTED_POSTFX_SHADER = 0;
+    return n_unloaded;
+}
+
+void unload_postfx(void) {
+    reload_postfx_shaders("postfx.glsl");
+    for (int i = 0; i < 2; ++i) {
+        unload_render_texture(PASS_SCREENS[i]);
+        PASS_SCREENS[i] = (RenderTexture2D){0};
+    }
+}
+
+// Always returns at least one pass, a stack without enabled effects is a copy
+static int get_postfx_passes(const PostfxStack *stack, PostfxPass *passes) {
+    int n_passes = 0;
+    PostfxPass *pass = NULL;
+    for (int i = 0; i < stack->n_effects; ++i) {
+        const PostfxEffect *effect = &stack->effects[i];
+        if (!effect->is_enabled) continue;
+
+        if (effect->type == POSTFX_BLUR || pass == NULL) {
+            pass = &passes[n_passes++];
+            *pass = (PostfxPass){0};
+            pass->with_blur = effect->type == POSTFX_BLUR;
+            if (pass->with_blur) continue;
+        }
+        pass->effects[pass->n_effects++] = effect;
+    }
+
+    if (n_passes == 0) passes[n_passes++] = (PostfxPass){0};
+    return n_passes;
+}
+
+// 4 bits per effect type, after the pass source
+static uint64_t get_postfx_pass_key(const PostfxPass *pass) {
+    uint64_t key = pass->with_blur ? 2 : 1;
+    for (int i = 0; i < pass->n_effects; ++i) {
+        key = (key << 4) | (uint64_t)(pass->effects[i]->type + 1);
+    }
+    return key;
+}
+
+static PostfxShader *get_postfx_shader(const PostfxPass *pass) {
+    uint64_t key = get_postfx_pass_key(pass);
+    for (int i = 0; i < N_POSTFX_SHADERS; ++i) {
+        if (POSTFX_SHADERS[i].key == key) return &POSTFX_SHADERS[i];
+    }
+
+    // The cache is only full if the stacks change all the time, the oldest
+    // shaders go first
+    PostfxShader *postfx_shader;
+    if (N_POSTFX_SHADERS < MAX_N_POSTFX_SHADERS) {
+        postfx_shader = &POSTFX_SHADERS[N_POSTFX_SHADERS++];
+    } else {
+        postfx_shader = &POSTFX_SHADERS[NEXT_EVICTED_POSTFX_SHADER];
+        NEXT_EVICTED_POSTFX_SHADER += 1;
+        NEXT_EVICTED_POSTFX_SHADER %= MAX_N_POSTFX_SHADERS;
+        unload_shader(postfx_shader->shader);
+    }
+
+    ResourceOwner owner = set_resource_owner(OWNER_CORE);
+    Shader shader = track_shader(compile_postfx_shader(pass), "postfx");
+    set_resource_owner(owner);
+
+    postfx_shader->key = key;
+    postfx_shader->shader = shader;
+    postfx_shader->u_strength_loc = get_shader_location(shader, "u_strength");
+    postfx_shader->u_color_loc = get_shader_location(shader, "u_color");
+    return postfx_shader;
+}
+
+static Shader compile_postfx_shader(const PostfxPass *pass) {
+    char *effects_src = LoadFileText("resources/shaders/postfx.glsl");
+    if (effects_src == NULL) {
+        TraceLog(LOG_WARNING, "POSTFX: Failed to load postfx.glsl");
+    }
+
+    int size = (effects_src ? strlen(effects_src) : 0) + 1024 + 128 * pass->n_effects;
+    char *src = malloc(size);
+
+    int p = 0;
+    p += sprintf(
+        &src[p],
+        "in vec2 fragTexCoord;\n"
+        "uniform sampler2D texture0;\n"
+        "uniform float u_strength[%d];\n"
+        "uniform vec3 u_color[%d];\n"
+        "out vec4 finalColor;\n"
+        "%s\n"
+        "void main() {\n"
+        "    vec2 uv = fragTexCoord;\n",
+        MAX_N_POSTFX_EFFECTS,
+        MAX_N_POSTFX_EFFECTS,
+        effects_src ? effects_src : ""
+    );
+
+    if (pass->with_blur) {
+        p += sprintf(&src[p], "    vec3 color = blur_texture(texture0, uv).rgb;\n");
+    } else {
+        p += sprintf(&src[p], "    vec3 color = texture(texture0, uv).rgb;\n");
+    }
+
+    // Effect functions are named after the effect types
+    for (int i = 0; i < pass->n_effects; ++i) {
+        const char *name = POSTFX_EFFECT_TYPE_TO_NAME(pass->effects[i]->type);
+        const char *fmt = "    color = %s(color, uv, u_strength[%d], u_color[%d]);\n";
+        p += sprintf(&src[p], fmt, name, i, i);
+    }
+    sprintf(&src[p], "    finalColor = vec4(color, 1.0);\n}\n");
+
+    Shader shader = compile_fragment_shader(src);
+    if (shader.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "POSTFX: Failed to compile the pass shader");
+    }
+
+    free(src);
+    if (effects_src) UnloadFileText(effects_src);
+    return shader;
+}
+
+static RenderTexture2D get_pass_screen(int idx, int width, int height) {
+    RenderTexture2D *screen = &PASS_SCREENS[idx];
+    if (screen->texture.width != width || screen->texture.height != height) {
+        ResourceOwner owner = set_resource_owner(OWNER_CORE);
+        unload_render_texture(*screen);
+        *screen = track_render_texture(LoadRenderTexture(width, height), "postfx_pass");
+        set_resource_owner(owner);
+    }
+    return *screen;
+}
+
+static void draw_postfx_pass(const PostfxPass *pass, Texture2D texture) {
+    PostfxShader *postfx_shader = get_postfx_shader(pass);
+
+    float strengths[MAX_N_POSTFX_EFFECTS];
+    Vector3 colors[MAX_N_POSTFX_EFFECTS];
+    for (int i = 0; i < pass->n_effects; ++i) {
+        const PostfxEffect *effect = pass->effects[i];
+        strengths[i] = effect->strength;
+        colors[i] = (Vector3){
+            effect->color.r / 255.0f, effect->color.g / 255.0f, effect->color.b / 255.0f
+        };
+    }
+
+    Shader shader = postfx_shader->shader;
+    begin_shader_mode(shader);
+    if (pass->n_effects > 0) {
+        set_shader_value_v(
+            shader,
+            postfx_shader->u_strength_loc,
+            strengths,
+            SHADER_UNIFORM_FLOAT,
+            pass->n_effects
+        );
+        set_shader_value_v(
+            shader,
+            postfx_shader->u_color_loc,
+            colors,
+            SHADER_UNIFORM_VEC3,
+            pass->n_effects
+        );
+    }
+    DrawTextureRec(
+        texture,
+        (Rectangle){0, 0, (float)texture.width, (float)-texture.height},
+        (Vector2){0, 0},
+        WHITE
+    );
+    count_batch_draw(texture.id);
+    end_shader_mode();
+}
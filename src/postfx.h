@@ -0,0 +1,74 @@
+#pragma once
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Post-processing stack. The effects are applied in the stack order, and the
+// enabled ones are grouped into passes: a pass starts from a plain or a
+// neighborhood (blur) read of its input and then applies every per-pixel
+// effect up to the next neighborhood effect. Each pass is one fragment shader
+// generated for exactly its effects and cached by the effect sequence, so a
+// stack without neighborhood effects costs one full-screen read and write.
+//
+// The per-pixel effect functions live in resources/shaders/postfx.glsl
+#define MAX_N_POSTFX_EFFECTS 8
+#define MAX_N_POSTFX_SHADERS 32
+
+typedef enum PostfxEffectType {
+    // Neighborhood effects, each one starts a new pass
+    POSTFX_BLUR = 0,
+
+    // Per-pixel effects
+    POSTFX_DIM,
+    POSTFX_VIGNETTE,
+    POSTFX_COLOR_GRADE,
+    POSTFX_FLASH,
+    POSTFX_FADE,
+    N_POSTFX_EFFECT_TYPES,
+} PostfxEffectType;
+
+#define POSTFX_EFFECT_TYPE_TO_NAME(type) \
+    ((type == POSTFX_BLUR)          ? "blur" \
+     : (type == POSTFX_DIM)         ? "dim" \
+     : (type == POSTFX_VIGNETTE)    ? "vignette" \
+     : (type == POSTFX_COLOR_GRADE) ? "color_grade" \
+     : (type == POSTFX_FLASH)       ? "flash" \
+     : (type == POSTFX_FADE)        ? "fade" \
+                                    : "unknown")
+
+// The meaning of the strength depends on the effect:
+// dim - color multiplier,
+// vignette - darkening of the corners,
+// color_grade - saturation (1.0 keeps the colors), the color is a tint,
+// flash - amount of the color added,
+// fade - amount of the color mixed in.
+// Blur ignores both
+typedef struct PostfxEffect {
+    PostfxEffectType type;
+    bool is_enabled;
+    float strength;
+    Color color;
+} PostfxEffect;
+
+typedef struct PostfxStack {
+    int n_effects;
+    PostfxEffect effects[MAX_N_POSTFX_EFFECTS];
+} PostfxStack;
+
+// Returns the added effect, or NULL if the stack is full
+PostfxEffect *add_postfx_effect(
+    PostfxStack *stack, PostfxEffectType type, float strength, Color color
+);
+
+// Draws every pass but the last one into the internal targets. Call it before
+// the final target is bound, the passes rebind the default framebuffer
+void prepare_postfx(const PostfxStack *stack, Texture2D texture);
+
+// Draws the last pass into the currently bound target. The texture must be the
+// one the stack was prepared with
+void draw_postfx(const PostfxStack *stack, Texture2D texture);
+
+// Unloads the cached shaders if the changed shader file is used by them, they
+// are generated again on the next draw. Returns the number of unloaded shaders
+int reload_postfx_shaders(const char *file_name);
+void unload_postfx(void);
@@ -0,0 +1,130 @@
+#include "profiler.h"
+
+#include "jobs.h"
+#include "raylib.h"
+#include <stdio.h>
+
+#define MAX_N_PROFILE_THREADS (MAX_N_JOB_WORKERS + 1)
+
+typedef struct ProfileZone {
+    const char *name;
+    double begin_time;
+    double end_time;
+} ProfileZone;
+
+// Written only by its thread. The zone at n_zones % MAX_N_PROFILE_ZONES is the
+// next one to be overwritten
+typedef struct ProfileRing {
+    long n_zones;
+    ProfileZone zones[MAX_N_PROFILE_ZONES];
+} ProfileRing;
+
+static ProfileRing RINGS[MAX_N_PROFILE_THREADS];
+
+// Main thread only
+static long N_FRAMES;
+static double FRAME_TIMES[MAX_N_PROFILE_FRAMES];
+static float BUDGET_MS = DEFAULT_PROFILE_BUDGET_MS;
+static int N_HITCH_FRAMES = DEFAULT_N_PROFILE_HITCH_FRAMES;
+static long LAST_HITCH_FRAME = -1;
+
+static bool save_profile_since(const char *file_path, double begin_time);
+
+void add_profile_zone(const char *name, double begin_time) {
+    int thread_id = get_job_thread_id();
+    if (thread_id < 0) return;
+
+    double end_time = get_trace_time();
+    ProfileRing *ring = &RINGS[thread_id];
+    long n = __atomic_load_n(&ring->n_zones, __ATOMIC_RELAXED);
+
+    // The count of the previous zone becomes visible before this zone
+    // overwrites the slot, so a reader which saw the slot change sees it too
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ring->zones[n % MAX_N_PROFILE_ZONES] = (ProfileZone){name, begin_time, end_time};
+    __atomic_store_n(&ring->n_zones, n + 1, __ATOMIC_RELEASE);
+}
+
+void mark_profile_frame(void) {
+    double time = get_trace_time();
+    if (N_FRAMES > 0) {
+        double frame_begin_time = FRAME_TIMES[(N_FRAMES - 1) % MAX_N_PROFILE_FRAMES];
+        add_profile_zone("frame", frame_begin_time);
+
+        // A long hitch is saved once, not on every one of its slow frames. The
+        // first frames are covered by the startup trace
+        double frame_time = time - frame_begin_time;
+        long n_frames = N_FRAMES < N_HITCH_FRAMES ? N_FRAMES : N_HITCH_FRAMES;
+        bool is_hitch = BUDGET_MS > 0.0 && frame_time > BUDGET_MS
+                        && N_FRAMES - LAST_HITCH_FRAME > N_HITCH_FRAMES;
+        if (is_hitch) {
+            char file_path[64];
+            snprintf(file_path, sizeof(file_path), "profile_hitch_%ld.json", N_FRAMES);
+            TraceLog(
+                LOG_WARNING,
+                "PROFILER: Frame %ld took %.1f ms, budget is %.1f ms",
+                N_FRAMES,
+                frame_time,
+                BUDGET_MS
+            );
+            long first_frame = (N_FRAMES - n_frames) % MAX_N_PROFILE_FRAMES;
+            save_profile_since(file_path, FRAME_TIMES[first_frame]);
+            LAST_HITCH_FRAME = N_FRAMES;
+        }
+    }
+
+    FRAME_TIMES[N_FRAMES % MAX_N_PROFILE_FRAMES] = time;
+    N_FRAMES += 1;
+}
+
+void set_profile_budget(float budget_ms, int n_frames) {
+    BUDGET_MS = budget_ms;
+    if (n_frames < 1) n_frames = 1;
+    if (n_frames > MAX_N_PROFILE_FRAMES - 1) n_frames = MAX_N_PROFILE_FRAMES - 1;
+    N_HITCH_FRAMES = n_frames;
+}
+
+bool save_profile(const char *file_path) {
+    return save_profile_since(file_path, 0.0);
+}
+
+// The thread names are always there, the zones only when they end after the
+// begin time
+static bool save_profile_since(const char *file_path, double begin_time) {
+    TraceWriter writer;
+    if (!open_trace_writer(&writer, file_path)) return false;
+
+    int n_threads = get_job_stats().n_workers + 1;
+    for (int i = 0; i < n_threads; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s %d", i == 0 ? "main" : "worker", i);
+        write_trace_thread_name(&writer, i, name);
+    }
+
+    int n_saved = 0;
+    for (int i = 0; i < n_threads; ++i) {
+        ProfileRing *ring = &RINGS[i];
+        long end = __atomic_load_n(&ring->n_zones, __ATOMIC_ACQUIRE);
+        long begin = end > MAX_N_PROFILE_ZONES ? end - MAX_N_PROFILE_ZONES : 0;
+
+        for (long j = begin; j < end; ++j) {
+            ProfileZone zone = ring->zones[j % MAX_N_PROFILE_ZONES];
+
+            // The thread keeps recording while the ring is read. Like a
+            // seqlock, the count is read again after the copy: the slot is
+            // being overwritten once the count reaches j + MAX_N_PROFILE_ZONES,
+            // before the count is incremented past it
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            long n_zones = __atomic_load_n(&ring->n_zones, __ATOMIC_RELAXED);
+            if (j <= n_zones - MAX_N_PROFILE_ZONES) continue;
+            if (zone.begin_time < begin_time) continue;
+
+            write_trace_event(&writer, zone.name, i, zone.begin_time, zone.end_time);
+            n_saved += 1;
+        }
+    }
+    close_trace_writer(&writer);
+
+    TraceLog(LOG_INFO, "PROFILER: Saved %d zones to %s", n_saved, file_path);
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "trace.h"
+#include <stdbool.h>
+
+// CPU zone profiler. Zones are recorded from any thread into the ring of that
+// thread, so recording takes no locks: the thread is the only writer of its
+// ring and readers skip the zones overwritten while they read. The rings keep
+// the most recent zones and are saved in the Chrome trace format.
+//
+// The flight recorder checks every frame against the budget. When a frame is
+// slower, the zones of the last frames are saved to profile_hitch_<frame>.json
+//
+// Zones of the threads outside the job system, which have no ring, are dropped.
+// Zones are recorded only with PROFILER defined (make PROFILER=ON), otherwise
+// the macros compile to nothing. Zone names are identifiers, so the begin and
+// the end of a zone are paired by the compiler
+#define MAX_N_PROFILE_ZONES 8192
+#define MAX_N_PROFILE_FRAMES 256
+#define DEFAULT_PROFILE_BUDGET_MS 33.3
+#define DEFAULT_N_PROFILE_HITCH_FRAMES 60
+
+#ifdef PROFILER
+#define PROFILE_BEGIN(name) double profile_##name##_time = get_trace_time()
+#define PROFILE_END(name) add_profile_zone(#name, profile_##name##_time)
+#define PROFILE_FRAME() mark_profile_frame()
+#else
+#define PROFILE_BEGIN(name)
+#define PROFILE_END(name) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#endif
+
+// The name must outlive the profiler
+void add_profile_zone(const char *name, double begin_time);
+
+// Called by the main thread at the start of every frame
+void mark_profile_frame(void);
+
+// Zero budget disables the flight recorder. At most MAX_N_PROFILE_FRAMES - 1
+// frames are saved
+void set_profile_budget(float budget_ms, int n_frames);
+
+bool save_profile(const char *file_path);
@@ -0,0 +1,226 @@
+#include "render_queue.h"
+
+#include "drawing.h"
+#include "profiler.h"
+#include "raylib.h"
+#include "raymath.h"
+#include "render_stats.h"
+#include "rlgl.h"
+#include <string.h>
+
+// MAX_MATERIAL_MAPS of the raylib config, the size of the material maps array
+#define N_MATERIAL_MAPS 12
+
+#define DEPTH_MASK 0xFFFFFF
+
+static int N_PACKETS;
+static RenderPacket PACKETS[MAX_N_RENDER_PACKETS];
+
+// Keys and packet indices, sorted back and forth between the two buffers
+static uint64_t KEYS[2][MAX_N_RENDER_PACKETS];
+static int ORDER[2][MAX_N_RENDER_PACKETS];
+
+static RenderQueueStats STATS;
+
+static const int *sort_render_packets(void);
+static void draw_packet_mesh(const RenderPacket *packet);
+static void set_uniform(int loc, const void *value, int type);
+static void set_uniform_matrix(int loc, Matrix matrix);
+
+// The bits of a non-negative float compare as the float does, the highest 24
+// of them keep 15 bits of the mantissa
+uint64_t get_render_key(
+    int layer,
+    int order,
+    bool is_translucent,
+    unsigned int shader_id,
+    unsigned int texture_id,
+    float depth
+) {
+    uint32_t depth_bits = 0;
+    if (depth > 0.0) memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    uint64_t d = depth_bits >> 8;
+    uint64_t s = shader_id & 0xFFFF;
+    uint64_t t = texture_id & 0xFFFF;
+
+    uint64_t key = (uint64_t)(layer & 0xF) << 60 | (uint64_t)(order & 0xF) << 56;
+    if (is_translucent) key |= (DEPTH_MASK - d) << 32 | s << 16 | t;
+    else key |= s << 40 | t << 24 | d;
+    return key;
+}
+
+void begin_render_queue(void) {
+    N_PACKETS = 0;
+}
+
+// Capacity is above the trees and the items a scene can have
+void push_render_packet(RenderPacket packet) {
+    if (N_PACKETS == MAX_N_RENDER_PACKETS) {
+        TraceLog(LOG_WARNING, "RENDER_QUEUE: Queue is full, the packet is dropped");
+        return;
+    }
+    PACKETS[N_PACKETS++] = packet;
+}
+
+void draw_render_queue(void) {
+    PROFILE_BEGIN(sort_render_queue);
+    double time = GetTime();
+    const int *order = sort_render_packets();
+    STATS.n_packets = N_PACKETS;
+    STATS.sort_ms = (GetTime() - time) * 1000.0;
+    PROFILE_END(sort_render_queue);
+
+    PROFILE_BEGIN(submit_render_queue);
+    Matrix view = rlGetMatrixModelview();
+    Matrix projection = rlGetMatrixProjection();
+    Matrix view_projection = MatrixMultiply(view, projection);
+    RenderPass pass = set_render_pass(RENDER_PASS_OTHER);
+
+    // What the queue has bound, 0 when it's unknown
+    unsigned int shader_id = 0;
+    unsigned int texture_id = 0;
+    unsigned int vao_id = 0;
+    Color color = {0};
+    Vector4 param = {0};
+    int param_loc = -1;
+    for (int i = 0; i < N_PACKETS; ++i) {
+        const RenderPacket *packet = &PACKETS[order[i]];
+        const int *locs = packet->shader.locs;
+        set_render_pass(packet->pass);
+
+        // Vertex arrays are there on the desktop GL and WebGL2. Without them
+        // the packet is drawn by raylib, which leaves nothing bound
+        unsigned int mesh_vao_id = packet->mesh->vaoId;
+        bool is_new_vao = mesh_vao_id != vao_id;
+        if (mesh_vao_id == 0 || (is_new_vao && !rlEnableVertexArray(mesh_vao_id))) {
+            draw_packet_mesh(packet);
+            shader_id = texture_id = vao_id = 0;
+            continue;
+        }
+        vao_id = mesh_vao_id;
+
+        bool is_new_shader = packet->shader.id != shader_id;
+        if (is_new_shader) {
+            shader_id = packet->shader.id;
+            rlEnableShader(shader_id);
+            count_program_use(shader_id);
+
+            int texture_slot = 0;
+            set_uniform(locs[SHADER_LOC_MAP_DIFFUSE], &texture_slot, SHADER_UNIFORM_INT);
+            set_uniform_matrix(locs[SHADER_LOC_MATRIX_VIEW], view);
+            set_uniform_matrix(locs[SHADER_LOC_MATRIX_PROJECTION], projection);
+            set_uniform_matrix(locs[SHADER_LOC_MATRIX_MODEL], MatrixIdentity());
+        }
+
+        if (packet->texture_id != texture_id) {
+            texture_id = packet->texture_id;
+            rlActiveTextureSlot(0);
+            rlEnableTexture(texture_id);
+            count_texture_bind();
+        }
+
+        bool is_new_color = memcmp(&packet->color, &color, sizeof(Color)) != 0;
+        if (is_new_shader || is_new_color) {
+            color = packet->color;
+            Vector4 value = ColorNormalize(color);
+            set_uniform(locs[SHADER_LOC_COLOR_DIFFUSE], &value, SHADER_UNIFORM_VEC4);
+        }
+
+        bool is_new_param = packet->param_loc != param_loc
+                            || memcmp(&packet->param, &param, sizeof(Vector4)) != 0;
+        if (is_new_shader || is_new_param) {
+            param_loc = packet->param_loc;
+            param = packet->param;
+            set_uniform(param_loc, &param, SHADER_UNIFORM_VEC4);
+        }
+
+        Matrix mvp = MatrixMultiply(packet->matrix, view_projection);
+        set_uniform_matrix(locs[SHADER_LOC_MATRIX_MVP], mvp);
+        if (locs[SHADER_LOC_MATRIX_NORMAL] != -1) {
+            Matrix normal = MatrixTranspose(MatrixInvert(packet->matrix));
+            set_uniform_matrix(locs[SHADER_LOC_MATRIX_NORMAL], normal);
+        }
+
+        const Mesh *mesh = packet->mesh;
+        if (mesh->indices) rlDrawVertexArrayElements(0, mesh->triangleCount * 3, 0);
+        else rlDrawVertexArray(0, mesh->vertexCount);
+        count_draw_call();
+    }
+
+    rlActiveTextureSlot(0);
+    rlDisableTexture();
+    rlDisableVertexArray();
+    rlDisableShader();
+    set_render_pass(pass);
+    PROFILE_END(submit_render_queue);
+}
+
+RenderQueueStats get_render_queue_stats(void) {
+    return STATS;
+}
+
+// LSD radix sort by bytes, stable, so the packets with equal keys stay in the
+// order they were pushed. Passes where all the keys have the same byte are
+// skipped, most of the high bytes are shared by the whole layer
+static const int *sort_render_packets(void) {
+    int src = 0;
+    for (int i = 0; i < N_PACKETS; ++i) {
+        KEYS[src][i] = PACKETS[i].key;
+        ORDER[src][i] = i;
+    }
+    if (N_PACKETS == 0) return ORDER[src];
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256] = {0};
+        for (int i = 0; i < N_PACKETS; ++i) {
+            offsets[(KEYS[src][i] >> shift) & 0xFF] += 1;
+        }
+        if (offsets[(KEYS[src][0] >> shift) & 0xFF] == N_PACKETS) continue;
+
+        int offset = 0;
+        for (int i = 0; i < 256; ++i) {
+            int count = offsets[i];
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        int dst = 1 - src;
+        for (int i = 0; i < N_PACKETS; ++i) {
+            uint64_t key = KEYS[src][i];
+            int j = offsets[(key >> shift) & 0xFF]++;
+            KEYS[dst][j] = key;
+            ORDER[dst][j] = ORDER[src][i];
+        }
+        src = dst;
+    }
+
+    return ORDER[src];
+}
+
+static void draw_packet_mesh(const RenderPacket *packet) {
+    MaterialMap maps[N_MATERIAL_MAPS] = {0};
+    maps[MATERIAL_MAP_DIFFUSE].texture.id = packet->texture_id;
+    maps[MATERIAL_MAP_DIFFUSE].color = packet->color;
+
+    Material material = {0};
+    material.shader = packet->shader;
+    material.maps = maps;
+    if (packet->param_loc != -1) {
+        set_shader_value(
+            packet->shader, packet->param_loc, &packet->param, SHADER_UNIFORM_VEC4
+        );
+    }
+    draw_mesh_m(packet->matrix, material, *packet->mesh);
+}
+
+static void set_uniform(int loc, const void *value, int type) {
+    if (loc == -1) return;
+    rlSetUniform(loc, value, type, 1);
+    count_uniform_upload();
+}
+
+static void set_uniform_matrix(int loc, Matrix matrix) {
+    if (loc == -1) return;
+    rlSetUniformMatrix(loc, matrix);
+    count_uniform_upload();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "raylib.h"
+#include "render_stats.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Render queue of the 3D meshes. The passes push draw packets in any order,
+// the queue radix sorts them by their 64-bit keys and submits them with rlgl,
+// binding the program, the texture, the vertex array and the uniforms only
+// when they differ from the previous packet.
+//
+// Key bits, from the highest:
+//   layer (4), order (4), then
+//   opaque:      shader (16), texture (16), depth front to back (24)
+//   translucent: depth back to front (24), shader (16), texture (16)
+// Order is a fixed draw order inside the layer, for the draws which are stacked
+// on each other. The translucent layers are blended in the painter's order, the
+// opaque ones are grouped by state
+#define MAX_N_RENDER_PACKETS 8192
+#define MAX_N_RENDER_LAYERS 16
+#define MAX_N_RENDER_ORDERS 16
+
+// Mesh is borrowed, it must stay in place until the queue is drawn. Like
+// draw_mesh_m, the packet draws with the identity model matrix uniform and the
+// matrix is applied to the mvp only
+typedef struct RenderPacket {
+    uint64_t key;
+    RenderPass pass;
+    Matrix matrix;
+    const Mesh *mesh;
+    Shader shader;
+    unsigned int texture_id;
+    Color color;
+
+    // Optional vec4 uniform of the packet, -1 for none
+    int param_loc;
+    Vector4 param;
+} RenderPacket;
+
+typedef struct RenderQueueStats {
+    int n_packets;
+    double sort_ms;
+} RenderQueueStats;
+
+// Depth is the distance to the camera
+uint64_t get_render_key(
+    int layer,
+    int order,
+    bool is_translucent,
+    unsigned int shader_id,
+    unsigned int texture_id,
+    float depth
+);
+
+void begin_render_queue(void);
+void push_render_packet(RenderPacket packet);
+
+// Draws with the current rlgl view and projection, inside the 3D mode
+void draw_render_queue(void);
+
+RenderQueueStats get_render_queue_stats(void);
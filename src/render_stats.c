@@ -0,0 +1,231 @@
+#include "render_stats.h"
+
+#include "raylib.h"
+#include "rlgl.h"
+
+// MAX_MATERIAL_MAPS of the raylib config, the size of the material maps array
+#define N_MATERIAL_MAPS 12
+
+static RenderPass PASS;
+static RenderStats STATS;
+static RenderStats LAST_STATS;
+
+// Shader and texture of the rlgl batch, 0 is the default shader. The program is
+// the last one a draw used
+static unsigned int BATCH_SHADER_ID;
+static unsigned int BATCH_TEXTURE_ID;
+static int BATCH_N_DRAWS;
+static unsigned int PROGRAM_ID;
+
+static RenderCounters *get_pass_counters(void);
+static void use_program(unsigned int id);
+static void flush_batch(void);
+static void set_batch_shader(unsigned int id);
+
+RenderPass set_render_pass(RenderPass pass) {
+    RenderPass prev_pass = PASS;
+    PASS = pass;
+    return prev_pass;
+}
+
+void end_render_frame(void) {
+    // EndDrawing draws what is left in the batch
+    flush_batch();
+
+    RenderCounters total = {0};
+    for (int i = 0; i < N_RENDER_PASSES; ++i) {
+        RenderCounters c = STATS.passes[i];
+        total.n_draw_calls += c.n_draw_calls;
+        total.n_texture_binds += c.n_texture_binds;
+        total.n_shader_switches += c.n_shader_switches;
+        total.n_location_lookups += c.n_location_lookups;
+        total.n_uniform_uploads += c.n_uniform_uploads;
+        total.n_batch_flushes += c.n_batch_flushes;
+    }
+    STATS.total = total;
+
+    LAST_STATS = STATS;
+    STATS = (RenderStats){0};
+    PASS = RENDER_PASS_OTHER;
+}
+
+RenderStats get_render_stats(void) {
+    return LAST_STATS;
+}
+
+void log_render_stats(void) {
+    TraceLog(
+        LOG_INFO,
+        "RENDER_STATS: %-8s %6s %6s %8s %8s %8s %7s",
+        "pass",
+        "draws",
+        "binds",
+        "switches",
+        "lookups",
+        "uniforms",
+        "flushes"
+    );
+    for (int i = 0; i <= N_RENDER_PASSES; ++i) {
+        RenderCounters c = i < N_RENDER_PASSES ? LAST_STATS.passes[i] : LAST_STATS.total;
+        TraceLog(
+            LOG_INFO,
+            "RENDER_STATS: %-8s %6d %6d %8d %8d %8d %7d",
+            i < N_RENDER_PASSES ? RENDER_PASS_TO_NAME(i) : "total",
+            c.n_draw_calls,
+            c.n_texture_binds,
+            c.n_shader_switches,
+            c.n_location_lookups,
+            c.n_uniform_uploads,
+            c.n_batch_flushes
+        );
+    }
+}
+
+int get_shader_location(Shader shader, const char *name) {
+    get_pass_counters()->n_location_lookups += 1;
+    return GetShaderLocation(shader, name);
+}
+
+// Raylib binds the program for every upload and doesn't unbind it
+void set_shader_value(Shader shader, int loc, const void *value, int type) {
+    set_shader_value_v(shader, loc, value, type, 1);
+}
+
+void set_shader_value_v(
+    Shader shader, int loc, const void *value, int type, int count
+) {
+    if (loc > -1) {
+        use_program(shader.id);
+        get_pass_counters()->n_uniform_uploads += 1;
+    }
+    SetShaderValueV(shader, loc, value, type, count);
+}
+
+void set_shader_value_matrix(Shader shader, int loc, Matrix matrix) {
+    if (loc > -1) {
+        use_program(shader.id);
+        get_pass_counters()->n_uniform_uploads += 1;
+    }
+    SetShaderValueMatrix(shader, loc, matrix);
+}
+
+// Switching the batch shader draws the batch
+void begin_shader_mode(Shader shader) {
+    set_batch_shader(shader.id);
+    BeginShaderMode(shader);
+}
+
+void end_shader_mode(void) {
+    set_batch_shader(0);
+    EndShaderMode();
+}
+
+// Every mode change draws the batch
+void begin_texture_mode(RenderTexture2D target) {
+    flush_batch();
+    BeginTextureMode(target);
+}
+
+void end_texture_mode(void) {
+    flush_batch();
+    EndTextureMode();
+}
+
+void begin_mode_3d(Camera3D camera) {
+    flush_batch();
+    BeginMode3D(camera);
+}
+
+void end_mode_3d(void) {
+    flush_batch();
+    EndMode3D();
+}
+
+// DrawMesh binds the program, the textures of the material maps and uploads
+// the matrices and the diffuse color the shader has locations for
+void count_mesh_draw(Material material) {
+    RenderCounters *counters = get_pass_counters();
+    counters->n_draw_calls += 1;
+    use_program(material.shader.id);
+
+    int *locs = material.shader.locs;
+    if (locs) {
+        int uniform_locs[] = {
+            SHADER_LOC_MATRIX_MVP,
+            SHADER_LOC_MATRIX_VIEW,
+            SHADER_LOC_MATRIX_PROJECTION,
+            SHADER_LOC_MATRIX_MODEL,
+            SHADER_LOC_MATRIX_NORMAL,
+            SHADER_LOC_COLOR_DIFFUSE};
+        int n_uniform_locs = sizeof(uniform_locs) / sizeof(int);
+        for (int i = 0; i < n_uniform_locs; ++i) {
+            counters->n_uniform_uploads += locs[uniform_locs[i]] != -1;
+        }
+    }
+
+    for (int i = 0; material.maps && i < N_MATERIAL_MAPS; ++i) {
+        counters->n_texture_binds += material.maps[i].texture.id > 0;
+    }
+}
+
+void count_batch_draw(unsigned int texture_id) {
+    BATCH_N_DRAWS += 1;
+    if (texture_id == BATCH_TEXTURE_ID) return;
+
+    BATCH_TEXTURE_ID = texture_id;
+    RenderCounters *counters = get_pass_counters();
+    counters->n_draw_calls += 1;
+    counters->n_texture_binds += 1;
+}
+
+// Raylib draws the shapes with the font texture, unless SetShapesTexture is used
+void count_shapes_draw(void) {
+    count_batch_draw(GetFontDefault().texture.id);
+}
+
+void count_batch_flush(void) {
+    flush_batch();
+}
+
+void count_program_use(unsigned int shader_id) {
+    use_program(shader_id);
+}
+
+void count_texture_bind(void) {
+    get_pass_counters()->n_texture_binds += 1;
+}
+
+void count_uniform_upload(void) {
+    get_pass_counters()->n_uniform_uploads += 1;
+}
+
+void count_draw_call(void) {
+    get_pass_counters()->n_draw_calls += 1;
+}
+
+static RenderCounters *get_pass_counters(void) {
+    return &STATS.passes[PASS];
+}
+
+static void use_program(unsigned int id) {
+    if (id == PROGRAM_ID) return;
+    PROGRAM_ID = id;
+    get_pass_counters()->n_shader_switches += 1;
+}
+
+static void flush_batch(void) {
+    if (BATCH_N_DRAWS > 0) {
+        get_pass_counters()->n_batch_flushes += 1;
+        use_program(BATCH_SHADER_ID ? BATCH_SHADER_ID : rlGetShaderIdDefault());
+    }
+    BATCH_N_DRAWS = 0;
+    BATCH_TEXTURE_ID = 0;
+}
+
+static void set_batch_shader(unsigned int id) {
+    if (id == rlGetShaderIdDefault()) id = 0;
+    if (id == BATCH_SHADER_ID) return;
+
+    flush_batch();
+    BATCH_SHADER_ID = id;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "raylib.h"
+
+// Per-frame render counters. The draw and state calls of the renderer go
+// through the wrappers below, which count what raylib issues for them and call
+// it. Counters are kept per pass, the pass is set by the code which draws it.
+//
+// rlgl doesn't expose its batch, so the batched 2D draws are counted by the
+// texture they switch the batch to (one draw call and one bind per switch),
+// and a flush is counted when a mode or shader switch draws a non-empty batch
+typedef enum RenderPass {
+    RENDER_PASS_OTHER = 0,
+    RENDER_PASS_SHADOWS,
+    RENDER_PASS_SKY,
+    RENDER_PASS_GOLOVA,
+    RENDER_PASS_FOREST,
+    RENDER_PASS_BOARD,
+    RENDER_PASS_ITEMS,
+    RENDER_PASS_POSTFX,
+    RENDER_PASS_UI,
+    N_RENDER_PASSES,
+} RenderPass;
+
+#define RENDER_PASS_TO_NAME(pass) \
+    ((pass == RENDER_PASS_OTHER)     ? "other" \
+     : (pass == RENDER_PASS_SHADOWS) ? "shadows" \
+     : (pass == RENDER_PASS_SKY)     ? "sky" \
+     : (pass == RENDER_PASS_GOLOVA)  ? "golova" \
+     : (pass == RENDER_PASS_FOREST)  ? "forest" \
+     : (pass == RENDER_PASS_BOARD)   ? "board" \
+     : (pass == RENDER_PASS_ITEMS)   ? "items" \
+     : (pass == RENDER_PASS_POSTFX)  ? "postfx" \
+     : (pass == RENDER_PASS_UI)      ? "ui" \
+                                     : "unknown")
+
+typedef struct RenderCounters {
+    int n_draw_calls;
+    int n_texture_binds;
+
+    // Program changes between consecutive draws and uniform uploads
+    int n_shader_switches;
+    int n_location_lookups;
+    int n_uniform_uploads;
+    int n_batch_flushes;
+} RenderCounters;
+
+typedef struct RenderStats {
+    RenderCounters passes[N_RENDER_PASSES];
+    RenderCounters total;
+} RenderStats;
+
+// Returns the previous pass
+RenderPass set_render_pass(RenderPass pass);
+
+// Called after EndDrawing, the finished frame becomes the one get_render_stats
+// returns
+void end_render_frame(void);
+RenderStats get_render_stats(void);
+void log_render_stats(void);
+
+int get_shader_location(Shader shader, const char *name);
+void set_shader_value(Shader shader, int loc, const void *value, int type);
+void set_shader_value_v(
+    Shader shader, int loc, const void *value, int type, int count
+);
+void set_shader_value_matrix(Shader shader, int loc, Matrix matrix);
+
+void begin_shader_mode(Shader shader);
+void end_shader_mode(void);
+void begin_texture_mode(RenderTexture2D target);
+void end_texture_mode(void);
+void begin_mode_3d(Camera3D camera);
+void end_mode_3d(void);
+
+// Draws which raylib submits by itself: DrawMesh, and the 2D draws into the
+// rlgl batch. A batch flush of the caller, e.g. rlCheckRenderBatchLimit
+// returning true, is counted with count_batch_flush
+void count_mesh_draw(Material material);
+void count_batch_draw(unsigned int texture_id);
+void count_shapes_draw(void);
+void count_batch_flush(void);
+
+// Draws submitted with rlgl directly, e.g. by the render queue
+void count_program_use(unsigned int shader_id);
+void count_texture_bind(void);
+void count_uniform_upload(void);
+void count_draw_call(void);
@@ -0,0 +1,210 @@
+#include "resources.h"
+
+#include "audio.h"
+#include "raylib.h"
+#include <stdint.h>
+#include <string.h>
+
+typedef struct Resource {
+    ResourceCategory category;
+    ResourceOwner owner;
+    uintptr_t id;
+    long n_bytes;
+    int generation;
+    char name[MAX_RESOURCE_NAME_LENGTH];
+} Resource;
+
+static int N_RESOURCES;
+static Resource RESOURCES[MAX_N_RESOURCES];
+static ResourceOwner OWNER;
+static ResourceStats STATS;
+
+// Incremented on every scene load, so the resources of the previous scene
+// can be told from the new ones
+static int GENERATION;
+static long SCENE_START_N_BYTES[N_RESOURCE_CATEGORIES];
+
+static void track(
+    ResourceCategory category, uintptr_t id, long n_bytes, const char *name
+);
+static void untrack(ResourceCategory category, uintptr_t id);
+static long get_texture_size(int width, int height, int n_mipmaps, int format);
+static uintptr_t get_mesh_id(Mesh mesh);
+
+ResourceOwner set_resource_owner(ResourceOwner owner) {
+    ResourceOwner prev = OWNER;
+    OWNER = owner;
+    return prev;
+}
+
+ResourceOwner get_resource_owner(void) {
+    return OWNER;
+}
+
+Texture2D track_texture(Texture2D texture, const char *name) {
+    long n_bytes = get_texture_size(
+        texture.width, texture.height, texture.mipmaps, texture.format
+    );
+    track(RESOURCE_TEXTURE, texture.id, n_bytes, name);
+    return texture;
+}
+
+Sound track_sound(Sound sound, const char *name) {
+    long n_bytes = (long)sound.frameCount * sound.stream.channels
+                   * (sound.stream.sampleSize / 8);
+    track(RESOURCE_SOUND, (uintptr_t)sound.stream.buffer, n_bytes, name);
+    return sound;
+}
+
+Mesh track_mesh(Mesh mesh, const char *name) {
+    long vertex_size = 0;
+    if (mesh.vertices) vertex_size += 3 * sizeof(float);
+    if (mesh.texcoords) vertex_size += 2 * sizeof(float);
+    if (mesh.normals) vertex_size += 3 * sizeof(float);
+    if (mesh.tangents) vertex_size += 4 * sizeof(float);
+    if (mesh.colors) vertex_size += 4;
+
+    long n_bytes = (long)mesh.vertexCount * vertex_size;
+    if (mesh.indices) n_bytes += (long)mesh.triangleCount * 3 * sizeof(unsigned short);
+    track(RESOURCE_MESH, get_mesh_id(mesh), n_bytes, name);
+    return mesh;
+}
+
+Shader track_shader(Shader shader, const char *name) {
+    track(RESOURCE_SHADER, shader.id, 0, name);
+    return shader;
+}
+
+RenderTexture2D track_render_texture(RenderTexture2D target, const char *name) {
+    Texture2D t = target.texture;
+    long n_bytes = get_texture_size(t.width, t.height, t.mipmaps, t.format);
+    if (target.depth.id) n_bytes += (long)t.width * t.height * 4;
+    track(RESOURCE_RENDER_TEXTURE, target.id, n_bytes, name);
+    return target;
+}
+
+void unload_texture(Texture2D texture) {
+    if (texture.id == 0) return;
+    untrack(RESOURCE_TEXTURE, texture.id);
+    UnloadTexture(texture);
+}
+
+void unload_sound(Sound sound) {
+    if (sound.stream.buffer == NULL) return;
+    untrack(RESOURCE_SOUND, (uintptr_t)sound.stream.buffer);
+    stop_sound_voices(sound);
+    UnloadSound(sound);
+}
+
+void unload_mesh(Mesh mesh) {
+    if (mesh.vertexCount == 0) return;
+    untrack(RESOURCE_MESH, get_mesh_id(mesh));
+    UnloadMesh(mesh);
+}
+
+void unload_shader(Shader shader) {
+    if (shader.id == 0) return;
+    untrack(RESOURCE_SHADER, shader.id);
+    UnloadShader(shader);
+}
+
+void unload_render_texture(RenderTexture2D target) {
+    if (target.id == 0) return;
+    untrack(RESOURCE_RENDER_TEXTURE, target.id);
+    UnloadRenderTexture(target);
+}
+
+void begin_scene_resources(void) {
+    GENERATION += 1;
+    memcpy(SCENE_START_N_BYTES, STATS.n_bytes, sizeof(SCENE_START_N_BYTES));
+}
+
+void end_scene_resources(const char *scene_name) {
+    STATS.n_leaked = 0;
+    STATS.n_leaked_bytes = 0;
+    for (int i = 0; i < N_RESOURCES; ++i) {
+        Resource *r = &RESOURCES[i];
+        if (r->owner < OWNER_ITEMS || r->generation == GENERATION) continue;
+
+        STATS.n_leaked += 1;
+        STATS.n_leaked_bytes += r->n_bytes;
+        TraceLog(
+            LOG_WARNING,
+            "RESOURCES: %s %s (%s, %ld bytes) survived the scene load",
+            RESOURCE_CATEGORY_TO_NAME(r->category),
+            r->name,
+            RESOURCE_OWNER_TO_NAME(r->owner),
+            r->n_bytes
+        );
+    }
+
+    TraceLog(LOG_INFO, "RESOURCES: Loaded %s", scene_name);
+    for (int i = 0; i < N_RESOURCE_CATEGORIES; ++i) {
+        TraceLog(
+            LOG_INFO,
+            "    > %-16s %5d, %10ld bytes (%+ld)",
+            RESOURCE_CATEGORY_TO_NAME(i),
+            STATS.n_resources[i],
+            STATS.n_bytes[i],
+            STATS.n_bytes[i] - SCENE_START_N_BYTES[i]
+        );
+    }
+}
+
+ResourceStats get_resource_stats(void) {
+    return STATS;
+}
+
+static void track(
+    ResourceCategory category, uintptr_t id, long n_bytes, const char *name
+) {
+    if (id == 0) return;
+    if (N_RESOURCES == MAX_N_RESOURCES) {
+        TraceLog(LOG_WARNING, "RESOURCES: Too many resources, %s is not tracked", name);
+        return;
+    }
+
+    Resource *r = &RESOURCES[N_RESOURCES++];
+    r->category = category;
+    r->owner = OWNER;
+    r->id = id;
+    r->n_bytes = n_bytes;
+    r->generation = GENERATION;
+    strncpy(r->name, name ? name : "", MAX_RESOURCE_NAME_LENGTH - 1);
+    r->name[MAX_RESOURCE_NAME_LENGTH - 1] = '\0';
+
+    STATS.n_resources[category] += 1;
+    STATS.n_bytes[category] += n_bytes;
+    STATS.n_bytes_by_owner[OWNER] += n_bytes;
+    STATS.n_total_bytes += n_bytes;
+}
+
+static void untrack(ResourceCategory category, uintptr_t id) {
+    // Recently created resources are the most likely to be released first
+    for (int i = N_RESOURCES - 1; i >= 0; --i) {
+        Resource *r = &RESOURCES[i];
+        if (r->category != category || r->id != id) continue;
+
+        STATS.n_resources[category] -= 1;
+        STATS.n_bytes[category] -= r->n_bytes;
+        STATS.n_bytes_by_owner[r->owner] -= r->n_bytes;
+        STATS.n_total_bytes -= r->n_bytes;
+        RESOURCES[i] = RESOURCES[--N_RESOURCES];
+        return;
+    }
+}
+
+static long get_texture_size(int width, int height, int n_mipmaps, int format) {
+    long n_bytes = 0;
+    for (int i = 0; i < n_mipmaps; ++i) {
+        n_bytes += GetPixelDataSize(width, height, format);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return n_bytes;
+}
+
+static uintptr_t get_mesh_id(Mesh mesh) {
+    if (mesh.vaoId) return mesh.vaoId;
+    return mesh.vboId ? mesh.vboId[0] : 0;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "raylib.h"
+#include <stdbool.h>
+
+// Resource accounting. Every GPU and audio resource is tracked from creation
+// to destruction together with its estimated size and the owner it was
+// created for. Scene scoped owners must release everything of the previous
+// scene on load_scene, whatever survives is reported as a leak
+#define MAX_N_RESOURCES 16384
+#define MAX_RESOURCE_NAME_LENGTH 128
+
+typedef enum ResourceCategory {
+    RESOURCE_TEXTURE = 0,
+    RESOURCE_SOUND,
+    RESOURCE_MESH,
+    RESOURCE_SHADER,
+    RESOURCE_RENDER_TEXTURE,
+    N_RESOURCE_CATEGORIES,
+} ResourceCategory;
+
+#define RESOURCE_CATEGORY_TO_NAME(category) \
+    ((category == RESOURCE_TEXTURE)          ? "texture" \
+     : (category == RESOURCE_SOUND)          ? "sound" \
+     : (category == RESOURCE_MESH)           ? "mesh" \
+     : (category == RESOURCE_SHADER)         ? "shader" \
+     : (category == RESOURCE_RENDER_TEXTURE) ? "render_texture" \
+                                             : "unknown")
+
+typedef enum ResourceOwner {
+    OWNER_CORE = 0,
+    OWNER_GOLOVA,
+    OWNER_BOARD,
+    OWNER_UI,
+    OWNER_EDITOR,
+
+    // Scene scoped owners
+    OWNER_ITEMS,
+    OWNER_FOREST,
+    N_RESOURCE_OWNERS,
+} ResourceOwner;
+
+#define RESOURCE_OWNER_TO_NAME(owner) \
+    ((owner == OWNER_CORE)     ? "core" \
+     : (owner == OWNER_GOLOVA) ? "golova" \
+     : (owner == OWNER_BOARD)  ? "board" \
+     : (owner == OWNER_UI)     ? "ui" \
+     : (owner == OWNER_EDITOR) ? "editor" \
+     : (owner == OWNER_ITEMS)  ? "items" \
+     : (owner == OWNER_FOREST) ? "forest" \
+                               : "unknown")
+
+typedef struct ResourceStats {
+    int n_resources[N_RESOURCE_CATEGORIES];
+    long n_bytes[N_RESOURCE_CATEGORIES];
+    long n_bytes_by_owner[N_RESOURCE_OWNERS];
+    long n_total_bytes;
+
+    // Scene scoped resources which survived the last scene load
+    int n_leaked;
+    long n_leaked_bytes;
+} ResourceStats;
+
+// New resources are attributed to the current owner. Returns the previous
+// owner, so the caller can restore it
+ResourceOwner set_resource_owner(ResourceOwner owner);
+ResourceOwner get_resource_owner(void);
+
+Texture2D track_texture(Texture2D texture, const char *name);
+Sound track_sound(Sound sound, const char *name);
+Mesh track_mesh(Mesh mesh, const char *name);
+Shader track_shader(Shader shader, const char *name);
+RenderTexture2D track_render_texture(RenderTexture2D target, const char *name);
+
+// Untrack and unload. Resources which were never loaded are ignored
+void unload_texture(Texture2D texture);
+void unload_sound(Sound sound);
+void unload_mesh(Mesh mesh);
+void unload_shader(Shader shader);
+void unload_render_texture(RenderTexture2D target);
+
+// Bracket a scene load. The end logs the size difference per category and
+// every scene scoped resource created before the begin which is still alive
+void begin_scene_resources(void);
+void end_scene_resources(const char *scene_name);
+
+ResourceStats get_resource_stats(void);
@@ -1,104 +1,367 @@
 #include "scene.h"
 
+#include "audio.h"
 #include "drawing.h"
+#include "jobs.h"
 #include "math.h"
+#include "postfx.h"
+#include "profiler.h"
 #include "raylib.h"
 #include "raymath.h"
+#include "render_queue.h"
+#include "render_stats.h"
+#include "resources.h"
 #include "rlgl.h"
+#include "texture.h"
+#include "texture_stream.h"
+#include "trace.h"
 #include "utils.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define SHADOWMAP_WIDTH 1024
-#define SHADOWMAP_HEIGHT 768
+#define MAX_N_CORE_SHADERS 16
+#define MAX_N_CORE_SPRITES 16
+#define MAX_N_SHADER_VARIANTS 8
+
+// Shader sources declare the features they use with a
+// "#pragma features NAME ..." line. Each used combination of the declared
+// features is compiled once, with the names defined, instead of branching on
+// flag uniforms per fragment
+typedef enum ShaderFeature {
+    SHADER_WITH_SHADOWS = 0,
+    SHADER_WITH_BORDER,
+    N_SHADER_FEATURES,
+} ShaderFeature;
+
+#define SHADER_FEATURE_TO_NAME(feature) \
+    ((feature == SHADER_WITH_SHADOWS)  ? "WITH_SHADOWS" \
+     : (feature == SHADER_WITH_BORDER) ? "WITH_BORDER" \
+                                       : "UNKNOWN")
+
+// Render queue layers, drawn in this order. The board is translucent, so the
+// trees behind it are drawn first, and the items on it are drawn over it
+typedef enum SceneLayer {
+    SCENE_LAYER_GOLOVA = 0,
+    SCENE_LAYER_FOREST,
+    SCENE_LAYER_BOARD,
+    SCENE_LAYER_ITEMS,
+} SceneLayer;
+
+// Golova parts are stacked on one plane and drawn in this order
+typedef enum GolovaOrder {
+    GOLOVA_ORDER_BODY = 0,
+    GOLOVA_ORDER_CRACKS,
+    GOLOVA_ORDER_EYES,
+    GOLOVA_ORDER_EYES_BACKGROUND,
+} GolovaOrder;
+
+// Borders of the hot items are translucent, so the bordered items are blended
+// back to front after the plain ones
+typedef enum ItemOrder {
+    ITEM_ORDER_PLAIN = 0,
+    ITEM_ORDER_BORDERED,
+} ItemOrder;
 
 Scene SCENE;
 
-RenderTexture2D SHADOWMAP;
 Material MATERIAL_DEFAULT;
 Material MATERIAL_SKY;
 Mesh PLANE_MESH;
-Shader POSTFX_SHADER;
+
+// Item and tree files are decoded in parallel, each one is uploaded by a main
+// thread job as soon as it's decoded
+typedef struct ItemAssets {
+    Texture2D *texture;
+    Sound *sound;
+    char sprite_path[MAX_PATH_LENGTH];
+    char sound_path[MAX_PATH_LENGTH];
+    SpriteData sprite;
+    SoundData sound_data;
+} ItemAssets;
+
+static int N_ITEM_ASSETS;
+static ItemAssets ITEM_ASSETS[2 * MAX_N_BOARD_ITEMS];
+static SpriteData TREE_SPRITES[MAX_N_FOREST_TREES];
+static Forest *TREES_FOREST;
+static JobCounter UPLOADS_COUNTER;
+
+// Shaders and sprites of init_core, with the places they are loaded to, so
+// they can be reloaded in place
+typedef struct ShaderVariant {
+    int features;
+    Shader shader;
+} ShaderVariant;
+
+// The shader is the variant without features. The other variants are
+// compiled on their first use
+typedef struct ShaderSlot {
+    Shader *shader;
+    ResourceOwner owner;
+    char vs_file_name[MAX_NAME_LENGTH];
+    char fs_file_name[MAX_NAME_LENGTH];
+
+    // Bits of the features declared by the sources
+    int feature_mask;
+    int n_variants;
+    ShaderVariant variants[MAX_N_SHADER_VARIANTS];
+} ShaderSlot;
+
+typedef struct SpriteSlot {
+    Texture2D *texture;
+    Mesh *mesh;
+    ResourceOwner owner;
+    char file_path[MAX_PATH_LENGTH];
+} SpriteSlot;
+
+static int N_SHADER_SLOTS;
+static ShaderSlot SHADER_SLOTS[MAX_N_CORE_SHADERS];
+static int N_SPRITE_SLOTS;
+static SpriteSlot SPRITE_SLOTS[MAX_N_CORE_SPRITES];
+
+// What the shadow mask is drawn from. The shaders are included as they are
+// hot reloaded. Item matrices are without the bob
+typedef struct ShadowCasters {
+    ShadowQuality quality;
+    unsigned int caster_shader_id;
+    unsigned int blur_shader_id;
+    Camera3D light_camera;
+    Matrix board_matrix;
+    int n_items;
+    Matrix item_matrices[MAX_N_BOARD_ITEMS];
+    ItemState item_states[MAX_N_BOARD_ITEMS];
+    Texture2D item_textures[MAX_N_BOARD_ITEMS];
+} ShadowCasters;
+
+// The mask is blurred into SHADOW_MASK_BLUR and back
+static RenderTexture2D SHADOW_MASK;
+static RenderTexture2D SHADOW_MASK_BLUR;
+static Shader SHADOW_CASTER_SHADER;
+static Shader SHADOW_BLUR_SHADER;
+static Matrix SHADOW_LIGHT_VP;
+static ShadowCasters SHADOW_CASTERS;
+
+// Core files are read and decoded by jobs, possibly while the window is being
+// created, init_core then only compiles and uploads them
+typedef enum CoreSprite {
+    CORE_SPRITE_GOLOVA_IDLE = 0,
+    CORE_SPRITE_GOLOVA_EAT,
+    CORE_SPRITE_GOLOVA_CRACKS,
+    CORE_SPRITE_EYE_LEFT,
+    CORE_SPRITE_EYE_RIGHT,
+    N_CORE_SPRITES,
+} CoreSprite;
+
+static const char *CORE_SPRITE_FILE_PATHS[N_CORE_SPRITES] = {
+    "resources/golova/sprites/golova_idle.png",
+    "resources/golova/sprites/golova_eat.png",
+    "resources/golova/sprites/golova_cracks.png",
+    "resources/golova/sprites/eye_left.png",
+    "resources/golova/sprites/eye_right.png",
+};
+
+static const char *CORE_SHADER_FILE_NAMES[] = {
+    "base.vert",
+    "board.vert",
+    "board.frag",
+    "item.frag",
+    "shadow.frag",
+    "shadow_blur.frag",
+    "sky.frag",
+    "sprite.frag",
+};
+#define N_CORE_SHADER_FILES \
+    (int)(sizeof(CORE_SHADER_FILE_NAMES) / sizeof(CORE_SHADER_FILE_NAMES[0]))
+
+typedef struct CoreAssets {
+    bool is_requested;
+    JobCounter counter;
+    char *shader_srcs[N_CORE_SHADER_FILES];
+    SpriteData sprites[N_CORE_SPRITES];
+} CoreAssets;
+
+static CoreAssets CORE_ASSETS;
+
+static SceneNode SCENE_NODES[N_SCENE_NODES];
+static int DIRTY_SCENE_NODES[N_SCENE_NODES];
+static int N_DIRTY_SCENE_NODES;
+
+// Number of items the grid slots are currently laid out for
+static int ITEMS_LAYOUT_N_ITEMS = -1;
+
+static void init_scene_nodes(void);
+static void update_scene_node(int node);
+static void update_items_layout(void);
+static void add_item_assets(const char *name, Texture2D *texture, Sound *sound);
+static void push_mesh_packet(
+    RenderPass pass,
+    SceneLayer layer,
+    int order,
+    bool is_translucent,
+    Camera3D camera,
+    Matrix matrix,
+    Material material,
+    const Mesh *mesh
+);
+static void read_item_assets(int begin, int end, void *data);
+static void upload_item_assets(void *data);
+static void read_tree_sprites(int begin, int end, void *data);
+static void upload_tree_sprite(void *data);
+static void compose_trees_world_matrices(int begin, int end, void *data);
+static RenderTexture2D load_shadow_mask(int size);
+static void update_shadow_mask(const SceneSnapshot *snapshot, ShadowQuality quality);
+static Matrix fit_light_frustum(const ShadowCasters *casters);
+static void draw_shadow_blur_pass(
+    Texture2D texture, RenderTexture2D target, Vector2 direction
+);
 
 static void fwrite_transform(Transform *transform, FILE *f);
 static void fread_transform(Transform *transform, FILE *f);
 static void fwrite_matrix(Matrix *matrix, FILE *f);
 static void fread_matrix(Matrix *matrix, FILE *f);
 
+static void read_core_shader_src(void *data);
+static void read_core_sprite(void *data);
+static char *get_shader_src(const char *file_name);
 static char *load_shader_src(const char *file_name);
-static Shader load_shader(const char *vs_file_name, const char *fs_file_name);
+static char *compose_shader_src(const char *text);
+static int get_shader_src_features(const char *src);
+static char *define_shader_features(const char *src, int features);
+static Shader compile_shader(
+    const char *vs_file_name, const char *fs_file_name, int features, int *feature_mask
+);
+static void load_shader(
+    Shader *shader, const char *vs_file_name, const char *fs_file_name
+);
+static Shader get_shader_variant(const Shader *shader, int features);
+static void load_core_sprite(
+    CoreSprite sprite, Texture2D *texture, Mesh *mesh, float *aspect
+);
+static int reload_shaders(const char *file_name);
+static int reload_sprites(const char *file_path);
+static int reload_sounds(const char *file_path);
+static bool reload_sprite(
+    const char *file_path, ResourceOwner owner, Texture2D *texture, Mesh *mesh
+);
+
+void request_core_assets(void) {
+    if (CORE_ASSETS.is_requested) return;
+    CORE_ASSETS.is_requested = true;
+
+    for (int i = 0; i < N_CORE_SHADER_FILES; ++i) {
+        run_job(read_core_shader_src, (void *)(long)i, &CORE_ASSETS.counter);
+    }
+    for (int i = 0; i < N_CORE_SPRITES; ++i) {
+        run_job(read_core_sprite, (void *)(long)i, &CORE_ASSETS.counter);
+    }
+}
 
 void init_core(int screen_width, int screen_height) {
+    request_core_assets();
+    double time = get_trace_time();
+    wait_job_counter(&CORE_ASSETS.counter);
+    add_trace_event("wait_core_assets", time);
+
+    time = get_trace_time();
+    init_texture_streams();
+    ResourceOwner owner = set_resource_owner(OWNER_CORE);
     MATERIAL_DEFAULT = LoadMaterialDefault();
-    PLANE_MESH = GenMeshPlane(1.0, 1.0, 2, 2);
-    SHADOWMAP = LoadRenderTexture(SHADOWMAP_WIDTH, SHADOWMAP_HEIGHT);
-    SetTextureWrap(SHADOWMAP.texture, TEXTURE_WRAP_CLAMP);
-    POSTFX_SHADER = load_shader(0, "postfx.frag");
+    PLANE_MESH = track_mesh(GenMeshPlane(1.0, 1.0, 2, 2), "plane");
+    load_shader(&SHADOW_CASTER_SHADER, 0, "shadow.frag");
+    load_shader(&SHADOW_BLUR_SHADER, 0, "shadow_blur.frag");
 
     MATERIAL_SKY = LoadMaterialDefault();
-    MATERIAL_SKY.shader = load_shader(0, "sky.frag");
+    load_shader(&MATERIAL_SKY.shader, 0, "sky.frag");
 
     // -------------------------------------------------------------------
     // Load resources
-    // Golova idle
-    Texture2D texture = LoadTexture("resources/golova/sprites/golova_idle.png");
-    SCENE.golova.idle.material = LoadMaterialDefault();
-    SCENE.golova.idle.material.shader = load_shader(0, "sprite.frag");
-    SCENE.golova.idle.material.maps[0].texture = texture;
-    SCENE.golova.idle.mesh = GenMeshPlane(
-        (float)texture.width / texture.height, 1.0, 2, 2
+    // Golova idle. Golova sprites are trimmed, so the eyes background gets its
+    // own quad of the whole Golova image
+    set_resource_owner(OWNER_GOLOVA);
+    float aspect;
+    Golova *g = &SCENE.golova;
+    g->idle.material = LoadMaterialDefault();
+    load_shader(&g->idle.material.shader, 0, "sprite.frag");
+    load_core_sprite(
+        CORE_SPRITE_GOLOVA_IDLE,
+        &g->idle.material.maps[0].texture,
+        &g->idle.mesh,
+        &aspect
+    );
+    g->eyes_background_mesh = track_mesh(
+        GenMeshPlane(aspect, 1.0, 2, 2), "eyes_background"
     );
 
     // Golova eat
-    texture = LoadTexture("resources/golova/sprites/golova_eat.png");
-    SCENE.golova.eat.material = LoadMaterialDefault();
-    SCENE.golova.eat.material.shader = load_shader(0, "sprite.frag");
-    SCENE.golova.eat.material.maps[0].texture = texture;
-    SCENE.golova.eat.mesh = GenMeshPlane(
-        (float)texture.width / texture.height, 1.0, 2, 2
+    g->eat.material = LoadMaterialDefault();
+    load_shader(&g->eat.material.shader, 0, "sprite.frag");
+    load_core_sprite(
+        CORE_SPRITE_GOLOVA_EAT,
+        &g->eat.material.maps[0].texture,
+        &g->eat.mesh,
+        NULL
     );
 
     // Golova cracks
-    texture = LoadTexture("resources/golova/sprites/golova_cracks.png");
-    SCENE.golova.cracks.material = LoadMaterialDefault();
-    SCENE.golova.cracks.material.shader = load_shader(0, "sprite.frag");
-    SCENE.golova.cracks.material.maps[0].texture = texture;
-    SCENE.golova.cracks.mesh = GenMeshPlane(
-        (float)texture.width / texture.height, 1.0, 2, 2
+    g->cracks.material = LoadMaterialDefault();
+    load_shader(&g->cracks.material.shader, 0, "sprite.frag");
+    load_core_sprite(
+        CORE_SPRITE_GOLOVA_CRACKS,
+        &g->cracks.material.maps[0].texture,
+        &g->cracks.mesh,
+        NULL
     );
 
     // Golova eyes
-    SCENE.golova.eyes_material = LoadMaterialDefault();
-    SCENE.golova.eyes_material.shader = load_shader(0, "sprite.frag");
-
-    texture = LoadTexture("resources/golova/sprites/eye_left.png");
-    SCENE.golova.eye_left.texture = texture;
-    SCENE.golova.eye_left.mesh = GenMeshPlane(
-        (float)texture.width / texture.height, 1.0, 2, 2
+    g->eyes_material = LoadMaterialDefault();
+    load_shader(&g->eyes_material.shader, 0, "sprite.frag");
+
+    load_core_sprite(
+        CORE_SPRITE_EYE_LEFT,
+        &g->eye_left.texture,
+        &g->eye_left.mesh,
+        NULL
     );
-
-    texture = LoadTexture("resources/golova/sprites/eye_right.png");
-    SCENE.golova.eye_right.texture = texture;
-    SCENE.golova.eye_right.mesh = GenMeshPlane(
-        (float)texture.width / texture.height, 1.0, 2, 2
+    load_core_sprite(
+        CORE_SPRITE_EYE_RIGHT,
+        &g->eye_right.texture,
+        &g->eye_right.mesh,
+        NULL
     );
 
     // Board
+    set_resource_owner(OWNER_BOARD);
     SCENE.board.material = LoadMaterialDefault();
-    SCENE.board.material.shader = load_shader("board.vert", "board.frag");
-    SCENE.board.mesh = GenMeshPlane(1.0, 1.0, 2, 2);
+    load_shader(&SCENE.board.material.shader, "board.vert", "board.frag");
+    SCENE.board.mesh = track_mesh(GenMeshPlane(1.0, 1.0, 2, 2), "board");
     SCENE.board.item_material = LoadMaterialDefault();
-    SCENE.board.item_material.shader = load_shader(0, "item.frag");
-    SCENE.board.item_mesh = GenMeshPlane(1.0, 1.0, 2, 2);
+    load_shader(&SCENE.board.item_material.shader, 0, "item.frag");
+    SCENE.board.item_mesh = track_mesh(GenMeshPlane(1.0, 1.0, 2, 2), "item");
 
-    // Forest
+    // Forest. The material outlives the scenes, only the trees are scene scoped
+    set_resource_owner(OWNER_CORE);
     SCENE.forest.trees_material = LoadMaterialDefault();
-    SCENE.forest.trees_material.shader = load_shader(0, "sprite.frag");
+    load_shader(&SCENE.forest.trees_material.shader, 0, "sprite.frag");
+    set_resource_owner(owner);
+
+    // Variants used by the default options are compiled from the prepared
+    // sources, the rest on their first use
+    get_shader_variant(&SCENE.board.material.shader, 1 << SHADER_WITH_SHADOWS);
+    get_shader_variant(&SCENE.board.item_material.shader, 1 << SHADER_WITH_BORDER);
+
+    // Shader reloads read the files again
+    for (int i = 0; i < N_CORE_SHADER_FILES; ++i) {
+        free(CORE_ASSETS.shader_srcs[i]);
+        CORE_ASSETS.shader_srcs[i] = NULL;
+    }
+
+    init_scene_nodes();
+    add_trace_event("upload_core_assets", time);
 }
 
 void load_scene(const char *file_path) {
+    PROFILE_BEGIN(load_scene);
     static char fp[2048];
 
     // Golova
@@ -114,6 +377,8 @@ void load_scene(const char *file_path) {
     SCENE.board.item_elevation = 0.5;
     SCENE.board.board_scale = 0.7;
     SCENE.board.item_scale = 0.2;
+    SCENE.board.items_drop_height = 0.0;
+    SCENE.board.items_bob_height = 0.0;
     SCENE.board.n_hint_items = 0;
 
     // Camera
@@ -129,6 +394,18 @@ void load_scene(const char *file_path) {
     SCENE.light_camera.position = (Vector3){0.0, 1.0, -1.0};
     SCENE.light_camera.target = Vector3Zero();
 
+    // -------------------------------------------------------------------
+    // Release all items of the previous scene, including the slots which the
+    // new scene doesn't use
+    begin_scene_resources();
+    Board *b = &SCENE.board;
+    for (int i = 0; i < MAX_N_BOARD_ITEMS; ++i) {
+        unload_board_item(b, i);
+        cancel_texture_stream(&b->hint_items[i].texture);
+        unload_texture(b->hint_items[i].texture);
+        b->hint_items[i].texture = (Texture2D){0};
+    }
+
     // -------------------------------------------------------------------
     // Update entities from the scene save file
     if (file_path) {
@@ -158,49 +435,99 @@ void load_scene(const char *file_path) {
         fread(&SCENE.board.n_items, sizeof(int), 1, f);
         fread(&SCENE.board.n_hint_items, sizeof(int), 1, f);
 
-        // Forest
+        // Forest. The one next to the scene file is taken first, so generated
+        // scenes keep their forests out of the resources
         fread(&SCENE.forest.name, sizeof(SCENE.forest.name), 1, f);
         if (SCENE.forest.name[0] != '\0') {
-            sprintf(fp, "resources/forests/%s.fst", SCENE.forest.name);
+            sprintf(fp, "%s/%s.fst", GetDirectoryPath(file_path), SCENE.forest.name);
+            if (!FileExists(fp)) {
+                sprintf(fp, "resources/forests/%s.fst", SCENE.forest.name);
+            }
             load_forest(&SCENE.forest, fp);
+        } else {
+            unload_forest_trees(&SCENE.forest);
         }
 
         // Items
-        for (int i = 0; i < SCENE.board.n_items; ++i) {
-            Item *item = &SCENE.board.items[i];
-            fread_matrix(&item->matrix, f);
+        N_ITEM_ASSETS = 0;
+        for (int i = 0; i < b->n_items; ++i) {
+            Item *item = &b->items[i];
+            fread_matrix(&b->item_matrices[i], f);
             fread(&item->is_correct, sizeof(bool), 1, f);
             fread(&item->name, sizeof(item->name), 1, f);
-            item->state = ITEM_COLD;
-
-            if (item->name[0] != '\0') {
-                sprintf(fp, "resources/items/sprites/%s.png", item->name);
-                if (IsTextureReady(item->texture)) UnloadTexture(item->texture);
-                item->texture = LoadTexture(fp);
-
-                sprintf(fp, "resources/items/audio/%s.mp3", item->name);
-                if (IsSoundReady(item->sound)) UnloadSound(item->sound);
-                item->sound = LoadSound(fp);
-            }
+            b->item_states[i] = ITEM_COLD;
+            add_item_assets(item->name, &b->item_textures[i], &item->sound);
         }
 
         // Hint items
-        for (int i = 0; i < SCENE.board.n_hint_items; ++i) {
-            Item *item = &SCENE.board.hint_items[i];
+        for (int i = 0; i < b->n_hint_items; ++i) {
+            HintItem *item = &b->hint_items[i];
             fread(&item->name, sizeof(item->name), 1, f);
-
-            if (item->name[0] != '\0') {
-                sprintf(fp, "resources/items/sprites/%s.png", item->name);
-                if (IsTextureReady(item->texture)) UnloadTexture(item->texture);
-                item->texture = LoadTexture(fp);
-            }
+            add_item_assets(item->name, &item->texture, NULL);
         }
 
         fclose(f);
+
+        ResourceOwner owner = set_resource_owner(OWNER_ITEMS);
+        parallel_for(N_ITEM_ASSETS, 1, read_item_assets, NULL);
+        wait_job_counter(&UPLOADS_COUNTER);
+        set_resource_owner(owner);
     }
 
+    end_scene_resources(file_path ? file_path : "default scene");
+
     SCENE.golova.eyes_curr_shift = SCENE.golova.eyes_idle_shift;
     SCENE.golova.eyes_curr_uplift = SCENE.golova.eyes_idle_uplift;
+    PROFILE_END(load_scene);
+}
+
+int get_scene_asset_paths(
+    const char *file_path, char paths[][MAX_PATH_LENGTH], int max_n_paths
+) {
+    FILE *f = fopen(file_path, "rb");
+    if (!f) return 0;
+
+    // Skip everything up to the items, the layout is the same as in load_scene
+    Camera3D camera;
+    Transform transform;
+    Matrix matrix;
+    float value;
+    int n_items;
+    int n_hint_items;
+    bool is_correct;
+    char rule[MAX_RULE_LENGTH];
+    char name[MAX_NAME_LENGTH];
+
+    fread(&camera, sizeof(Camera3D), 1, f);
+    fread(&camera, sizeof(Camera3D), 1, f);
+    fread_transform(&transform, f);
+    for (int i = 0; i < 4; ++i) fread(&value, sizeof(float), 1, f);
+    fread_transform(&transform, f);
+    fread(&rule, sizeof(rule), 1, f);
+    fread(&n_items, sizeof(int), 1, f);
+    fread(&n_items, sizeof(int), 1, f);
+    for (int i = 0; i < 3; ++i) fread(&value, sizeof(float), 1, f);
+    fread(&n_items, sizeof(int), 1, f);
+    fread(&n_hint_items, sizeof(int), 1, f);
+    fread(&name, sizeof(name), 1, f);
+
+    int n_paths = 0;
+    for (int i = 0; i < n_items + n_hint_items; ++i) {
+        if (i < n_items) {
+            fread_matrix(&matrix, f);
+            fread(&is_correct, sizeof(bool), 1, f);
+        }
+        if (fread(&name, sizeof(name), 1, f) != 1) break;
+        if (name[0] == '\0' || n_paths + 2 > max_n_paths) continue;
+
+        sprintf(paths[n_paths++], "resources/items/sprites/%s.png", name);
+        if (i < n_items) {
+            sprintf(paths[n_paths++], "resources/items/audio/%s.mp3", name);
+        }
+    }
+
+    fclose(f);
+    return n_paths;
 }
 
 void save_scene(const char *file_path) {
@@ -234,16 +561,17 @@ void save_scene(const char *file_path) {
     fwrite(&SCENE.forest.name, sizeof(SCENE.forest.name), 1, f);
 
     // Items
-    for (int i = 0; i < SCENE.board.n_items; ++i) {
-        Item *item = &SCENE.board.items[i];
-        fwrite_matrix(&item->matrix, f);
+    Board *b = &SCENE.board;
+    for (int i = 0; i < b->n_items; ++i) {
+        Item *item = &b->items[i];
+        fwrite_matrix(&b->item_matrices[i], f);
         fwrite(&item->is_correct, sizeof(bool), 1, f);
         fwrite(&item->name, sizeof(item->name), 1, f);
     }
 
     // Hint items
-    for (int i = 0; i < SCENE.board.n_hint_items; ++i) {
-        Item *item = &SCENE.board.hint_items[i];
+    for (int i = 0; i < b->n_hint_items; ++i) {
+        HintItem *item = &b->hint_items[i];
         fwrite(&item->name, sizeof(item->name), 1, f);
     }
 
@@ -253,31 +581,120 @@ void save_scene(const char *file_path) {
 }
 
 void load_forest(Forest *forest, const char *file_path) {
-    static char fp[2048];
+    PROFILE_BEGIN(load_forest);
 
-    for (int i = 0; i < forest->n_trees; ++i) {
-        Tree *tree = &forest->trees[i];
-        UnloadTexture(tree->texture);
-        UnloadMesh(tree->mesh);
-    }
+    unload_forest_trees(forest);
+    ResourceOwner owner = set_resource_owner(OWNER_FOREST);
 
     FILE *f = fopen(file_path, "rb");
     fread(&forest->name, sizeof(forest->name), 1, f);
     fread(&forest->n_trees, sizeof(forest->n_trees), 1, f);
     for (int i = 0; i < forest->n_trees; ++i) {
-        Tree *tree = &forest->trees[i];
-        fread(&tree->name, sizeof(tree->name), 1, f);
-        fread_transform(&tree->transform, f);
-
-        sprintf(fp, "resources/trees/sprites/%s.png", tree->name);
-        tree->texture = LoadTexture(fp);
-        tree->mesh = GenMeshPlane(
-            (float)tree->texture.width / tree->texture.height, 1.0, 2, 2
+        fread(&forest->tree_names[i], sizeof(forest->tree_names[i]), 1, f);
+        fread_transform(&forest->tree_transforms[i], f);
+        forest->tree_matrices[i] = MatrixIdentity();
+    }
+    fclose(f);
+
+    TREES_FOREST = forest;
+    parallel_for(forest->n_trees, 4, read_tree_sprites, forest);
+    wait_job_counter(&UPLOADS_COUNTER);
+
+    set_resource_owner(owner);
+    PROFILE_END(load_forest);
+}
+
+void unload_forest_trees(Forest *forest) {
+    while (forest->n_trees > 0) remove_forest_tree(forest, forest->n_trees - 1);
+}
+
+// The following trees are shifted down, so the tree order is kept
+void remove_forest_tree(Forest *forest, int idx) {
+    cancel_texture_stream(&forest->tree_textures[idx]);
+    unload_texture(forest->tree_textures[idx]);
+    unload_mesh(forest->tree_meshes[idx]);
+
+    forest->n_trees -= 1;
+    int n_move = forest->n_trees - idx;
+    for (int i = idx; i < forest->n_trees; ++i) {
+        move_texture_stream(&forest->tree_textures[i + 1], &forest->tree_textures[i]);
+    }
+    if (n_move > 0) {
+        memmove(
+            &forest->tree_transforms[idx],
+            &forest->tree_transforms[idx + 1],
+            n_move * sizeof(forest->tree_transforms[0])
+        );
+        memmove(
+            &forest->tree_matrices[idx],
+            &forest->tree_matrices[idx + 1],
+            n_move * sizeof(forest->tree_matrices[0])
+        );
+        memmove(
+            &forest->tree_textures[idx],
+            &forest->tree_textures[idx + 1],
+            n_move * sizeof(forest->tree_textures[0])
+        );
+        memmove(
+            &forest->tree_meshes[idx],
+            &forest->tree_meshes[idx + 1],
+            n_move * sizeof(forest->tree_meshes[0])
+        );
+        memmove(
+            &forest->tree_names[idx],
+            &forest->tree_names[idx + 1],
+            n_move * sizeof(forest->tree_names[0])
         );
-        tree->matrix = MatrixIdentity();
     }
 
-    fclose(f);
+    // The vacated slot still refers to the resources of the moved tree
+    int last = forest->n_trees;
+    forest->tree_transforms[last] = (Transform){0};
+    forest->tree_matrices[last] = (Matrix){0};
+    forest->tree_textures[last] = (Texture2D){0};
+    forest->tree_meshes[last] = (Mesh){0};
+    forest->tree_names[last][0] = '\0';
+}
+
+void unload_board_item(Board *board, int idx) {
+    cancel_texture_stream(&board->item_textures[idx]);
+    unload_texture(board->item_textures[idx]);
+    unload_sound(board->items[idx].sound);
+    board->item_textures[idx] = (Texture2D){0};
+    board->item_states[idx] = ITEM_COLD;
+    board->items[idx] = (Item){0};
+}
+
+bool reload_scene_file(const char *file_path) {
+    static char fp[2048];
+
+    // Cooked textures are reloaded through their source path
+    char path[MAX_PATH_LENGTH];
+    strncpy(path, file_path, MAX_PATH_LENGTH - 1);
+    path[MAX_PATH_LENGTH - 1] = '\0';
+    char *ext = strrchr(path, '.');
+    if (ext == NULL) return false;
+    if (strcmp(ext, TEXTURE_FILE_EXT) == 0) strcpy(ext, ".png");
+
+    const char *shaders_dir = "resources/shaders/";
+    int n_reloaded = 0;
+    if (strncmp(path, shaders_dir, strlen(shaders_dir)) == 0) {
+        const char *file_name = path + strlen(shaders_dir);
+        n_reloaded = reload_shaders(file_name) + reload_postfx_shaders(file_name);
+    } else if (strcmp(ext, ".png") == 0) {
+        n_reloaded = reload_sprites(path);
+    } else if (strcmp(ext, ".mp3") == 0 || strcmp(ext, ".wav") == 0) {
+        n_reloaded = reload_sounds(path);
+    } else if (strcmp(ext, ".fst") == 0 && SCENE.forest.name[0] != '\0') {
+        sprintf(fp, "resources/forests/%s.fst", SCENE.forest.name);
+        if (strcmp(fp, path) == 0) {
+            load_forest(&SCENE.forest, path);
+            n_reloaded = 1;
+        }
+    }
+
+    if (n_reloaded > 0) TraceLog(LOG_INFO, "Reloaded %s (%d uses)", path, n_reloaded);
+    return n_reloaded > 0;
 }
 
 void save_forest(Forest *forest, const char *file_path) {
@@ -285,206 +702,659 @@ void save_forest(Forest *forest, const char *file_path) {
     fwrite(&forest->name, sizeof(forest->name), 1, f);
     fwrite(&forest->n_trees, sizeof(forest->n_trees), 1, f);
     for (int i = 0; i < forest->n_trees; ++i) {
-        Tree *tree = &forest->trees[i];
-        fwrite(&tree->name, sizeof(tree->name), 1, f);
-        fwrite_transform(&tree->transform, f);
+        fwrite(&forest->tree_names[i], sizeof(forest->tree_names[i]), 1, f);
+        fwrite_transform(&forest->tree_transforms[i], f);
     }
 
     fclose(f);
 }
 
-static void draw_items(bool with_borders) {
-    Shader shader = SCENE.board.item_material.shader;
-    for (int i = 0; i < SCENE.board.n_items; ++i) {
-        Item *item = &SCENE.board.items[i];
-        if (item->state == ITEM_DEAD) continue;
+void set_scene_node_local(int node, Matrix local) {
+    SceneNode *scene_node = &SCENE_NODES[node];
+    if (memcmp(&scene_node->local, &local, sizeof(Matrix)) == 0) return;
 
-        SCENE.board.item_material.maps[0].texture = item->texture;
-        int u_state = item->state;
+    scene_node->local = local;
+    if (!scene_node->is_dirty) {
+        scene_node->is_dirty = true;
+        DIRTY_SCENE_NODES[N_DIRTY_SCENE_NODES++] = node;
+    }
+}
 
-        Vector4 color = {0.0};
+Matrix get_scene_node_world(int node) {
+    return SCENE_NODES[node].world;
+}
+
+void update_scene_nodes(void) {
+    for (int i = 0; i < N_DIRTY_SCENE_NODES; ++i) {
+        int node = DIRTY_SCENE_NODES[i];
+
+        // Already recomputed together with a dirty ancestor
+        if (!SCENE_NODES[node].is_dirty) continue;
 
-        if (with_borders) {
-            if (item->state == ITEM_HOT) color = (Vector4){1.0, 0.0, 1.0, 0.4};
-            else if (item->state == ITEM_ACTIVE) color = (Vector4){1.0, 0.0, 1.0, 1.0};
+        // Recompute the subtree of the topmost dirty ancestor only once
+        int top = node;
+        int parent = SCENE_NODES[node].parent;
+        while (parent != -1) {
+            if (SCENE_NODES[parent].is_dirty) top = parent;
+            parent = SCENE_NODES[parent].parent;
         }
+        update_scene_node(top);
+    }
 
-        SetShaderValueV(
-            shader,
-            GetShaderLocation(shader, "u_border_color"),
-            (void *)(&color),
-            SHADER_UNIFORM_VEC4,
-            1
+    N_DIRTY_SCENE_NODES = 0;
+}
+
+// Pulls Golova and board parameters into the hierarchy. Items local matrices
+// are game specific and must be set by the caller beforehand
+void update_scene_transforms(void) {
+    Golova *g = &SCENE.golova;
+    Board *b = &SCENE.board;
+
+    // Golova
+    Matrix golova = MatrixMultiply(get_transform_matrix(g->transform), g->matrix);
+    set_scene_node_local(NODE_GOLOVA, golova);
+
+    float eyes_scale = g->eyes_idle_scale;
+    float eyes_spread = g->eyes_idle_spread;
+    float eyes_shift = g->eyes_curr_shift;
+    float eyes_uplift = g->eyes_curr_uplift;
+
+    Matrix s = MatrixScale(eyes_scale, eyes_scale, eyes_scale);
+    Matrix left_t = MatrixTranslate(-eyes_spread / 2.0 + eyes_shift, -0.01, -eyes_uplift);
+    Matrix right_t = MatrixTranslate(eyes_spread / 2.0 + eyes_shift, -0.01, -eyes_uplift);
+    set_scene_node_local(NODE_EYE_LEFT, MatrixMultiply(s, left_t));
+    set_scene_node_local(NODE_EYE_RIGHT, MatrixMultiply(s, right_t));
+
+    s = MatrixScale(0.75, 1.0, 0.15);
+    Matrix t = MatrixTranslate(0.0, -0.02, -eyes_uplift);
+    set_scene_node_local(NODE_EYES_BACKGROUND, MatrixMultiply(s, t));
+
+    // Board
+    set_scene_node_local(NODE_BOARD, get_transform_matrix(b->transform));
+
+    // Items grid ignores the non-uniform board scale
+    Transform board_transform = b->transform;
+    board_transform.scale = Vector3Scale(Vector3One(), board_transform.scale.x);
+    Matrix items = MatrixMultiply(
+        MatrixTranslate(0.0, b->items_drop_height + b->items_bob_height, 0.0),
+        MatrixScale(b->board_scale, b->board_scale, b->board_scale)
+    );
+    items = MatrixMultiply(items, get_transform_matrix(board_transform));
+    set_scene_node_local(NODE_BOARD_ITEMS, items);
+
+    update_items_layout();
+    update_scene_nodes();
+}
+
+static void init_scene_nodes(void) {
+    for (int i = 0; i < N_SCENE_NODES; ++i) {
+        SceneNode *node = &SCENE_NODES[i];
+        node->parent = -1;
+        node->first_child = -1;
+        node->next_sibling = -1;
+        node->is_dirty = false;
+        node->local = MatrixIdentity();
+        node->world = MatrixIdentity();
+    }
+
+    // Parents always precede their children
+    int parents[N_SCENE_NODES];
+    for (int i = 0; i < N_SCENE_NODES; ++i) parents[i] = -1;
+    parents[NODE_GOLOVA_CRACKS] = NODE_GOLOVA;
+    parents[NODE_EYE_LEFT] = NODE_GOLOVA;
+    parents[NODE_EYE_RIGHT] = NODE_GOLOVA;
+    parents[NODE_EYES_BACKGROUND] = NODE_GOLOVA;
+    for (int i = 0; i < MAX_N_BOARD_ITEMS; ++i) {
+        parents[NODE_ITEM_SLOTS + i] = NODE_BOARD_ITEMS;
+        parents[NODE_ITEMS + i] = NODE_ITEM_SLOTS + i;
+    }
+
+    for (int i = 0; i < N_SCENE_NODES; ++i) {
+        int parent = parents[i];
+        if (parent == -1) continue;
+        SCENE_NODES[i].parent = parent;
+        SCENE_NODES[i].next_sibling = SCENE_NODES[parent].first_child;
+        SCENE_NODES[parent].first_child = i;
+    }
+
+    N_DIRTY_SCENE_NODES = 0;
+    ITEMS_LAYOUT_N_ITEMS = -1;
+    set_scene_node_local(NODE_GOLOVA_CRACKS, MatrixTranslate(0.0, 0.01, 0.0));
+}
+
+static void update_scene_node(int node) {
+    SceneNode *scene_node = &SCENE_NODES[node];
+    if (scene_node->parent == -1) {
+        scene_node->world = scene_node->local;
+    } else {
+        Matrix parent_world = SCENE_NODES[scene_node->parent].world;
+        scene_node->world = MatrixMultiply(scene_node->local, parent_world);
+    }
+    scene_node->is_dirty = false;
+
+    int child = scene_node->first_child;
+    while (child != -1) {
+        update_scene_node(child);
+        child = SCENE_NODES[child].next_sibling;
+    }
+}
+
+// Grid layout depends on the number of items only, so it's recomputed when
+// items are added or removed
+static void update_items_layout(void) {
+    int n_items = SCENE.board.n_items;
+    if (n_items == ITEMS_LAYOUT_N_ITEMS) return;
+    ITEMS_LAYOUT_N_ITEMS = n_items;
+
+    int n_rows = sqrt(n_items);
+    int n_cols = ceil((float)n_items / n_rows);
+    for (int i = 0; i < n_items; ++i) {
+        int i_row = i / n_cols;
+        int i_col = i % n_cols;
+
+        float z = n_rows > 1 ? (float)i_row / (n_rows - 1) - 0.5 : 0.0;
+        float x = n_cols > 1 ? (float)i_col / (n_cols - 1) - 0.5 : 0.0;
+        set_scene_node_local(NODE_ITEM_SLOTS + i, MatrixTranslate(x, 0.0, z));
+    }
+}
+
+// Items without a border are drawn with the variant which doesn't test for it
+static void push_items(const SceneSnapshot *snapshot, Camera3D camera) {
+    Material material = SCENE.board.item_material;
+    Shader border_shader = get_shader_variant(
+        &SCENE.board.item_material.shader, 1 << SHADER_WITH_BORDER
+    );
+    int border_color_loc = get_shader_location(border_shader, "u_border_color");
+    for (int i = 0; i < snapshot->n_items; ++i) {
+        ItemState state = snapshot->item_states[i];
+        if (state == ITEM_DEAD) continue;
+
+        Vector4 color = {0.0};
+        if (state == ITEM_HOT) color = (Vector4){1.0, 0.0, 1.0, 0.4};
+        else if (state == ITEM_ACTIVE) color = (Vector4){1.0, 0.0, 1.0, 1.0};
+
+        bool is_bordered = color.w > 0.0;
+        Shader shader = is_bordered ? border_shader : material.shader;
+        Matrix matrix = snapshot->item_matrices[i];
+        Vector3 position = {matrix.m12, matrix.m13, matrix.m14};
+        float depth = Vector3Distance(position, camera.position);
+        unsigned int texture_id = snapshot->item_textures[i].id;
+
+        RenderPacket packet = {0};
+        packet.key = get_render_key(
+            SCENE_LAYER_ITEMS,
+            is_bordered ? ITEM_ORDER_BORDERED : ITEM_ORDER_PLAIN,
+            is_bordered,
+            shader.id,
+            texture_id,
+            depth
         );
+        packet.pass = RENDER_PASS_ITEMS;
+        packet.matrix = matrix;
+        packet.mesh = &SCENE.board.item_mesh;
+        packet.shader = shader;
+        packet.texture_id = texture_id;
+        packet.color = material.maps[MATERIAL_MAP_DIFFUSE].color;
+        packet.param_loc = is_bordered ? border_color_loc : -1;
+        packet.param = color;
+        push_render_packet(packet);
+    }
+}
+
+// Packet of the material's diffuse map and color, depth is the distance from
+// the camera to the mesh origin
+static void push_mesh_packet(
+    RenderPass pass,
+    SceneLayer layer,
+    int order,
+    bool is_translucent,
+    Camera3D camera,
+    Matrix matrix,
+    Material material,
+    const Mesh *mesh
+) {
+    Vector3 position = {matrix.m12, matrix.m13, matrix.m14};
+    float depth = Vector3Distance(position, camera.position);
+    MaterialMap map = material.maps[MATERIAL_MAP_DIFFUSE];
+
+    RenderPacket packet = {0};
+    packet.key = get_render_key(
+        layer, order, is_translucent, material.shader.id, map.texture.id, depth
+    );
+    packet.pass = pass;
+    packet.matrix = matrix;
+    packet.mesh = mesh;
+    packet.shader = material.shader;
+    packet.texture_id = map.texture.id;
+    packet.color = map.color;
+    packet.param_loc = -1;
+    push_render_packet(packet);
+}
+
+// Hint items have no sound
+static void add_item_assets(const char *name, Texture2D *texture, Sound *sound) {
+    if (name[0] == '\0') return;
+
+    ItemAssets *assets = &ITEM_ASSETS[N_ITEM_ASSETS++];
+    assets->texture = texture;
+    assets->sound = sound;
+    sprintf(assets->sprite_path, "resources/items/sprites/%s.png", name);
+    if (sound) sprintf(assets->sound_path, "resources/items/audio/%s.mp3", name);
+}
+
+static void read_item_assets(int begin, int end, void *data) {
+    for (int i = begin; i < end; ++i) {
+        ItemAssets *assets = &ITEM_ASSETS[i];
+        assets->sprite = read_sprite_data(assets->sprite_path, false);
+        if (assets->sound) assets->sound_data = read_sound_data(assets->sound_path);
+        run_main_thread_job(upload_item_assets, assets, &UPLOADS_COUNTER);
+    }
+}
 
-        draw_mesh_m(item->matrix, SCENE.board.item_material, SCENE.board.item_mesh);
+static void upload_item_assets(void *data) {
+    ItemAssets *assets = data;
+    stream_sprite_data(&assets->sprite, assets->sprite_path, assets->texture, NULL, NULL);
+    if (assets->sound) {
+        *assets->sound = upload_sound_data(&assets->sound_data, assets->sound_path);
     }
 }
 
-static int compare_trees(const void *a, const void *b) {
-    const Tree *tree1 = (const Tree *)a;
-    const Tree *tree2 = (const Tree *)b;
+static void read_tree_sprites(int begin, int end, void *data) {
+    char fp[MAX_PATH_LENGTH];
+    Forest *forest = data;
+    for (int i = begin; i < end; ++i) {
+        sprintf(fp, "resources/trees/sprites/%s.png", forest->tree_names[i]);
+        TREE_SPRITES[i] = read_sprite_data(fp, true);
+        run_main_thread_job(upload_tree_sprite, (void *)(long)i, &UPLOADS_COUNTER);
+    }
+}
+
+static void upload_tree_sprite(void *data) {
+    char fp[MAX_PATH_LENGTH];
+    int i = (long)data;
+    Forest *forest = TREES_FOREST;
+    sprintf(fp, "resources/trees/sprites/%s.png", forest->tree_names[i]);
+    stream_sprite_data(
+        &TREE_SPRITES[i], fp, &forest->tree_textures[i], &forest->tree_meshes[i], NULL
+    );
+}
+
+static void compose_trees_world_matrices(int begin, int end, void *data) {
+    SceneSnapshot *snapshot = data;
+    Forest *forest = &SCENE.forest;
+    int n = end - begin;
+    Matrix *world = &snapshot->tree_worlds[begin];
+    compose_transform_matrices(&forest->tree_transforms[begin], world, n);
+    multiply_matrices(world, &forest->tree_matrices[begin], world, n);
+}
 
-    float d1 = Vector3Distance(tree1->transform.translation, SCENE.camera.position);
-    float d2 = Vector3Distance(tree2->transform.translation, SCENE.camera.position);
+void capture_scene_snapshot(SceneSnapshot *snapshot) {
+    update_scene_transforms();
 
-    if (d1 > d2) {
-        return -1;
-    } else if (d1 < d2) {
-        return 1;
-    } else {
-        return 0;
+    snapshot->camera = SCENE.camera;
+    snapshot->light_camera = SCENE.light_camera;
+    snapshot->golova_state = SCENE.golova.state;
+    snapshot->cracks_strength = SCENE.golova.cracks.strength;
+    for (int i = 0; i < NODE_ITEM_SLOTS; ++i) {
+        snapshot->node_worlds[i] = get_scene_node_world(i);
     }
+
+    Board *b = &SCENE.board;
+    int n_items = b->n_items;
+    snapshot->n_items = n_items;
+    memcpy(snapshot->item_matrices, b->item_matrices, n_items * sizeof(Matrix));
+    memcpy(snapshot->item_states, b->item_states, n_items * sizeof(ItemState));
+    memcpy(snapshot->item_textures, b->item_textures, n_items * sizeof(Texture2D));
+    snapshot->items_bob_height = b->items_bob_height;
+
+    int n_trees = SCENE.forest.n_trees;
+    snapshot->n_trees = n_trees;
+    parallel_for(n_trees, 256, compose_trees_world_matrices, snapshot);
 }
 
 void draw_scene(
+    const SceneSnapshot *snapshot,
     RenderTexture2D screen,
     Color clear_color,
     Camera3D camera,
-    bool with_shadows,
+    ShadowQuality shadow_quality,
     bool with_sky,
-    bool with_items,
-    bool sort_trees
+    bool with_items
 ) {
-    Matrix light_vp;
-    if (with_shadows && with_items) {
-        BeginTextureMode(SHADOWMAP);
-        rlDisableBackfaceCulling();
-
-        ClearBackground(BLANK);
-        BeginMode3D(SCENE.light_camera);
-        Matrix light_view = rlGetMatrixModelview();
-        Matrix light_proj = rlGetMatrixProjection();
-        light_vp = MatrixMultiply(light_view, light_proj);
-        draw_items(false);
-        EndMode3D();
-
-        EndTextureMode();
-    }
+    bool with_shadows = shadow_quality != SHADOWS_OFF && with_items;
+    RenderPass pass = set_render_pass(RENDER_PASS_SHADOWS);
+    PROFILE_BEGIN(draw_shadow_mask);
+    if (with_shadows) update_shadow_mask(snapshot, shadow_quality);
+    PROFILE_END(draw_shadow_mask);
 
     // -------------------------------------------------------------------
     // Draw scene
-    BeginTextureMode(screen);
+    begin_texture_mode(screen);
     ClearBackground(clear_color);
 
     // Sky
+    set_render_pass(RENDER_PASS_SKY);
+    PROFILE_BEGIN(draw_sky);
     if (with_sky) {
-        BeginShaderMode(MATERIAL_SKY.shader);
+        begin_shader_mode(MATERIAL_SKY.shader);
         float screen_size[2] = {GetScreenWidth(), GetScreenHeight()};
         float time = GetTime();
-        SetShaderValueV(
+        set_shader_value_v(
             MATERIAL_SKY.shader,
-            GetShaderLocation(MATERIAL_SKY.shader, "u_screen_size"),
+            get_shader_location(MATERIAL_SKY.shader, "u_screen_size"),
             screen_size,
             SHADER_UNIFORM_VEC2,
             1
         );
-        SetShaderValue(
+        set_shader_value(
             MATERIAL_SKY.shader,
-            GetShaderLocation(MATERIAL_SKY.shader, "u_time"),
+            get_shader_location(MATERIAL_SKY.shader, "u_time"),
             &time,
             SHADER_UNIFORM_FLOAT
         );
         DrawRectangle(0, 0, screen_size[0], screen_size[1], BLACK);
-        EndShaderMode();
+        count_shapes_draw();
+        end_shader_mode();
     }
+    PROFILE_END(draw_sky);
 
-    BeginMode3D(camera);
+    begin_mode_3d(camera);
+    begin_render_queue();
 
-    // Golova
-    Transform golova_transform = SCENE.golova.transform;
-    Matrix golova_mat = MatrixMultiply(
-        get_transform_matrix(golova_transform), SCENE.golova.matrix
-    );
-    Mesh golova_mesh;
+    // Golova. The packets keep the texture and the color of the diffuse map,
+    // so the maps shared by the materials are set through local copies
+    PROFILE_BEGIN(push_golova);
+    const Mesh *golova_mesh;
     Material golova_material;
-    if (SCENE.golova.state == GOLOVA_IDLE) {
-        golova_mesh = SCENE.golova.idle.mesh;
+    if (snapshot->golova_state == GOLOVA_IDLE) {
+        golova_mesh = &SCENE.golova.idle.mesh;
         golova_material = SCENE.golova.idle.material;
-    } else if (SCENE.golova.state == GOLOVA_EAT) {
-        golova_mesh = SCENE.golova.eat.mesh;
+    } else {
+        golova_mesh = &SCENE.golova.eat.mesh;
         golova_material = SCENE.golova.eat.material;
     }
-    draw_mesh_m(golova_mat, golova_material, golova_mesh);
+    push_mesh_packet(
+        RENDER_PASS_GOLOVA,
+        SCENE_LAYER_GOLOVA,
+        GOLOVA_ORDER_BODY,
+        false,
+        camera,
+        snapshot->node_worlds[NODE_GOLOVA],
+        golova_material,
+        golova_mesh
+    );
 
     // Golova cracks
-    Matrix cracks_matrix = golova_mat;
-    cracks_matrix = MatrixMultiply(MatrixTranslate(0.0, 0.01, 0.0), cracks_matrix);
-    SCENE.golova.cracks.material.maps[0].color = MAGENTA;
-    SCENE.golova.cracks.material.maps[0].color.a = (int
-    )(SCENE.golova.cracks.strength * 255.0);
-    draw_mesh_m(cracks_matrix, SCENE.golova.cracks.material, SCENE.golova.cracks.mesh);
+    Material cracks_material = SCENE.golova.cracks.material;
+    MaterialMap cracks_map = cracks_material.maps[0];
+    cracks_map.color = MAGENTA;
+    cracks_map.color.a = (int)(snapshot->cracks_strength * 255.0);
+    cracks_material.maps = &cracks_map;
+    push_mesh_packet(
+        RENDER_PASS_GOLOVA,
+        SCENE_LAYER_GOLOVA,
+        GOLOVA_ORDER_CRACKS,
+        false,
+        camera,
+        snapshot->node_worlds[NODE_GOLOVA_CRACKS],
+        cracks_material,
+        &SCENE.golova.cracks.mesh
+    );
 
     // Golova Eyes
-    float eyes_uplift = SCENE.golova.eyes_curr_uplift;
-    float eyes_shift = SCENE.golova.eyes_curr_shift;
-    float eyes_scale = SCENE.golova.eyes_idle_scale;
-    float eyes_spread = SCENE.golova.eyes_idle_spread;
+    Material material = SCENE.golova.eyes_material;
+    MaterialMap eye_map = material.maps[0];
+    material.maps = &eye_map;
+
+    eye_map.texture = SCENE.golova.eye_left.texture;
+    push_mesh_packet(
+        RENDER_PASS_GOLOVA,
+        SCENE_LAYER_GOLOVA,
+        GOLOVA_ORDER_EYES,
+        false,
+        camera,
+        snapshot->node_worlds[NODE_EYE_LEFT],
+        material,
+        &SCENE.golova.eye_left.mesh
+    );
 
-    Matrix s = MatrixScale(eyes_scale, eyes_scale, eyes_scale);
-    Matrix left_t = MatrixTranslate(-eyes_spread / 2.0 + eyes_shift, -0.01, -eyes_uplift);
-    Matrix right_t = MatrixTranslate(eyes_spread / 2.0 + eyes_shift, -0.01, -eyes_uplift);
+    eye_map.texture = SCENE.golova.eye_right.texture;
+    push_mesh_packet(
+        RENDER_PASS_GOLOVA,
+        SCENE_LAYER_GOLOVA,
+        GOLOVA_ORDER_EYES,
+        false,
+        camera,
+        snapshot->node_worlds[NODE_EYE_RIGHT],
+        material,
+        &SCENE.golova.eye_right.mesh
+    );
 
-    Matrix left_mat = MatrixMultiply(s, MatrixMultiply(left_t, golova_mat));
-    Matrix right_mat = MatrixMultiply(s, MatrixMultiply(right_t, golova_mat));
+    // Eyes background
+    Material eyes_background_material = MATERIAL_DEFAULT;
+    MaterialMap eyes_background_map = MATERIAL_DEFAULT.maps[0];
+    eyes_background_map.color = LIGHTGRAY;
+    eyes_background_material.maps = &eyes_background_map;
+    push_mesh_packet(
+        RENDER_PASS_GOLOVA,
+        SCENE_LAYER_GOLOVA,
+        GOLOVA_ORDER_EYES_BACKGROUND,
+        false,
+        camera,
+        snapshot->node_worlds[NODE_EYES_BACKGROUND],
+        eyes_background_material,
+        &SCENE.golova.eyes_background_mesh
+    );
+    PROFILE_END(push_golova);
+
+    // Forest, back to front from this camera
+    PROFILE_BEGIN(push_forest);
+    Material trees_material = SCENE.forest.trees_material;
+    MaterialMap tree_map = trees_material.maps[0];
+    trees_material.maps = &tree_map;
+    for (int i = 0; i < snapshot->n_trees; ++i) {
+        tree_map.texture = SCENE.forest.tree_textures[i];
+        push_mesh_packet(
+            RENDER_PASS_FOREST,
+            SCENE_LAYER_FOREST,
+            0,
+            true,
+            camera,
+            snapshot->tree_worlds[i],
+            trees_material,
+            &SCENE.forest.tree_meshes[i]
+        );
+    }
+    PROFILE_END(push_forest);
 
-    Material material = SCENE.golova.eyes_material;
+    // Board
+    PROFILE_BEGIN(push_board);
+    Material board_material = SCENE.board.material;
+    MaterialMap board_map = board_material.maps[0];
+    board_material.maps = &board_map;
+    if (with_shadows) {
+        Shader shader = get_shader_variant(
+            &SCENE.board.material.shader, 1 << SHADER_WITH_SHADOWS
+        );
+        set_shader_value_matrix(
+            shader, get_shader_location(shader, "u_light_vp"), SHADOW_LIGHT_VP
+        );
+        board_material.shader = shader;
+        board_map.texture = SHADOW_MASK.texture;
+    }
+    push_mesh_packet(
+        RENDER_PASS_BOARD,
+        SCENE_LAYER_BOARD,
+        0,
+        true,
+        camera,
+        snapshot->node_worlds[NODE_BOARD],
+        board_material,
+        &SCENE.board.mesh
+    );
+    PROFILE_END(push_board);
 
-    material.maps[0].texture = SCENE.golova.eye_left.texture;
-    draw_mesh_m(left_mat, material, SCENE.golova.eye_left.mesh);
+    // Items
+    PROFILE_BEGIN(push_items);
+    if (with_items) push_items(snapshot, camera);
+    PROFILE_END(push_items);
+
+    draw_render_queue();
+    end_mode_3d();
+    end_texture_mode();
+    set_render_pass(pass);
+}
 
-    material.maps[0].texture = SCENE.golova.eye_right.texture;
-    draw_mesh_m(right_mat, material, SCENE.golova.eye_right.mesh);
+// Single channel where the renderer can draw into one, the web build draws
+// into RGBA. The shadow shaders only use the red channel
+static RenderTexture2D load_shadow_mask(int size) {
+#if defined(PLATFORM_WEB)
+    RenderTexture2D mask = LoadRenderTexture(size, size);
+#else
+    RenderTexture2D mask = {0};
+    mask.id = rlLoadFramebuffer(size, size);
+    int format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE;
+    mask.texture.id = rlLoadTexture(NULL, size, size, format, 1);
+    mask.texture.width = size;
+    mask.texture.height = size;
+    mask.texture.mipmaps = 1;
+    mask.texture.format = format;
+    rlFramebufferAttach(
+        mask.id,
+        mask.texture.id,
+        RL_ATTACHMENT_COLOR_CHANNEL0,
+        RL_ATTACHMENT_TEXTURE2D,
+        0
+    );
+    if (!rlFramebufferComplete(mask.id)) {
+        TraceLog(LOG_WARNING, "Shadow mask framebuffer is not complete");
+    }
+#endif
 
-    // Eyes background
-    s = MatrixScale(0.75, 1.0, 0.15);
-    Matrix t = MatrixTranslate(0.0, -0.02, -eyes_uplift);
-    Matrix eyes_background_mat = MatrixMultiply(s, MatrixMultiply(t, golova_mat));
+    SetTextureFilter(mask.texture, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(mask.texture, TEXTURE_WRAP_CLAMP);
+    return mask;
+}
 
-    MATERIAL_DEFAULT.maps[0].color = LIGHTGRAY;
-    draw_mesh_m(eyes_background_mat, MATERIAL_DEFAULT, golova_mesh);
+static void update_shadow_mask(const SceneSnapshot *snapshot, ShadowQuality quality) {
+    int size = SHADOW_QUALITY_TO_SIZE(quality);
+    if (SHADOW_MASK.texture.width != size) {
+        ResourceOwner owner = set_resource_owner(OWNER_CORE);
+        unload_render_texture(SHADOW_MASK);
+        unload_render_texture(SHADOW_MASK_BLUR);
+        SHADOW_MASK = track_render_texture(load_shadow_mask(size), "shadow_mask");
+        SHADOW_MASK_BLUR = track_render_texture(
+            load_shadow_mask(size), "shadow_mask_blur"
+        );
+        set_resource_owner(owner);
+    }
 
-    // Forest
-    if (sort_trees) {
-        qsort(SCENE.forest.trees, SCENE.forest.n_trees, sizeof(Tree), compare_trees);
+    // Most frames nothing casting a shadow moves
+    static ShadowCasters casters;
+    memset(&casters, 0, sizeof(casters));
+    casters.quality = quality;
+    casters.caster_shader_id = SHADOW_CASTER_SHADER.id;
+    casters.blur_shader_id = SHADOW_BLUR_SHADER.id;
+    casters.light_camera = snapshot->light_camera;
+    casters.board_matrix = snapshot->node_worlds[NODE_BOARD];
+    int n_items = snapshot->n_items;
+    casters.n_items = n_items;
+    memcpy(casters.item_states, snapshot->item_states, n_items * sizeof(ItemState));
+    memcpy(casters.item_textures, snapshot->item_textures, n_items * sizeof(Texture2D));
+
+    // The bob lifts the items along the up axis of the items grid, the not cold
+    // ones higher
+    Matrix grid = snapshot->node_worlds[NODE_BOARD_ITEMS];
+    Vector3 bob = Vector3Scale(
+        (Vector3){grid.m4, grid.m5, grid.m6}, snapshot->items_bob_height
+    );
+    for (int i = 0; i < n_items; ++i) {
+        float k = snapshot->item_states[i] > ITEM_COLD ? HOT_ITEM_SCALE : 1.0;
+        Matrix m = snapshot->item_matrices[i];
+        m.m12 -= k * bob.x;
+        m.m13 -= k * bob.y;
+        m.m14 -= k * bob.z;
+        casters.item_matrices[i] = m;
     }
-    for (int i = 0; i < SCENE.forest.n_trees; ++i) {
-        Tree *tree = &SCENE.forest.trees[i];
-        SCENE.forest.trees_material.maps[0].texture = tree->texture;
-        Matrix mat = MatrixMultiply(get_transform_matrix(tree->transform), tree->matrix);
-        draw_mesh_m(mat, SCENE.forest.trees_material, tree->mesh);
+    if (memcmp(&casters, &SHADOW_CASTERS, sizeof(casters)) == 0) return;
+    SHADOW_CASTERS = casters;
+
+    Camera3D light = casters.light_camera;
+    Matrix light_view = MatrixLookAt(light.position, light.target, light.up);
+    Matrix light_proj = fit_light_frustum(&casters);
+    SHADOW_LIGHT_VP = MatrixMultiply(light_view, light_proj);
+
+    // Items coverage, as seen from the light
+    begin_texture_mode(SHADOW_MASK);
+    ClearBackground(BLANK);
+    rlDisableBackfaceCulling();
+    rlSetMatrixProjection(light_proj);
+    rlSetMatrixModelview(light_view);
+
+    // The maps are shared with the item material, its texture is put back after
+    Material material = SCENE.board.item_material;
+    material.shader = SHADOW_CASTER_SHADER;
+    Texture2D texture = material.maps[0].texture;
+    for (int i = 0; i < n_items; ++i) {
+        if (casters.item_states[i] == ITEM_DEAD) continue;
+        material.maps[0].texture = casters.item_textures[i];
+        draw_mesh_m(casters.item_matrices[i], material, SCENE.board.item_mesh);
     }
+    material.maps[0].texture = texture;
+    end_texture_mode();
 
-    // Board
-    Shader shader = SCENE.board.material.shader;
-    SCENE.board.material.maps[0].texture = SHADOWMAP.texture;
-    SetShaderValueMatrix(shader, GetShaderLocation(shader, "u_light_vp"), light_vp);
-    int u_with_shadows = (int)with_shadows;
-    SetShaderValue(
-        shader,
-        GetShaderLocation(shader, "u_with_shadows"),
-        &u_with_shadows,
-        SHADER_UNIFORM_INT
+    // Blurred once here, so the board samples the mask once per fragment
+    draw_shadow_blur_pass(SHADOW_MASK.texture, SHADOW_MASK_BLUR, (Vector2){1.0, 0.0});
+    draw_shadow_blur_pass(SHADOW_MASK_BLUR.texture, SHADOW_MASK, (Vector2){0.0, 1.0});
+}
+
+// Orthographic light projection around the board and the items bounds in the
+// light view space, so the whole mask lands on the board
+static Matrix fit_light_frustum(const ShadowCasters *casters) {
+    Camera3D light = casters->light_camera;
+    Matrix view = MatrixLookAt(light.position, light.target, light.up);
+
+    Matrix board_view = MatrixMultiply(casters->board_matrix, view);
+    BoundingBox bounds = get_transformed_box(
+        GetMeshBoundingBox(SCENE.board.mesh), board_view
     );
-    draw_mesh_t(SCENE.board.transform, SCENE.board.material, SCENE.board.mesh);
 
-    // Items
-    if (with_items) {
-        draw_items(true);
+    BoundingBox item_box = GetMeshBoundingBox(SCENE.board.item_mesh);
+    for (int i = 0; i < casters->n_items; ++i) {
+        if (casters->item_states[i] == ITEM_DEAD) continue;
+        Matrix item_view = MatrixMultiply(casters->item_matrices[i], view);
+        BoundingBox box = get_transformed_box(item_box, item_view);
+        bounds.min = Vector3Min(bounds.min, box.min);
+        bounds.max = Vector3Max(bounds.max, box.max);
     }
 
-    EndMode3D();
-    EndTextureMode();
+    // Room for the blur at the edges. The view looks down the -z axis
+    Vector3 margin = Vector3Scale(Vector3Subtract(bounds.max, bounds.min), 0.05);
+    bounds.min = Vector3Subtract(bounds.min, margin);
+    bounds.max = Vector3Add(bounds.max, margin);
+    return MatrixOrtho(
+        bounds.min.x,
+        bounds.max.x,
+        bounds.min.y,
+        bounds.max.y,
+        -bounds.max.z - 1.0,
+        -bounds.min.z + 1.0
+    );
 }
 
-void draw_postfx(Texture2D texture, bool with_blur) {
-    BeginShaderMode(POSTFX_SHADER);
-    int u_with_blur = (int)with_blur;
-    SetShaderValue(
-        POSTFX_SHADER,
-        GetShaderLocation(POSTFX_SHADER, "u_with_blur"),
-        &u_with_blur,
-        SHADER_UNIFORM_INT
+static void draw_shadow_blur_pass(
+    Texture2D texture, RenderTexture2D target, Vector2 direction
+) {
+    Shader shader = SHADOW_BLUR_SHADER;
+    Vector2 u_direction = Vector2Scale(direction, 1.0 / texture.width);
+
+    begin_texture_mode(target);
+    begin_shader_mode(shader);
+    set_shader_value(
+        shader,
+        get_shader_location(shader, "u_direction"),
+        &u_direction,
+        SHADER_UNIFORM_VEC2
     );
     DrawTextureRec(
         texture,
@@ -492,11 +1362,62 @@ void draw_postfx(Texture2D texture, bool with_blur) {
         (Vector2){0, 0},
         WHITE
     );
-    EndShaderMode();
+    count_batch_draw(texture.id);
+    end_shader_mode();
+    end_texture_mode();
 }
 
+Shader compile_fragment_shader(const char *fs_text) {
+    PROFILE_BEGIN(compile_fragment_shader);
+    char *vs = get_shader_src("base.vert");
+    char *fs = compose_shader_src(fs_text);
+    Shader shader = LoadShaderFromMemory(vs, fs);
+    PROFILE_END(compile_fragment_shader);
+
+    free(vs);
+    free(fs);
+    return shader;
+}
+
+static void read_core_shader_src(void *data) {
+    int idx = (int)(long)data;
+    double time = get_trace_time();
+    CORE_ASSETS.shader_srcs[idx] = load_shader_src(CORE_SHADER_FILE_NAMES[idx]);
+    add_trace_event(CORE_SHADER_FILE_NAMES[idx], time);
+}
+
+static void read_core_sprite(void *data) {
+    int idx = (int)(long)data;
+    double time = get_trace_time();
+    CORE_ASSETS.sprites[idx] = read_sprite_data(CORE_SPRITE_FILE_PATHS[idx], true);
+    add_trace_event(CORE_SPRITE_FILE_PATHS[idx], time);
+}
+
+// A copy of the prepared source while init_core runs, the file otherwise
+static char *get_shader_src(const char *file_name) {
+    for (int i = 0; i < N_CORE_SHADER_FILES; ++i) {
+        char *src = CORE_ASSETS.shader_srcs[i];
+        if (src == NULL || strcmp(CORE_SHADER_FILE_NAMES[i], file_name) != 0) continue;
+
+        char *copy = malloc(strlen(src) + 1);
+        strcpy(copy, src);
+        return copy;
+    }
+    return load_shader_src(file_name);
+}
+
+// Safe on worker threads
 static char *load_shader_src(const char *file_name) {
+    char file_path[MAX_PATH_LENGTH];
+    snprintf(file_path, sizeof(file_path), "resources/shaders/%s", file_name);
+    char *text = LoadFileText(file_path);
+    char *src = compose_shader_src(text);
+    UnloadFileText(text);
+    return src;
+}
 
+// Prepends the version and the common functions
+static char *compose_shader_src(const char *text) {
     const char *version;
 
 #if defined(PLATFORM_WEB)
@@ -506,7 +1427,6 @@ static char *load_shader_src(const char *file_name) {
 #endif
 
     char *common = LoadFileText("resources/shaders/common.glsl");
-    char *text = LoadFileText(TextFormat("resources/shaders/%s", file_name));
 
     char *src = malloc(strlen(version) + strlen(common) + strlen(text) + 6);
 
@@ -522,29 +1442,276 @@ static char *load_shader_src(const char *file_name) {
     strcpy(&src[p], text);
 
     UnloadFileText(common);
-    UnloadFileText(text);
 
     return src;
 }
 
-static Shader load_shader(const char *vs_file_name, const char *fs_file_name) {
-    char *vs = NULL;
-    char *fs = NULL;
-
-    if (vs_file_name) {
-        vs = load_shader_src(vs_file_name);
-    } else {
-        vs = load_shader_src("base.vert");
+// Writes the declared features to the feature_mask if it's not NULL. Returns
+// the raylib default shader if the compilation fails
+static Shader compile_shader(
+    const char *vs_file_name, const char *fs_file_name, int features, int *feature_mask
+) {
+    PROFILE_BEGIN(compile_shader);
+    char *srcs[2] = {NULL, NULL};
+    srcs[0] = get_shader_src(vs_file_name ? vs_file_name : "base.vert");
+    if (fs_file_name) srcs[1] = get_shader_src(fs_file_name);
+
+    int declared = 0;
+    for (int i = 0; i < 2; ++i) {
+        if (srcs[i] == NULL) continue;
+        declared |= get_shader_src_features(srcs[i]);
+
+        if (features == 0) continue;
+        char *src = define_shader_features(srcs[i], features);
+        free(srcs[i]);
+        srcs[i] = src;
     }
+    if (feature_mask) *feature_mask = declared;
 
-    if (fs_file_name) fs = load_shader_src(fs_file_name);
-    Shader shader = LoadShaderFromMemory(vs, fs);
+    Shader shader = LoadShaderFromMemory(srcs[0], srcs[1]);
 
-    if (vs) free(vs);
-    if (fs) free(fs);
+    if (srcs[0]) free(srcs[0]);
+    if (srcs[1]) free(srcs[1]);
+    PROFILE_END(compile_shader);
     return shader;
 }
 
+static int get_shader_src_features(const char *src) {
+    const char *pragma = "#pragma features";
+    const char *line = strstr(src, pragma);
+    if (line == NULL) return 0;
+
+    int features = 0;
+    const char *p = line + strlen(pragma);
+    while (*p != '\0' && *p != '\n') {
+        while (*p == ' ' || *p == '\t') p += 1;
+        int len = strcspn(p, " \t\r\n");
+        if (len == 0) break;
+
+        bool is_known = false;
+        for (int i = 0; i < N_SHADER_FEATURES; ++i) {
+            const char *name = SHADER_FEATURE_TO_NAME(i);
+            if ((int)strlen(name) != len || strncmp(p, name, len) != 0) continue;
+            features |= 1 << i;
+            is_known = true;
+        }
+        if (!is_known) TraceLog(LOG_WARNING, "Unknown shader feature %.*s", len, p);
+        p += len;
+    }
+    return features;
+}
+
+// The defines go right after the version line, which must stay the first one
+static char *define_shader_features(const char *src, int features) {
+    const char *rest = strchr(src, '\n');
+    rest = rest ? rest + 1 : src + strlen(src);
+    int version_len = rest - src;
+
+    char *dst = malloc(strlen(src) + 32 * N_SHADER_FEATURES + 2);
+    memcpy(dst, src, version_len);
+    int p = version_len;
+    if (p > 0 && dst[p - 1] != '\n') dst[p++] = '\n';
+    for (int i = 0; i < N_SHADER_FEATURES; ++i) {
+        if (!(features & (1 << i))) continue;
+        p += sprintf(&dst[p], "#define %s\n", SHADER_FEATURE_TO_NAME(i));
+    }
+    strcpy(&dst[p], rest);
+    return dst;
+}
+
+static void load_shader(
+    Shader *shader, const char *vs_file_name, const char *fs_file_name
+) {
+    int feature_mask;
+    *shader = compile_shader(vs_file_name, fs_file_name, 0, &feature_mask);
+    track_shader(*shader, fs_file_name ? fs_file_name : "default");
+
+    if (N_SHADER_SLOTS == MAX_N_CORE_SHADERS) return;
+    ShaderSlot *slot = &SHADER_SLOTS[N_SHADER_SLOTS++];
+    *slot = (ShaderSlot){0};
+    slot->shader = shader;
+    slot->owner = get_resource_owner();
+    slot->feature_mask = feature_mask;
+    strcpy(slot->vs_file_name, vs_file_name ? vs_file_name : "base.vert");
+    strcpy(slot->fs_file_name, fs_file_name ? fs_file_name : "");
+}
+
+// Features not declared by the shader sources are ignored, so they don't make
+// duplicate variants
+static Shader get_shader_variant(const Shader *shader, int features) {
+    ShaderSlot *slot = NULL;
+    for (int i = 0; i < N_SHADER_SLOTS && slot == NULL; ++i) {
+        if (SHADER_SLOTS[i].shader == shader) slot = &SHADER_SLOTS[i];
+    }
+    if (slot == NULL) return *shader;
+
+    features &= slot->feature_mask;
+    if (features == 0) return *shader;
+    for (int i = 0; i < slot->n_variants; ++i) {
+        if (slot->variants[i].features == features) return slot->variants[i].shader;
+    }
+
+    if (slot->n_variants == MAX_N_SHADER_VARIANTS) {
+        TraceLog(LOG_WARNING, "Too many variants of %s", slot->fs_file_name);
+        return *shader;
+    }
+
+    const char *fs_file_name = slot->fs_file_name[0] ? slot->fs_file_name : NULL;
+    Shader variant = compile_shader(slot->vs_file_name, fs_file_name, features, NULL);
+    if (variant.id == rlGetShaderIdDefault()) {
+        TraceLog(LOG_WARNING, "Failed to compile a variant of %s", slot->fs_file_name);
+    }
+
+    ResourceOwner owner = set_resource_owner(slot->owner);
+    track_shader(variant, fs_file_name ? fs_file_name : "default");
+    set_resource_owner(owner);
+
+    slot->variants[slot->n_variants++] = (ShaderVariant){features, variant};
+    return variant;
+}
+
+static void load_core_sprite(
+    CoreSprite sprite, Texture2D *texture, Mesh *mesh, float *aspect
+) {
+    const char *file_path = CORE_SPRITE_FILE_PATHS[sprite];
+    *texture = upload_sprite_data(&CORE_ASSETS.sprites[sprite], file_path, mesh, aspect);
+
+    if (N_SPRITE_SLOTS == MAX_N_CORE_SPRITES) return;
+    SpriteSlot *slot = &SPRITE_SLOTS[N_SPRITE_SLOTS++];
+    slot->texture = texture;
+    slot->mesh = mesh;
+    slot->owner = get_resource_owner();
+    strcpy(slot->file_path, file_path);
+}
+
+// A shader which doesn't compile anymore is kept, so a typo doesn't break
+// the running game
+static int reload_shaders(const char *file_name) {
+    bool is_common = strcmp(file_name, "common.glsl") == 0;
+
+    int n_reloaded = 0;
+    for (int i = 0; i < N_SHADER_SLOTS; ++i) {
+        ShaderSlot *slot = &SHADER_SLOTS[i];
+        bool is_used = is_common || strcmp(slot->vs_file_name, file_name) == 0
+                       || strcmp(slot->fs_file_name, file_name) == 0;
+        if (!is_used) continue;
+
+        const char *fs_file_name = slot->fs_file_name[0] ? slot->fs_file_name : NULL;
+        int feature_mask;
+        Shader shader = compile_shader(
+            slot->vs_file_name, fs_file_name, 0, &feature_mask
+        );
+        if (shader.id == rlGetShaderIdDefault()) {
+            TraceLog(
+                LOG_WARNING,
+                "Failed to reload %s + %s, keeping the old shader",
+                slot->vs_file_name,
+                fs_file_name ? fs_file_name : "default"
+            );
+            continue;
+        }
+
+        ResourceOwner owner = set_resource_owner(slot->owner);
+        unload_shader(*slot->shader);
+        *slot->shader = track_shader(shader, fs_file_name ? fs_file_name : "default");
+
+        // The other variants are compiled again on their next use
+        for (int j = 0; j < slot->n_variants; ++j) {
+            unload_shader(slot->variants[j].shader);
+        }
+        slot->n_variants = 0;
+        slot->feature_mask = feature_mask;
+        set_resource_owner(owner);
+        n_reloaded += 1;
+    }
+
+    return n_reloaded;
+}
+
+static int reload_sprites(const char *file_path) {
+    static char fp[2048];
+    int n_reloaded = 0;
+
+    for (int i = 0; i < N_SPRITE_SLOTS; ++i) {
+        SpriteSlot *slot = &SPRITE_SLOTS[i];
+        if (strcmp(slot->file_path, file_path) != 0) continue;
+        n_reloaded += reload_sprite(file_path, slot->owner, slot->texture, slot->mesh);
+    }
+
+    Board *b = &SCENE.board;
+    for (int i = 0; i < b->n_items; ++i) {
+        sprintf(fp, "resources/items/sprites/%s.png", b->items[i].name);
+        if (strcmp(fp, file_path) != 0) continue;
+        n_reloaded += reload_sprite(file_path, OWNER_ITEMS, &b->item_textures[i], NULL);
+    }
+
+    for (int i = 0; i < b->n_hint_items; ++i) {
+        HintItem *item = &b->hint_items[i];
+        sprintf(fp, "resources/items/sprites/%s.png", item->name);
+        if (strcmp(fp, file_path) != 0) continue;
+        n_reloaded += reload_sprite(file_path, OWNER_ITEMS, &item->texture, NULL);
+    }
+
+    Forest *f = &SCENE.forest;
+    for (int i = 0; i < f->n_trees; ++i) {
+        sprintf(fp, "resources/trees/sprites/%s.png", f->tree_names[i]);
+        if (strcmp(fp, file_path) != 0) continue;
+        n_reloaded += reload_sprite(
+            file_path, OWNER_FOREST, &f->tree_textures[i], &f->tree_meshes[i]
+        );
+    }
+
+    return n_reloaded;
+}
+
+// The sound bank has the samples of the last cook, so the source file is
+// loaded directly
+static int reload_sounds(const char *file_path) {
+    static char fp[2048];
+    int n_reloaded = 0;
+
+    ResourceOwner owner = set_resource_owner(OWNER_ITEMS);
+    for (int i = 0; i < SCENE.board.n_items; ++i) {
+        Item *item = &SCENE.board.items[i];
+        sprintf(fp, "resources/items/audio/%s.mp3", item->name);
+        if (strcmp(fp, file_path) != 0) continue;
+
+        // The same path as load_scene, so a cooked sound comes from the bank
+        Sound sound = load_sound(file_path);
+        if (sound.stream.buffer == NULL) continue;
+        unload_sound(item->sound);
+        item->sound = sound;
+        n_reloaded += 1;
+    }
+    set_resource_owner(owner);
+
+    return n_reloaded;
+}
+
+// Keeps the old sprite if the new file can't be loaded, e.g. it's half written
+static bool reload_sprite(
+    const char *file_path, ResourceOwner owner, Texture2D *texture, Mesh *mesh
+) {
+    ResourceOwner prev_owner = set_resource_owner(owner);
+    Mesh new_mesh = {0};
+    Texture2D new_texture = load_sprite_texture(file_path, mesh ? &new_mesh : NULL, NULL);
+    set_resource_owner(prev_owner);
+
+    if (new_texture.id == 0) {
+        unload_mesh(new_mesh);
+        return false;
+    }
+
+    cancel_texture_stream(texture);
+    unload_texture(*texture);
+    *texture = new_texture;
+    if (mesh) {
+        unload_mesh(*mesh);
+        *mesh = new_mesh;
+    }
+    return true;
+}
+
 static void fwrite_transform(Transform *transform, FILE *f) {
     fwrite(&transform->translation.x, sizeof(float), 1, f);
     fwrite(&transform->translation.y, sizeof(float), 1, f);
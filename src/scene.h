@@ -6,6 +6,7 @@
 #define MAX_N_BOARD_ITEMS 64
 #define MAX_NAME_LENGTH 128
 #define MAX_RULE_LENGTH 128
+#define MAX_PATH_LENGTH 256
 
 typedef enum GolovaState {
     GOLOVA_IDLE = 0,
@@ -43,6 +44,7 @@ typedef struct Golova {
     float eyes_curr_uplift;
 
     Material eyes_material;
+    Mesh eyes_background_mesh;
 
     struct {
         Texture2D texture;
@@ -71,17 +73,22 @@ typedef enum ItemState {
      : (state == ITEM_DEAD)   ? "ITEM_DEAD" \
                               : "UNKNOWN")
 
+// Items which are not cold are drawn larger and bob higher by this factor
+#define HOT_ITEM_SCALE 1.2
+
+// Cold item data, only used on loads, saves and game events. The per-frame
+// item data is in the Board arrays at the same index
 typedef struct Item {
-    Texture2D texture;
     Sound sound;
-    Matrix matrix;
-
     bool is_correct;
-    ItemState state;
-
     char name[MAX_NAME_LENGTH];
 } Item;
 
+typedef struct HintItem {
+    Texture2D texture;
+    char name[MAX_NAME_LENGTH];
+} HintItem;
+
 typedef struct Board {
     Transform transform;
     Material material;
@@ -95,59 +102,175 @@ typedef struct Board {
     float item_scale;
     float item_elevation;
 
+    // Runtime height of the items grid above the board (the items fall onto it)
+    // and the bobbing of the cold items, both applied to the grid node
+    float items_drop_height;
+    float items_bob_height;
+
     Material item_material;
     Mesh item_mesh;
+
+    // Items are stored as parallel arrays, so the per-frame loops stream
+    // through the hot data only
     int n_items;
+    Matrix item_matrices[MAX_N_BOARD_ITEMS];
+    ItemState item_states[MAX_N_BOARD_ITEMS];
+    Texture2D item_textures[MAX_N_BOARD_ITEMS];
     Item items[MAX_N_BOARD_ITEMS];
 
     int n_hint_items;
-    Item hint_items[MAX_N_BOARD_ITEMS];
+    HintItem hint_items[MAX_N_BOARD_ITEMS];
 } Board;
 
-typedef struct Tree {
-    char name[MAX_NAME_LENGTH];
-    Transform transform;
-    Texture texture;
-    Mesh mesh;
-
-    Matrix matrix;
-} Tree;
-
-#define MAX_N_FOREST_TREES 64
+// Trees are stored as parallel arrays. Names are only used on loads and saves
+#define MAX_N_FOREST_TREES 4096
 typedef struct Forest {
     char name[MAX_NAME_LENGTH];
     int n_trees;
-    Tree trees[MAX_N_FOREST_TREES];
+    Transform tree_transforms[MAX_N_FOREST_TREES];
+    Matrix tree_matrices[MAX_N_FOREST_TREES];
+    Texture2D tree_textures[MAX_N_FOREST_TREES];
+    Mesh tree_meshes[MAX_N_FOREST_TREES];
+    char tree_names[MAX_N_FOREST_TREES][MAX_NAME_LENGTH];
 
     Material trees_material;
 } Forest;
 
+// Transform hierarchy. A node's world matrix is its local matrix followed by
+// the world matrix of its parent. Nodes have a fixed topology, and only the
+// subtrees whose local matrices changed are recomputed
+typedef enum SceneNodeId {
+    NODE_GOLOVA = 0,
+    NODE_GOLOVA_CRACKS,
+    NODE_EYE_LEFT,
+    NODE_EYE_RIGHT,
+    NODE_EYES_BACKGROUND,
+
+    NODE_BOARD,
+    NODE_BOARD_ITEMS,
+
+    // Grid cells of the board items and the items placed in them
+    NODE_ITEM_SLOTS,
+    NODE_ITEMS = NODE_ITEM_SLOTS + MAX_N_BOARD_ITEMS,
+
+    N_SCENE_NODES = NODE_ITEMS + MAX_N_BOARD_ITEMS,
+} SceneNodeId;
+
+typedef struct SceneNode {
+    int parent;
+    int first_child;
+    int next_sibling;
+
+    bool is_dirty;
+    Matrix local;
+    Matrix world;
+} SceneNode;
+
 typedef struct Scene {
     Golova golova;
     Board board;
     Forest forest;
 
     Camera3D camera;
+
+    // Only the direction is used, the light projection is fitted to the board
+    // and the items
     Camera3D light_camera;
 } Scene;
 
+// Side of the square shadow mask
+typedef enum ShadowQuality {
+    SHADOWS_OFF = 0,
+    SHADOWS_LOW,
+    SHADOWS_MEDIUM,
+    SHADOWS_HIGH,
+} ShadowQuality;
+
+#define SHADOW_QUALITY_TO_NAME(quality) \
+    ((quality == SHADOWS_OFF)      ? "Off" \
+     : (quality == SHADOWS_LOW)    ? "Low" \
+     : (quality == SHADOWS_MEDIUM) ? "Medium" \
+     : (quality == SHADOWS_HIGH)   ? "High" \
+                                   : "Unknown")
+
+#define SHADOW_QUALITY_TO_SIZE(quality) \
+    ((quality == SHADOWS_LOW) ? 256 : (quality == SHADOWS_MEDIUM) ? 512 : 1024)
+
 extern Scene SCENE;
 
+// Starts reading and decoding the core shaders and sprites on the workers. It
+// needs no window, init_core waits for the files and uploads them
+void request_core_assets(void);
 void init_core(int screen_width, int screen_height);
 
 void load_scene(const char *file_path);
+
+// Files which load_scene pulls in for the items of the scene, so they can be
+// fetched ahead of time where they are not bundled with the game
+int get_scene_asset_paths(
+    const char *file_path, char paths[][MAX_PATH_LENGTH], int max_n_paths
+);
 void save_scene(const char *file_path);
 
 void load_forest(Forest *forest, const char *file_path);
 void save_forest(Forest *forest, const char *file_path);
+void unload_forest_trees(Forest *forest);
+void remove_forest_tree(Forest *forest, int idx);
+void unload_board_item(Board *board, int idx);
+
+// Reloads a changed shader, sprite, item sound or the current forest file in
+// place: materials, items and trees are switched to the new resources. Scene
+// files are not reloaded here, the game state depends on them. Returns false
+// if the file is not used or can't be loaded
+bool reload_scene_file(const char *file_path);
+
+void set_scene_node_local(int node, Matrix local);
+Matrix get_scene_node_world(int node);
+void update_scene_nodes(void);
+void update_scene_transforms(void);
+
+// Everything draw_scene reads from the simulated state. Drawing works only on a
+// snapshot, so the next frame can be simulated while this one is submitted.
+// Resources (textures, meshes, materials) are not copied, they only change on
+// scene loads
+typedef struct SceneSnapshot {
+    Camera3D camera;
+    Camera3D light_camera;
+
+    GolovaState golova_state;
+    float cracks_strength;
+
+    // World matrices of the nodes before the item slots
+    Matrix node_worlds[NODE_ITEM_SLOTS];
+
+    int n_items;
+    Matrix item_matrices[MAX_N_BOARD_ITEMS];
+    ItemState item_states[MAX_N_BOARD_ITEMS];
+    Texture2D item_textures[MAX_N_BOARD_ITEMS];
+    float items_bob_height;
 
+    // Tree world matrices by tree index, draw_scene sorts them by the camera it
+    // draws with
+    int n_trees;
+    Matrix tree_worlds[MAX_N_FOREST_TREES];
+} SceneSnapshot;
+
+// Updates the scene transforms and copies the state to draw into the snapshot
+void capture_scene_snapshot(SceneSnapshot *snapshot);
+
+// The items cast shadows on the board through a single channel mask, which is
+// drawn and blurred only when the items, the light or the quality change. The
+// items are drawn into it at rest, so their bob doesn't redraw it every frame
 void draw_scene(
+    const SceneSnapshot *snapshot,
     RenderTexture2D screen,
     Color clear_color,
     Camera3D camera,
-    bool with_shadows,
+    ShadowQuality shadow_quality,
     bool with_sky,
-    bool with_items,
-    bool sort_trees
+    bool with_items
 );
-void draw_postfx(Texture2D texture, bool is_blured);
+
+// Compiles the fragment shader source with the version and the common
+// functions prepended. Returns the raylib default shader if it fails
+Shader compile_fragment_shader(const char *fs_text);
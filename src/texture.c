@@ -0,0 +1,329 @@
+#include "texture.h"
+
+#include "math.h"
+#include "raylib.h"
+#include "resources.h"
+#include "rlgl.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool read_texture_file(const char *file_path, SpriteData *data);
+static void read_source_image(const char *file_path, SpriteData *data, bool with_hull);
+static Mesh gen_sprite_mesh(TextureFileHeader header);
+static Mesh gen_hull_mesh(TextureFileHeader header);
+static float cross2(Vector2 o, Vector2 a, Vector2 b);
+static int compare_points(const void *a, const void *b);
+
+void get_cooked_texture_path(char *dst, const char *file_path) {
+    const char *ext = strrchr(file_path, '.');
+    int n = ext ? (int)(ext - file_path) : (int)strlen(file_path);
+    sprintf(dst, "%.*s%s", n, file_path, TEXTURE_FILE_EXT);
+}
+
+Texture2D load_texture(const char *file_path) {
+    return load_sprite_texture(file_path, NULL, NULL);
+}
+
+Texture2D load_sprite_texture(const char *file_path, Mesh *mesh, float *aspect) {
+    SpriteData data = read_sprite_data(file_path, mesh != NULL);
+    return upload_sprite_data(&data, file_path, mesh, aspect);
+}
+
+SpriteData read_sprite_data(const char *file_path, bool with_hull) {
+    SpriteData data = {0};
+    if (!read_texture_file(file_path, &data)) {
+        read_source_image(file_path, &data, with_hull);
+    }
+    return data;
+}
+
+Texture2D upload_sprite_data(
+    SpriteData *data, const char *file_path, Mesh *mesh, float *aspect
+) {
+    Texture2D texture = {0};
+    TextureFileHeader *header = &data->header;
+
+    if (data->file_data) {
+        // Returns 0 if the GPU doesn't support the compressed format
+        unsigned int id = rlLoadTexture(
+            data->file_data + sizeof(TextureFileHeader),
+            header->width,
+            header->height,
+            header->format,
+            header->n_mipmaps
+        );
+        UnloadFileData(data->file_data);
+        data->file_data = NULL;
+
+        if (id == 0) {
+            TraceLog(LOG_WARNING, "Can't upload cooked %s, using the source", file_path);
+            read_source_image(file_path, data, mesh != NULL);
+        } else {
+            texture.id = id;
+            texture.width = header->width;
+            texture.height = header->height;
+            texture.mipmaps = header->n_mipmaps;
+            texture.format = header->format;
+            if (texture.mipmaps > 1) SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+        }
+    }
+
+    if (texture.id == 0) {
+        texture = LoadTextureFromImage(data->image);
+        UnloadImage(data->image);
+        data->image = (Image){0};
+    }
+
+    upload_sprite_mesh(data, file_path, mesh, aspect);
+    return track_texture(texture, file_path);
+}
+
+void upload_sprite_mesh(
+    const SpriteData *data, const char *file_path, Mesh *mesh, float *aspect
+) {
+    const TextureFileHeader *header = &data->header;
+    if (mesh) *mesh = track_mesh(gen_sprite_mesh(*header), file_path);
+    if (aspect) *aspect = (float)header->source_width / header->source_height;
+}
+
+void unload_sprite_data(SpriteData *data) {
+    if (data->file_data) UnloadFileData(data->file_data);
+    if (data->image.data) UnloadImage(data->image);
+    data->file_data = NULL;
+    data->image = (Image){0};
+}
+
+static bool read_texture_file(const char *file_path, SpriteData *data) {
+    char cooked_path[2048];
+    get_cooked_texture_path(cooked_path, file_path);
+    if (!FileExists(cooked_path)) return false;
+
+    int n_bytes;
+    unsigned char *file_data = LoadFileData(cooked_path, &n_bytes);
+    if (file_data == NULL) return false;
+
+    TextureFileHeader *header = &data->header;
+    int header_size = sizeof(TextureFileHeader);
+    if (n_bytes < header_size) {
+        TraceLog(LOG_ERROR, "Cooked texture %s is corrupted", cooked_path);
+        UnloadFileData(file_data);
+        return false;
+    }
+    memcpy(header, file_data, header_size);
+    if (memcmp(header->magic, TEXTURE_FILE_MAGIC, 4) != 0
+        || header->data_size != n_bytes - header_size) {
+        TraceLog(LOG_ERROR, "Cooked texture %s is corrupted", cooked_path);
+        UnloadFileData(file_data);
+        return false;
+    }
+
+    data->file_data = file_data;
+    return true;
+}
+
+static void read_source_image(const char *file_path, SpriteData *data, bool with_hull) {
+    Image image = LoadImage(file_path);
+    TextureFileHeader *header = &data->header;
+    *header = (TextureFileHeader){0};
+    header->width = image.width;
+    header->height = image.height;
+    header->source_width = image.width;
+    header->source_height = image.height;
+
+    // Not cooked sprite, fit the hull now
+    if (with_hull && IsImageReady(image)) {
+        header->n_hull_points = compute_alpha_hull(
+            image, DEFAULT_N_HULL_POINTS, header->hull_points
+        );
+    }
+    data->image = image;
+}
+
+int compute_alpha_hull(Image image, int max_n_points, Vector2 *points) {
+    max_n_points = CLAMP(max_n_points, 4, MAX_N_HULL_POINTS);
+
+    Image rgba = ImageCopy(image);
+    ImageFormat(&rgba, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    unsigned char *pixels = rgba.data;
+    int width = rgba.width;
+    int height = rgba.height;
+
+    // Hull of the leftmost and rightmost opaque texel corners of every row
+    int n_corners = 0;
+    Vector2 *corners = malloc(height * 4 * sizeof(Vector2));
+    for (int y = 0; y < height; ++y) {
+        int x_min = -1;
+        int x_max = -1;
+        for (int x = 0; x < width; ++x) {
+            if (pixels[(y * width + x) * 4 + 3] < HULL_ALPHA_THRESHOLD) continue;
+            if (x_min == -1) x_min = x;
+            x_max = x;
+        }
+        if (x_min == -1) continue;
+
+        corners[n_corners++] = (Vector2){x_min, y};
+        corners[n_corners++] = (Vector2){x_min, y + 1};
+        corners[n_corners++] = (Vector2){x_max + 1, y};
+        corners[n_corners++] = (Vector2){x_max + 1, y + 1};
+    }
+    UnloadImage(rgba);
+
+    if (n_corners == 0) {
+        free(corners);
+        return 0;
+    }
+
+    // Monotone chain, counter-clockwise in a y-up frame
+    qsort(corners, n_corners, sizeof(Vector2), compare_points);
+    int n_hull = 0;
+    Vector2 *hull = malloc((n_corners + 1) * sizeof(Vector2));
+    for (int i = 0; i < n_corners; ++i) {
+        Vector2 p = corners[i];
+        while (n_hull >= 2 && cross2(hull[n_hull - 2], hull[n_hull - 1], p) <= 0) {
+            n_hull -= 1;
+        }
+        hull[n_hull++] = p;
+    }
+    int n_lower = n_hull + 1;
+    for (int i = n_corners - 2; i >= 0; --i) {
+        Vector2 p = corners[i];
+        while (n_hull >= n_lower && cross2(hull[n_hull - 2], hull[n_hull - 1], p) <= 0) {
+            n_hull -= 1;
+        }
+        hull[n_hull++] = p;
+    }
+    n_hull -= 1;
+    free(corners);
+
+    // Collapse the edge b-c into the intersection of the lines a-b and d-c.
+    // It's possible only if the lines meet beyond b and c, and the new point
+    // must stay within the texture
+    while (n_hull > max_n_points) {
+        int best = -1;
+        float best_area = FLT_MAX;
+        Vector2 best_point;
+        for (int i = 0; i < n_hull; ++i) {
+            Vector2 a = hull[(i + n_hull - 1) % n_hull];
+            Vector2 b = hull[i];
+            Vector2 c = hull[(i + 1) % n_hull];
+            Vector2 d = hull[(i + 2) % n_hull];
+
+            Vector2 u = {b.x - a.x, b.y - a.y};
+            Vector2 w = {c.x - d.x, c.y - d.y};
+            float denom = u.x * w.y - u.y * w.x;
+            if (fabsf(denom) < 1e-6) continue;
+
+            Vector2 ad = {d.x - a.x, d.y - a.y};
+            float t = (ad.x * w.y - ad.y * w.x) / denom;
+            float s = (ad.x * u.y - ad.y * u.x) / denom;
+            if (t < 1.0 || s < 1.0) continue;
+
+            Vector2 q = {a.x + t * u.x, a.y + t * u.y};
+            if (q.x < 0.0 || q.y < 0.0 || q.x > width || q.y > height) continue;
+
+            float area = 0.5 * fabsf(cross2(b, c, q));
+            if (area < best_area) {
+                best = i;
+                best_area = area;
+                best_point = q;
+            }
+        }
+        if (best == -1) break;
+
+        hull[best] = best_point;
+        int removed = (best + 1) % n_hull;
+        int n_tail = n_hull - removed - 1;
+        memmove(&hull[removed], &hull[removed + 1], n_tail * sizeof(Vector2));
+        n_hull -= 1;
+    }
+
+    // The hull can't be reduced below the budget, a plain quad is cheaper
+    int n_points = n_hull <= max_n_points ? n_hull : 0;
+    for (int i = 0; i < n_points; ++i) {
+        points[i] = (Vector2){hull[i].x / width, hull[i].y / height};
+    }
+    free(hull);
+    return n_points;
+}
+
+static Mesh gen_sprite_mesh(TextureFileHeader header) {
+    if (header.n_hull_points >= 3) return gen_hull_mesh(header);
+
+    float source_width = header.source_width;
+    float source_height = header.source_height;
+
+    // Plane texture coordinates grow along x and z, so the first image row
+    // lies at -z. Units are chosen to make the whole source image 1 unit high
+    float width = header.width / source_height;
+    float length = header.height / source_height;
+    Mesh mesh = GenMeshPlane(width, length, 2, 2);
+
+    float center_x = (header.crop_x + 0.5 * header.width) / source_width - 0.5;
+    float center_z = (header.crop_y + 0.5 * header.height) / source_height - 0.5;
+    center_x *= source_width / source_height;
+    if (center_x == 0.0 && center_z == 0.0) return mesh;
+
+    for (int i = 0; i < mesh.vertexCount; ++i) {
+        mesh.vertices[i * 3 + 0] += center_x;
+        mesh.vertices[i * 3 + 2] += center_z;
+    }
+    UpdateMeshBuffer(mesh, 0, mesh.vertices, mesh.vertexCount * 3 * sizeof(float), 0);
+    return mesh;
+}
+
+// Triangle fan over the hull, placed like the plane of gen_sprite_mesh
+static Mesh gen_hull_mesh(TextureFileHeader header) {
+    int n = header.n_hull_points;
+    float source_width = header.source_width;
+    float source_height = header.source_height;
+
+    Mesh mesh = {0};
+    mesh.vertexCount = n;
+    mesh.triangleCount = n - 2;
+    mesh.vertices = malloc(n * 3 * sizeof(float));
+    mesh.texcoords = malloc(n * 2 * sizeof(float));
+    mesh.normals = malloc(n * 3 * sizeof(float));
+    mesh.indices = malloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+
+    for (int i = 0; i < n; ++i) {
+        Vector2 uv = header.hull_points[i];
+        float x = (header.crop_x + uv.x * header.width) / source_width - 0.5;
+        float z = (header.crop_y + uv.y * header.height) / source_height - 0.5;
+
+        mesh.vertices[i * 3 + 0] = x * source_width / source_height;
+        mesh.vertices[i * 3 + 1] = 0.0;
+        mesh.vertices[i * 3 + 2] = z;
+        mesh.texcoords[i * 2 + 0] = uv.x;
+        mesh.texcoords[i * 2 + 1] = uv.y;
+        mesh.normals[i * 3 + 0] = 0.0;
+        mesh.normals[i * 3 + 1] = 1.0;
+        mesh.normals[i * 3 + 2] = 0.0;
+    }
+
+    // Hull is counter-clockwise in the image (x, y) frame, which is clockwise
+    // in the plane's (x, z) frame seen from above, so the fan is reversed to
+    // face +y like the plane does
+    for (int i = 0; i < mesh.triangleCount; ++i) {
+        mesh.indices[i * 3 + 0] = 0;
+        mesh.indices[i * 3 + 1] = i + 2;
+        mesh.indices[i * 3 + 2] = i + 1;
+    }
+
+    UploadMesh(&mesh, false);
+    return mesh;
+}
+
+static float cross2(Vector2 o, Vector2 a, Vector2 b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+static int compare_points(const void *a, const void *b) {
+    const Vector2 *p1 = a;
+    const Vector2 *p2 = b;
+    if (p1->x != p2->x) return p1->x < p2->x ? -1 : 1;
+    if (p1->y != p2->y) return p1->y < p2->y ? -1 : 1;
+    return 0;
+}
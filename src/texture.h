@@ -0,0 +1,78 @@
+#pragma once
+
+#include "raylib.h"
+
+// Cooked texture file produced by the cook tool. The pixel data is uploaded
+// as is: a full mip chain in either RGBA8 or BC3 (DXT5). Sprites can be
+// trimmed to their alpha bounds, the header keeps the region of the source
+// image the texture covers, so the sprite quad stays in the same place.
+// Sprites also keep a convex hull of their opaque texels, which is drawn
+// instead of the quad to avoid shading fully transparent texels
+#define TEXTURE_FILE_MAGIC "GTX2"
+#define TEXTURE_FILE_EXT ".tex"
+
+#define MAX_N_HULL_POINTS 16
+#define DEFAULT_N_HULL_POINTS 8
+
+// Texels with lower alpha are discarded by the sprite shader
+#define HULL_ALPHA_THRESHOLD 3
+
+typedef struct TextureFileHeader {
+    char magic[4];
+    int format;
+    int width;
+    int height;
+    int n_mipmaps;
+    int data_size;
+
+    int source_width;
+    int source_height;
+    int crop_x;
+    int crop_y;
+
+    // Texture coordinates of the hull points, counter-clockwise in the image
+    int n_hull_points;
+    Vector2 hull_points[MAX_N_HULL_POINTS];
+} TextureFileHeader;
+
+void get_cooked_texture_path(char *dst, const char *file_path);
+
+// Load the cooked texture next to the source image if it exists and its
+// format is supported by the GPU, fall back to the source image otherwise
+Texture2D load_texture(const char *file_path);
+
+// Same as load_texture, but also generates the sprite quad. The quad is 1 unit
+// high for the whole source image and matches the trimmed region of it.
+// Aspect of the source image is returned via aspect, if it's not NULL
+Texture2D load_sprite_texture(const char *file_path, Mesh *mesh, float *aspect);
+
+// CPU half of load_sprite_texture: reads the cooked file or decodes the source
+// image and fits the hull. Makes no GL calls, so it's safe on worker threads
+typedef struct SpriteData {
+    TextureFileHeader header;
+
+    // Either the whole cooked file or the decoded source image
+    unsigned char *file_data;
+    Image image;
+} SpriteData;
+
+SpriteData read_sprite_data(const char *file_path, bool with_hull);
+
+// GPU half of load_sprite_texture, must run on the main thread. Releases the
+// CPU data
+Texture2D upload_sprite_data(
+    SpriteData *data, const char *file_path, Mesh *mesh, float *aspect
+);
+
+// The sprite quad and the aspect of upload_sprite_data, without the texture.
+// Either can be NULL
+void upload_sprite_mesh(
+    const SpriteData *data, const char *file_path, Mesh *mesh, float *aspect
+);
+void unload_sprite_data(SpriteData *data);
+
+// Convex hull of the texels with alpha >= HULL_ALPHA_THRESHOLD, in texture
+// coordinates. Hull edges are collapsed until there are at most max_n_points
+// points left, always growing the hull by the smallest area, so it never cuts
+// off opaque texels. Returns 0 if the image is fully transparent
+int compute_alpha_hull(Image image, int max_n_points, Vector2 *points);
@@ -0,0 +1,501 @@
+#include "texture_stream.h"
+
+#include "profiler.h"
+#include "resources.h"
+#include "rlgl.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(PLATFORM_WEB)
+#include <GLES3/gl3.h>
+#define HAS_RING 0
+#else
+#define GLFW_INCLUDE_NONE
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GLFW/glfw3.h>
+#define HAS_RING 1
+#endif
+
+typedef enum TextureStreamState {
+    STREAM_FREE = 0,
+    STREAM_UPLOADING,
+
+    // Every row is issued, the GPU may still be reading them from the ring
+    STREAM_LANDING,
+
+    // The full texture is in place, the placeholder waits to be unloaded
+    STREAM_RETIRING,
+} TextureStreamState;
+
+typedef struct TextureStream {
+    TextureStreamState state;
+    Texture2D *dst;
+    Texture2D texture;
+    Texture2D placeholder;
+    ResourceOwner owner;
+    char file_path[MAX_RESOURCE_NAME_LENGTH];
+
+    SpriteData data;
+    const unsigned char *pixels;
+
+    // Next rows to upload. The level offset is in bytes from the pixels
+    int level;
+    int level_offset;
+    int row;
+
+    // Ring bytes written up to the last row of the texture
+    long end_head;
+    int n_retire_frames;
+} TextureStream;
+
+static bool IS_INIT;
+static int BUDGET = DEFAULT_TEXTURE_STREAM_BUDGET;
+static long N_UPLOADED_BYTES;
+static int N_STREAMS;
+static TextureStream STREAMS[MAX_N_TEXTURE_STREAMS];
+
+#if HAS_RING
+typedef struct RingFence {
+    GLsync sync;
+    long head;
+} RingFence;
+
+typedef struct GlFunctions {
+    PFNGLGENBUFFERSPROC gen_buffers;
+    PFNGLDELETEBUFFERSPROC delete_buffers;
+    PFNGLBINDBUFFERPROC bind_buffer;
+    PFNGLBUFFERSTORAGEPROC buffer_storage;
+    PFNGLMAPBUFFERRANGEPROC map_buffer_range;
+    PFNGLUNMAPBUFFERPROC unmap_buffer;
+    PFNGLFENCESYNCPROC fence_sync;
+    PFNGLCLIENTWAITSYNCPROC client_wait_sync;
+    PFNGLDELETESYNCPROC delete_sync;
+} GlFunctions;
+
+static GlFunctions GL;
+
+// Head and tail count all the bytes ever written and released, the ring
+// offset is the count modulo the ring size
+static unsigned int RING_BUFFER;
+static unsigned char *RING_DATA;
+static long RING_HEAD;
+static long RING_TAIL;
+static int N_RING_FENCES;
+static RingFence RING_FENCES[MAX_N_TEXTURE_STREAM_FENCES];
+
+static void init_ring(void);
+static void poll_ring_fences(void);
+static long alloc_ring(int n_bytes);
+#endif
+
+static Texture2D load_placeholder(const SpriteData *data);
+static bool upload_texture_stream(TextureStream *stream, int *budget);
+static void upload_rows(TextureStream *stream, int n_rows, const void *pixels);
+static void release_texture_stream(TextureStream *stream);
+static bool is_compressed_format(int format);
+static int get_level_size(int size, int level);
+
+void init_texture_streams(void) {
+#if HAS_RING
+    init_ring();
+#endif
+    IS_INIT = true;
+}
+
+void unload_texture_streams(void) {
+    for (int i = 0; i < N_STREAMS; ++i) {
+        TextureStream *stream = &STREAMS[i];
+        if (stream->state == STREAM_RETIRING) unload_texture(stream->placeholder);
+        else release_texture_stream(stream);
+    }
+    N_STREAMS = 0;
+
+#if HAS_RING
+    for (int i = 0; i < N_RING_FENCES; ++i) GL.delete_sync(RING_FENCES[i].sync);
+    N_RING_FENCES = 0;
+    if (RING_BUFFER) {
+        GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, RING_BUFFER);
+        GL.unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+        GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        GL.delete_buffers(1, &RING_BUFFER);
+    }
+    RING_BUFFER = 0;
+    RING_DATA = NULL;
+#endif
+    IS_INIT = false;
+}
+
+void stream_sprite_data(
+    SpriteData *data, const char *file_path, Texture2D *texture, Mesh *mesh, float *aspect
+) {
+    cancel_texture_stream(texture);
+
+    const TextureFileHeader *header = &data->header;
+    bool has_pixels = data->file_data != NULL || data->image.data != NULL;
+    if (!IS_INIT || !has_pixels || N_STREAMS == MAX_N_TEXTURE_STREAMS) {
+        *texture = upload_sprite_data(data, file_path, mesh, aspect);
+        return;
+    }
+
+    TextureStream stream = {0};
+    stream.dst = texture;
+    stream.owner = get_resource_owner();
+    snprintf(stream.file_path, sizeof(stream.file_path), "%s", file_path);
+    if (data->file_data) {
+        stream.texture.width = header->width;
+        stream.texture.height = header->height;
+        stream.texture.mipmaps = header->n_mipmaps;
+        stream.texture.format = header->format;
+        stream.pixels = data->file_data + sizeof(TextureFileHeader);
+    } else {
+        stream.texture.width = data->image.width;
+        stream.texture.height = data->image.height;
+        stream.texture.mipmaps = 1;
+        stream.texture.format = data->image.format;
+        stream.pixels = data->image.data;
+    }
+
+    // Only allocates the levels. Returns 0 if the GPU doesn't support the
+    // compressed format, upload_sprite_data falls back to the source then
+    Texture2D *t = &stream.texture;
+    t->id = rlLoadTexture(NULL, t->width, t->height, t->format, t->mipmaps);
+    if (t->id == 0) {
+        *texture = upload_sprite_data(data, file_path, mesh, aspect);
+        return;
+    }
+
+    stream.state = STREAM_UPLOADING;
+    stream.data = *data;
+    *data = (SpriteData){0};
+
+    stream.placeholder = track_texture(load_placeholder(&stream.data), file_path);
+    *texture = stream.placeholder;
+    upload_sprite_mesh(&stream.data, file_path, mesh, aspect);
+    STREAMS[N_STREAMS++] = stream;
+}
+
+void cancel_texture_stream(Texture2D *texture) {
+    for (int i = 0; i < N_STREAMS; ++i) {
+        TextureStream *stream = &STREAMS[i];
+        if (stream->dst != texture || stream->state == STREAM_FREE) continue;
+
+        // The landed texture is the caller's already
+        if (stream->state == STREAM_RETIRING) stream->dst = NULL;
+        else release_texture_stream(stream);
+    }
+}
+
+void move_texture_stream(Texture2D *from, Texture2D *to) {
+    for (int i = 0; i < N_STREAMS; ++i) {
+        if (STREAMS[i].dst == from) STREAMS[i].dst = to;
+    }
+}
+
+void update_texture_streams(void) {
+    if (!IS_INIT) return;
+    PROFILE_BEGIN(update_texture_streams);
+
+    bool can_upload = true;
+#if HAS_RING
+    poll_ring_fences();
+    long ring_tail = RING_TAIL;
+    if (RING_DATA) {
+        can_upload = N_RING_FENCES < MAX_N_TEXTURE_STREAM_FENCES;
+        GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, RING_BUFFER);
+    }
+    long head = RING_HEAD;
+#else
+    long ring_tail = 0;
+#endif
+
+    // Oldest streams first
+    int budget = BUDGET;
+    rlActiveTextureSlot(0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < N_STREAMS; ++i) {
+        TextureStream *stream = &STREAMS[i];
+        if (stream->state == STREAM_UPLOADING && can_upload && budget > 0) {
+            can_upload = upload_texture_stream(stream, &budget);
+        }
+
+        if (stream->state == STREAM_LANDING && stream->end_head <= ring_tail) {
+            if (stream->texture.mipmaps > 1) {
+                SetTextureFilter(stream->texture, TEXTURE_FILTER_TRILINEAR);
+            }
+            ResourceOwner owner = set_resource_owner(stream->owner);
+            *stream->dst = track_texture(stream->texture, stream->file_path);
+            set_resource_owner(owner);
+
+            stream->state = STREAM_RETIRING;
+            stream->n_retire_frames = N_TEXTURE_STREAM_RETIRE_FRAMES;
+        } else if (stream->state == STREAM_RETIRING) {
+            stream->n_retire_frames -= 1;
+            if (stream->n_retire_frames < 0) {
+                unload_texture(stream->placeholder);
+                stream->state = STREAM_FREE;
+            }
+        }
+    }
+    rlDisableTexture();
+
+#if HAS_RING
+    if (RING_DATA) {
+        if (RING_HEAD != head) {
+            GLsync sync = GL.fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            RING_FENCES[N_RING_FENCES++] = (RingFence){sync, RING_HEAD};
+        }
+
+        // Client memory uploads of the other loaders must not read the ring
+        GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+#endif
+
+    int n_streams = 0;
+    for (int i = 0; i < N_STREAMS; ++i) {
+        if (STREAMS[i].state != STREAM_FREE) STREAMS[n_streams++] = STREAMS[i];
+    }
+    N_STREAMS = n_streams;
+    PROFILE_END(update_texture_streams);
+}
+
+// Frames in flight share the ring
+void set_texture_stream_budget(int n_bytes) {
+    int max_n_bytes = TEXTURE_STREAM_RING_SIZE / MAX_N_TEXTURE_STREAM_FENCES;
+    BUDGET = n_bytes < max_n_bytes ? n_bytes : max_n_bytes;
+}
+
+TextureStreamStats get_texture_stream_stats(void) {
+    TextureStreamStats stats = {0};
+#if HAS_RING
+    stats.with_ring = RING_DATA != NULL;
+#endif
+    stats.n_uploaded_bytes = N_UPLOADED_BYTES;
+    for (int i = 0; i < N_STREAMS; ++i) {
+        TextureStream *stream = &STREAMS[i];
+        if (stream->state != STREAM_UPLOADING) continue;
+        stats.n_streams += 1;
+
+        Texture2D t = stream->texture;
+        int size = 0;
+        for (int level = 0; level < t.mipmaps; ++level) {
+            int w = get_level_size(t.width, level);
+            int h = get_level_size(t.height, level);
+            size += GetPixelDataSize(w, h, t.format);
+        }
+        int w = get_level_size(t.width, stream->level);
+        stats.n_pending_bytes += size - stream->level_offset
+                                 - GetPixelDataSize(w, stream->row, t.format);
+    }
+    return stats;
+}
+
+// The smallest mip which is not larger than the placeholder size, so the
+// sprite keeps roughly its colors until the full texture lands
+static Texture2D load_placeholder(const SpriteData *data) {
+    Texture2D placeholder = {0};
+    const TextureFileHeader *header = &data->header;
+    int offset = 0;
+    for (int level = 0; data->file_data && level < header->n_mipmaps; ++level) {
+        int w = get_level_size(header->width, level);
+        int h = get_level_size(header->height, level);
+        if (w > TEXTURE_STREAM_PLACEHOLDER_SIZE || h > TEXTURE_STREAM_PLACEHOLDER_SIZE) {
+            offset += GetPixelDataSize(w, h, header->format);
+            continue;
+        }
+
+        const unsigned char *pixels = data->file_data + sizeof(TextureFileHeader);
+        placeholder.id = rlLoadTexture(pixels + offset, w, h, header->format, 1);
+        placeholder.width = w;
+        placeholder.height = h;
+        placeholder.mipmaps = 1;
+        placeholder.format = header->format;
+        SetTextureFilter(placeholder, TEXTURE_FILTER_BILINEAR);
+        return placeholder;
+    }
+
+    unsigned char texel[4] = {0};
+    int format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    placeholder.id = rlLoadTexture(texel, 1, 1, format, 1);
+    placeholder.width = 1;
+    placeholder.height = 1;
+    placeholder.mipmaps = 1;
+    placeholder.format = format;
+    return placeholder;
+}
+
+// Uploads whole rows of blocks within the budget, but always at least one, so
+// a texture wider than the budget still lands. Returns false if the ring is
+// full, nothing else can be uploaded this frame then
+static bool upload_texture_stream(TextureStream *stream, int *budget) {
+    Texture2D t = stream->texture;
+    int block_size = is_compressed_format(t.format) ? 4 : 1;
+    if (t.format == PIXELFORMAT_COMPRESSED_ASTC_8x8_RGBA) block_size = 8;
+
+    bool is_first = true;
+    while (stream->state == STREAM_UPLOADING && *budget > 0) {
+        int w = get_level_size(t.width, stream->level);
+        int h = get_level_size(t.height, stream->level);
+        int row_size = GetPixelDataSize(w, block_size, t.format);
+        int n_rows = block_size * (*budget / row_size);
+        if (n_rows == 0 && !is_first) break;
+        if (n_rows == 0) n_rows = block_size;
+        if (n_rows > h - stream->row) n_rows = h - stream->row;
+
+        int n_bytes = GetPixelDataSize(w, n_rows, t.format);
+        const unsigned char *pixels = stream->pixels + stream->level_offset
+                                      + GetPixelDataSize(w, stream->row, t.format);
+#if HAS_RING
+        if (RING_DATA) {
+            long offset = alloc_ring(n_bytes);
+            if (offset == -1) return false;
+            memcpy(RING_DATA + offset, pixels, n_bytes);
+            pixels = (const unsigned char *)(uintptr_t)offset;
+            stream->end_head = RING_HEAD;
+        }
+#endif
+        upload_rows(stream, n_rows, pixels);
+        *budget -= n_bytes;
+        N_UPLOADED_BYTES += n_bytes;
+        is_first = false;
+
+        stream->row += n_rows;
+        if (stream->row < h) continue;
+
+        stream->row = 0;
+        stream->level_offset += GetPixelDataSize(w, h, t.format);
+        stream->level += 1;
+        if (stream->level == t.mipmaps) {
+            // Every row is either in the ring or already copied by the GL
+            unload_sprite_data(&stream->data);
+            stream->pixels = NULL;
+            stream->state = STREAM_LANDING;
+        }
+    }
+
+    return true;
+}
+
+// The pixels are an offset into the bound ring buffer, if there is one
+static void upload_rows(TextureStream *stream, int n_rows, const void *pixels) {
+    Texture2D t = stream->texture;
+    int level = stream->level;
+    int w = get_level_size(t.width, level);
+    int n_bytes = GetPixelDataSize(w, n_rows, t.format);
+
+    unsigned int internal_format, format, type;
+    rlGetGlTextureFormats(t.format, &internal_format, &format, &type);
+
+    rlEnableTexture(t.id);
+    if (is_compressed_format(t.format)) {
+        glCompressedTexSubImage2D(
+            GL_TEXTURE_2D,
+            level,
+            0,
+            stream->row,
+            w,
+            n_rows,
+            internal_format,
+            n_bytes,
+            pixels
+        );
+    } else {
+        glTexSubImage2D(
+            GL_TEXTURE_2D, level, 0, stream->row, w, n_rows, format, type, pixels
+        );
+    }
+}
+
+static void release_texture_stream(TextureStream *stream) {
+    unload_sprite_data(&stream->data);
+    if (stream->texture.id) rlUnloadTexture(stream->texture.id);
+    *stream = (TextureStream){0};
+}
+
+static bool is_compressed_format(int format) {
+    return format >= PIXELFORMAT_COMPRESSED_DXT1_RGB;
+}
+
+static int get_level_size(int size, int level) {
+    size >>= level;
+    return size > 0 ? size : 1;
+}
+
+#if HAS_RING
+static void init_ring(void) {
+    GL.gen_buffers = (PFNGLGENBUFFERSPROC)glfwGetProcAddress("glGenBuffers");
+    GL.delete_buffers = (PFNGLDELETEBUFFERSPROC)glfwGetProcAddress("glDeleteBuffers");
+    GL.bind_buffer = (PFNGLBINDBUFFERPROC)glfwGetProcAddress("glBindBuffer");
+    GL.buffer_storage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+    GL.map_buffer_range = (PFNGLMAPBUFFERRANGEPROC)glfwGetProcAddress("glMapBufferRange");
+    GL.unmap_buffer = (PFNGLUNMAPBUFFERPROC)glfwGetProcAddress("glUnmapBuffer");
+    GL.fence_sync = (PFNGLFENCESYNCPROC)glfwGetProcAddress("glFenceSync");
+    GL.client_wait_sync = (PFNGLCLIENTWAITSYNCPROC)glfwGetProcAddress("glClientWaitSync");
+    GL.delete_sync = (PFNGLDELETESYNCPROC)glfwGetProcAddress("glDeleteSync");
+
+    bool has_storage = GL.buffer_storage != NULL
+                       && glfwExtensionSupported("GL_ARB_buffer_storage");
+    if (!has_storage || !GL.map_buffer_range || !GL.fence_sync) {
+        TraceLog(LOG_INFO, "TEXTURE_STREAM: No persistent mapping, uploading directly");
+        return;
+    }
+
+    int flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GL.gen_buffers(1, &RING_BUFFER);
+    GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, RING_BUFFER);
+    GL.buffer_storage(GL_PIXEL_UNPACK_BUFFER, TEXTURE_STREAM_RING_SIZE, NULL, flags);
+    RING_DATA = GL.map_buffer_range(
+        GL_PIXEL_UNPACK_BUFFER, 0, TEXTURE_STREAM_RING_SIZE, flags
+    );
+    GL.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (RING_DATA == NULL) {
+        TraceLog(
+            LOG_WARNING, "TEXTURE_STREAM: Failed to map the ring, uploading directly"
+        );
+        GL.delete_buffers(1, &RING_BUFFER);
+        RING_BUFFER = 0;
+        return;
+    }
+    TraceLog(
+        LOG_INFO,
+        "TEXTURE_STREAM: Uploading through a %d MB ring",
+        TEXTURE_STREAM_RING_SIZE >> 20
+    );
+}
+
+// Never waits, the fences which are not signaled yet are checked next frame
+static void poll_ring_fences(void) {
+    int n_signaled = 0;
+    while (n_signaled < N_RING_FENCES) {
+        RingFence *fence = &RING_FENCES[n_signaled];
+        GLenum status = GL.client_wait_sync(fence->sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+
+        GL.delete_sync(fence->sync);
+        RING_TAIL = fence->head;
+        n_signaled += 1;
+    }
+
+    N_RING_FENCES -= n_signaled;
+    memmove(RING_FENCES, &RING_FENCES[n_signaled], N_RING_FENCES * sizeof(RingFence));
+}
+
+// Returns the ring offset of the contiguous bytes, or -1 if the GPU still reads
+// that part of the ring
+static long alloc_ring(int n_bytes) {
+    n_bytes = (n_bytes + 15) & ~15;
+    long offset = RING_HEAD % TEXTURE_STREAM_RING_SIZE;
+    long n_skipped = 0;
+    if (offset + n_bytes > TEXTURE_STREAM_RING_SIZE) {
+        n_skipped = TEXTURE_STREAM_RING_SIZE - offset;
+    }
+    if (RING_HEAD + n_skipped + n_bytes - RING_TAIL > TEXTURE_STREAM_RING_SIZE) return -1;
+
+    RING_HEAD += n_skipped;
+    offset = RING_HEAD % TEXTURE_STREAM_RING_SIZE;
+    RING_HEAD += n_bytes;
+    return offset;
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "raylib.h"
+#include "texture.h"
+
+// Texture streaming. A streamed sprite gets a placeholder right away: its
+// smallest mip not larger than TEXTURE_STREAM_PLACEHOLDER_SIZE, or a
+// transparent texel if it has no mips. The full texture is uploaded a few rows
+// at a time, at most budget bytes per frame, and replaces the placeholder once
+// the GPU is done with it.
+//
+// Where the GL supports persistent mapping, the rows are copied into a ring of
+// mapped pixel buffer memory and the GPU reads them from there, with a fence
+// per frame telling which part of the ring is free again. Otherwise (the web
+// build) the rows are uploaded from the client memory, still within the budget
+#define MAX_N_TEXTURE_STREAMS 256
+#define MAX_N_TEXTURE_STREAM_FENCES 4
+#define TEXTURE_STREAM_RING_SIZE (16 << 20)
+#define DEFAULT_TEXTURE_STREAM_BUDGET (2 << 20)
+#define TEXTURE_STREAM_PLACEHOLDER_SIZE 32
+
+// Replaced placeholders may still be drawn by the snapshots in flight
+#define N_TEXTURE_STREAM_RETIRE_FRAMES 2
+
+typedef struct TextureStreamStats {
+    bool with_ring;
+    int n_streams;
+    long n_pending_bytes;
+    long n_uploaded_bytes;
+} TextureStreamStats;
+
+// Needs the GL context
+void init_texture_streams(void);
+void unload_texture_streams(void);
+
+// Same as upload_sprite_data, but the texture is replaced when the upload
+// lands, so it must stay in place until then, or be moved with
+// move_texture_stream. The current resource owner owns both textures
+void stream_sprite_data(
+    SpriteData *data, const char *file_path, Texture2D *texture, Mesh *mesh, float *aspect
+);
+
+// Must be called before the streamed texture is unloaded or replaced. The
+// placeholder stays and is unloaded as usual
+void cancel_texture_stream(Texture2D *texture);
+void move_texture_stream(Texture2D *from, Texture2D *to);
+
+// Main thread, once per frame, when nothing reads the streamed textures
+void update_texture_streams(void);
+void set_texture_stream_budget(int n_bytes);
+TextureStreamStats get_texture_stream_stats(void);
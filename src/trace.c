@@ -0,0 +1,123 @@
+#include "trace.h"
+
+#include "jobs.h"
+#include "raylib.h"
+#include <stdio.h>
+
+#if defined(PLATFORM_WEB)
+#include <emscripten/emscripten.h>
+#else
+#include <time.h>
+#endif
+
+typedef struct TraceEvent {
+    const char *name;
+    int thread_id;
+    double begin_time;
+    double end_time;
+} TraceEvent;
+
+static double START_TIME;
+static int N_TRACE_EVENTS;
+static TraceEvent TRACE_EVENTS[MAX_N_TRACE_EVENTS];
+
+static double get_now_ms(void);
+
+void init_trace(void) {
+    START_TIME = get_now_ms();
+    N_TRACE_EVENTS = 0;
+}
+
+double get_trace_time(void) {
+    return get_now_ms() - START_TIME;
+}
+
+void add_trace_event(const char *name, double begin_time) {
+    double end_time = get_trace_time();
+    int idx = __atomic_fetch_add(&N_TRACE_EVENTS, 1, __ATOMIC_RELAXED);
+    if (idx >= MAX_N_TRACE_EVENTS) return;
+
+    TRACE_EVENTS[idx] = (TraceEvent){name, get_job_thread_id(), begin_time, end_time};
+}
+
+bool save_trace(const char *file_path) {
+    TraceWriter writer;
+    if (!open_trace_writer(&writer, file_path)) return false;
+
+    int n_events = __atomic_load_n(&N_TRACE_EVENTS, __ATOMIC_ACQUIRE);
+    if (n_events > MAX_N_TRACE_EVENTS) n_events = MAX_N_TRACE_EVENTS;
+
+    for (int i = 0; i < n_events; ++i) {
+        TraceEvent *event = &TRACE_EVENTS[i];
+        write_trace_event(
+            &writer, event->name, event->thread_id, event->begin_time, event->end_time
+        );
+    }
+    close_trace_writer(&writer);
+
+    TraceLog(LOG_INFO, "TRACE: Saved %d events to %s", n_events, file_path);
+    return true;
+}
+
+bool open_trace_writer(TraceWriter *writer, const char *file_path) {
+    *writer = (TraceWriter){0};
+    writer->f = fopen(file_path, "w");
+    if (writer->f == NULL) {
+        TraceLog(LOG_WARNING, "TRACE: Failed to save %s", file_path);
+        return false;
+    }
+
+    fprintf(writer->f, "{\"traceEvents\": [");
+    return true;
+}
+
+// Metadata ("M") event, the events are separated before each one but the first
+void write_trace_thread_name(TraceWriter *writer, int thread_id, const char *name) {
+    fprintf(
+        writer->f,
+        "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+        "\"args\": {\"name\": \"%s\"}}",
+        writer->n_events > 0 ? "," : "",
+        thread_id,
+        name
+    );
+    writer->n_events += 1;
+}
+
+// Complete ("X") event, with the times in microseconds
+void write_trace_event(
+    TraceWriter *writer,
+    const char *name,
+    int thread_id,
+    double begin_time,
+    double end_time
+) {
+    fprintf(
+        writer->f,
+        "%s\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, "
+        "\"ts\": %.1f, \"dur\": %.1f}",
+        writer->n_events > 0 ? "," : "",
+        name,
+        thread_id,
+        begin_time * 1000.0,
+        (end_time - begin_time) * 1000.0
+    );
+    writer->n_events += 1;
+}
+
+void close_trace_writer(TraceWriter *writer) {
+    fprintf(writer->f, "\n]}\n");
+    fclose(writer->f);
+    writer->f = NULL;
+}
+
+static double get_now_ms(void) {
+#if defined(PLATFORM_WEB)
+    return emscripten_get_now();
+#else
+    // GetTime needs the window, which doesn't exist yet at the start
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec * 1e-6;
+#endif
+}
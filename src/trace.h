@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Timeline of the startup steps. Events are recorded from any thread and saved
+// in the Chrome trace format, which chrome://tracing and Perfetto open.
+// Times are in milliseconds since init_trace
+#define MAX_N_TRACE_EVENTS 4096
+
+void init_trace(void);
+double get_trace_time(void);
+
+// Records the event from begin_time until now on the calling thread. The name
+// must outlive the trace. Events past MAX_N_TRACE_EVENTS are dropped
+void add_trace_event(const char *name, double begin_time);
+
+bool save_trace(const char *file_path);
+
+// Writer of the Chrome trace files, shared with the profiler. Events are
+// complete ("X") events, the times are in milliseconds like get_trace_time
+typedef struct TraceWriter {
+    FILE *f;
+    int n_events;
+} TraceWriter;
+
+bool open_trace_writer(TraceWriter *writer, const char *file_path);
+void write_trace_thread_name(TraceWriter *writer, int thread_id, const char *name);
+void write_trace_event(
+    TraceWriter *writer,
+    const char *name,
+    int thread_id,
+    double begin_time,
+    double end_time
+);
+void close_trace_writer(TraceWriter *writer);
@@ -0,0 +1,201 @@
+#include "ui_text.h"
+
+#include "raylib.h"
+#include "render_stats.h"
+#include "rlgl.h"
+#include <string.h>
+
+// Same as the font size limits of DrawText and MeasureText
+#define DEFAULT_FONT_SIZE 10
+
+// Position and size relative to the text origin, and the texture coordinates
+typedef struct UiGlyph {
+    Rectangle dst;
+    Rectangle uv;
+} UiGlyph;
+
+typedef struct UiText {
+    unsigned int hash;
+    int font_size;
+    int width;
+    long last_use;
+    int n_glyphs;
+    char text[MAX_UI_TEXT_LENGTH];
+    UiGlyph glyphs[MAX_UI_TEXT_LENGTH];
+} UiText;
+
+static int N_TEXTS;
+static UiText TEXTS[MAX_N_UI_TEXTS];
+static long N_USES;
+static long N_LAYOUTS;
+
+static const UiText *get_ui_text(const char *text, int font_size);
+static void layout_ui_text(UiText *ui_text);
+static unsigned int get_text_hash(const char *text, int *length);
+
+int measure_ui_text(const char *text, int font_size) {
+    const UiText *ui_text = get_ui_text(text, font_size);
+    return ui_text ? ui_text->width : MeasureText(text, font_size);
+}
+
+void draw_ui_text(const char *text, Vector2 position, int font_size, Color color) {
+    const UiText *ui_text = get_ui_text(text, font_size);
+    if (ui_text == NULL) {
+        DrawText(text, position.x, position.y, font_size, color);
+        count_batch_draw(GetFontDefault().texture.id);
+        return;
+    }
+    if (ui_text->n_glyphs == 0) return;
+
+    // Vertices in the order of DrawTexturePro
+    unsigned int texture_id = GetFontDefault().texture.id;
+    if (rlCheckRenderBatchLimit(4 * ui_text->n_glyphs)) count_batch_flush();
+    count_batch_draw(texture_id);
+    rlSetTexture(texture_id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    rlNormal3f(0.0, 0.0, 1.0);
+    for (int i = 0; i < ui_text->n_glyphs; ++i) {
+        Rectangle dst = ui_text->glyphs[i].dst;
+        Rectangle uv = ui_text->glyphs[i].uv;
+        float x0 = (int)position.x + dst.x;
+        float y0 = (int)position.y + dst.y;
+        float x1 = x0 + dst.width;
+        float y1 = y0 + dst.height;
+
+        rlTexCoord2f(uv.x, uv.y);
+        rlVertex2f(x0, y0);
+        rlTexCoord2f(uv.x, uv.y + uv.height);
+        rlVertex2f(x0, y1);
+        rlTexCoord2f(uv.x + uv.width, uv.y + uv.height);
+        rlVertex2f(x1, y1);
+        rlTexCoord2f(uv.x + uv.width, uv.y);
+        rlVertex2f(x1, y0);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void draw_ui_texture_quads(
+    Texture2D texture, const Rectangle *dsts, int n_dsts, Color color
+) {
+    if (n_dsts == 0) return;
+
+    if (rlCheckRenderBatchLimit(4 * n_dsts)) count_batch_flush();
+    count_batch_draw(texture.id);
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    rlNormal3f(0.0, 0.0, 1.0);
+    for (int i = 0; i < n_dsts; ++i) {
+        Rectangle dst = dsts[i];
+        rlTexCoord2f(0.0, 0.0);
+        rlVertex2f(dst.x, dst.y);
+        rlTexCoord2f(0.0, 1.0);
+        rlVertex2f(dst.x, dst.y + dst.height);
+        rlTexCoord2f(1.0, 1.0);
+        rlVertex2f(dst.x + dst.width, dst.y + dst.height);
+        rlTexCoord2f(1.0, 0.0);
+        rlVertex2f(dst.x + dst.width, dst.y);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+UiTextStats get_ui_text_stats(void) {
+    UiTextStats stats = {0};
+    stats.n_texts = N_TEXTS;
+    stats.n_layouts = N_LAYOUTS;
+    stats.n_hits = N_USES - N_LAYOUTS;
+    return stats;
+}
+
+// Returns NULL for the strings which can't be cached
+static const UiText *get_ui_text(const char *text, int font_size) {
+    int length;
+    unsigned int hash = get_text_hash(text, &length);
+    if (length >= MAX_UI_TEXT_LENGTH || strchr(text, '\n')) return NULL;
+    if (GetFontDefault().texture.id == 0) return NULL;
+
+    N_USES += 1;
+    UiText *oldest = &TEXTS[0];
+    for (int i = 0; i < N_TEXTS; ++i) {
+        UiText *ui_text = &TEXTS[i];
+        bool is_hit = ui_text->hash == hash && ui_text->font_size == font_size
+                      && strcmp(ui_text->text, text) == 0;
+        if (is_hit) {
+            ui_text->last_use = N_USES;
+            return ui_text;
+        }
+        if (ui_text->last_use < oldest->last_use) oldest = ui_text;
+    }
+
+    UiText *ui_text = N_TEXTS < MAX_N_UI_TEXTS ? &TEXTS[N_TEXTS++] : oldest;
+    ui_text->hash = hash;
+    ui_text->font_size = font_size;
+    ui_text->last_use = N_USES;
+    memcpy(ui_text->text, text, length + 1);
+    layout_ui_text(ui_text);
+    N_LAYOUTS += 1;
+    return ui_text;
+}
+
+// The glyph placement of DrawTextEx and the width of MeasureTextEx, with the
+// font size and the spacing which DrawText and MeasureText pass to them
+static void layout_ui_text(UiText *ui_text) {
+    Font font = GetFontDefault();
+    int font_size = ui_text->font_size;
+    if (font_size < DEFAULT_FONT_SIZE) font_size = DEFAULT_FONT_SIZE;
+    float spacing = font_size / DEFAULT_FONT_SIZE;
+    float scale = (float)font_size / font.baseSize;
+    float pad = font.glyphPadding;
+
+    int n_glyphs = 0;
+    int n_codepoints = 0;
+    float offset = 0.0;
+    float width = 0.0;
+    const char *text = ui_text->text;
+    for (int i = 0; text[i] != '\0';) {
+        int codepoint_size = 0;
+        int codepoint = GetCodepointNext(&text[i], &codepoint_size);
+        int index = GetGlyphIndex(font, codepoint);
+        GlyphInfo glyph = font.glyphs[index];
+        Rectangle rec = font.recs[index];
+        i += codepoint_size;
+        n_codepoints += 1;
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            UiGlyph *ui_glyph = &ui_text->glyphs[n_glyphs++];
+            ui_glyph->dst = (Rectangle){
+                offset + (glyph.offsetX - pad) * scale,
+                (glyph.offsetY - pad) * scale,
+                (rec.width + 2.0 * pad) * scale,
+                (rec.height + 2.0 * pad) * scale};
+            ui_glyph->uv = (Rectangle){
+                (rec.x - pad) / font.texture.width,
+                (rec.y - pad) / font.texture.height,
+                (rec.width + 2.0 * pad) / font.texture.width,
+                (rec.height + 2.0 * pad) / font.texture.height};
+        }
+
+        float advance = glyph.advanceX != 0 ? glyph.advanceX : rec.width + glyph.offsetX;
+        float draw_advance = glyph.advanceX != 0 ? glyph.advanceX : rec.width;
+        width += advance;
+        offset += draw_advance * scale + spacing;
+    }
+
+    ui_text->n_glyphs = n_glyphs;
+    ui_text->width = n_codepoints > 0 ? width * scale + (n_codepoints - 1) * spacing : 0;
+}
+
+// FNV-1a
+static unsigned int get_text_hash(const char *text, int *length) {
+    unsigned int hash = 2166136261u;
+    int i = 0;
+    for (; text[i] != '\0'; ++i) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    *length = i;
+    return hash;
+}
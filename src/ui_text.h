@@ -0,0 +1,31 @@
+#pragma once
+
+#include "raylib.h"
+
+// Retained text of the default font. The glyph quads of a string are laid out
+// once per string and font size and kept until the string is the least
+// recently used one of a full cache, so the static UI strings are measured and
+// laid out only when they change. Drawing submits the cached quads straight to
+// the rlgl batch: the text and the shapes share the font texture, so the UI
+// stays in one draw call until a different texture is drawn.
+//
+// Same metrics as MeasureText and DrawText, single line only. Longer strings
+// fall back to them
+#define MAX_N_UI_TEXTS 64
+#define MAX_UI_TEXT_LENGTH 128
+
+typedef struct UiTextStats {
+    int n_texts;
+    long n_layouts;
+    long n_hits;
+} UiTextStats;
+
+int measure_ui_text(const char *text, int font_size);
+void draw_ui_text(const char *text, Vector2 position, int font_size, Color color);
+
+// Quads of the whole texture, in one batch
+void draw_ui_texture_quads(
+    Texture2D texture, const Rectangle *dsts, int n_dsts, Color color
+);
+
+UiTextStats get_ui_text_stats(void);